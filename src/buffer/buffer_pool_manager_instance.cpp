@@ -12,6 +12,9 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <memory>
+#include <string>
+
 #include "common/exception.h"
 #include "common/macros.h"
 
@@ -19,11 +22,39 @@ namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
                                                      LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, DiskScheduler *disk_scheduler)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      next_page_id_(static_cast<page_id_t>(instance_index)),
+      disk_manager_(disk_manager),
+      disk_scheduler_(disk_scheduler != nullptr ? disk_scheduler : new DiskScheduler(disk_manager)),
+      owns_disk_scheduler_(disk_scheduler == nullptr),
+      read_only_(disk_manager->IsReadOnly()),
+      log_manager_(log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 0.");
+  // The pages of an earlier run of the db file are still in use: allocate from the first page of this instance after
+  // them, and hand out their deallocated pages from the free pages instead.
+  auto num_pages = static_cast<uint32_t>(disk_manager->GetNumPages());
+  next_page_id_ = static_cast<page_id_t>(num_pages + (instance_index + num_instances - num_pages % num_instances) %
+                                                         num_instances);
   // we allocate a consecutive memory space for the buffer pool
+  frame_arena_ = new FrameArena(pool_size_, frame_memory, frame_numa_policy, frame_numa_nodes);
   pages_ = new Page[pool_size_];
-  page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
+  for (size_t i = 0; i < pool_size_; ++i) {
+    pages_[i].data_ = frame_arena_->GetFrame(static_cast<frame_id_t>(i));
+  }
+  page_table_ = new PageTable(pool_size_);
   replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  io_in_progress_ = new std::atomic<bool>[pool_size_]();
+  io_cv_ = new std::condition_variable[pool_size_];
 
   // Initially, every page is in the free list.
   for (size_t i = 0; i < pool_size_; ++i) {
@@ -32,134 +63,662 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManag
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  StopPageCleaner();
+  if (owns_disk_scheduler_) {
+    delete disk_scheduler_;
+  }
   delete[] pages_;
+  delete frame_arena_;
   delete page_table_;
   delete replacer_;
+  delete[] io_in_progress_;
+  delete[] io_cv_;
 }
 
-auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
-  frame_id_t fid = -1;
+auto BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id, page_id_t *victim_page_id, bool allow_dirty_victim)
+    -> bool {
+  *victim_page_id = INVALID_PAGE_ID;
   if (!free_list_.empty()) {
-    fid = free_list_.front();
+    *frame_id = free_list_.front();
     free_list_.pop_front();
-  } else if (replacer_->Evict(&fid)) {
-    if (pages_[fid].is_dirty_) {
-      disk_manager_->WritePage(pages_[fid].GetPageId(), pages_[fid].GetData());
+    DetachView(*frame_id);
+    return true;
+  }
+  while (replacer_->Evict(frame_id)) {
+    Page &victim = pages_[*frame_id];
+    bool dirty = false;
+    bool reclaimed = page_table_->RemoveIf(victim.GetPageId(), [&](frame_id_t fid) {
+      if (victim.pin_count_ > 0 || (victim.is_dirty_ && !allow_dirty_victim)) {
+        // A hit pinned the frame after the replacer chose it, or the caller cannot write the victim back. Track the
+        // frame again (a hit through a strategy does not record an access), so that it can be evicted later.
+        if (replacer_->GetAccessCount(fid) == 0) {
+          replacer_->RecordAccess(fid);
+        }
+        replacer_->SetEvictable(fid, victim.pin_count_ == 0);
+        return false;
+      }
+      // A hit that came and went since Evict() may have put the frame back into the replacer.
+      replacer_->Remove(fid);
+      dirty = victim.is_dirty_;
+      return true;
+    });
+    if (!reclaimed) {
+      if (!allow_dirty_victim) {
+        return false;
+      }
+      continue;
     }
-    page_table_->Remove(pages_[fid].GetPageId());
-  } else {
-    page_id = nullptr;
+    if (dirty) {
+      *victim_page_id = victim.GetPageId();
+      writeback_pages_.insert(*victim_page_id);
+      ++foreground_writes_;
+      WakePageCleaner();
+    }
+    DetachView(*frame_id);
+    return true;
+  }
+  return false;
+}
+
+auto BufferPoolManagerInstance::PinResident(page_id_t page_id, bool record_access, frame_id_t *frame_id) -> bool {
+  return page_table_->Apply(page_id, [&](frame_id_t fid) {
+    *frame_id = fid;
+    ++pages_[fid].pin_count_;
+    if (record_access) {
+      replacer_->RecordAccess(fid);
+    }
+    replacer_->SetEvictable(fid, false);
+  });
+}
+
+void BufferPoolManagerInstance::WaitForIo(frame_id_t frame_id) {
+  if (io_in_progress_[frame_id]) {
+    std::unique_lock<std::mutex> lock(latch_);
+    io_cv_[frame_id].wait(lock, [&] { return !io_in_progress_[frame_id]; });
+  }
+}
+
+void BufferPoolManagerInstance::FinishIo(frame_id_t frame_id, page_id_t victim_page_id) {
+  io_in_progress_[frame_id] = false;
+  io_cv_[frame_id].notify_all();
+  if (victim_page_id != INVALID_PAGE_ID) {
+    writeback_pages_.erase(victim_page_id);
+    writeback_cv_.notify_all();
+  }
+}
+
+void BufferPoolManagerInstance::DropFailedRead(frame_id_t frame_id, page_id_t page_id) {
+  page_table_->Remove(page_id);
+  pages_[frame_id].page_id_ = INVALID_PAGE_ID;
+  pages_[frame_id].ResetMemory();
+}
+
+void BufferPoolManagerInstance::ReleaseFailedPin(frame_id_t frame_id) {
+  auto page_id = pages_[frame_id].GetPageId();
+  if (page_id != INVALID_PAGE_ID) {
+    // RestoreVictim() gave the frame back to its victim, which is in the page table again. Hits on the victim pin the
+    // frame under its stripe latch only, so drop this pin under that latch too.
+    page_table_->Apply(page_id, [&](frame_id_t fid) {
+      if (--pages_[fid].pin_count_ == 0) {
+        replacer_->SetEvictable(fid, true);
+      }
+    });
+    return;
+  }
+  // The frame is out of the page table, so only the fetchers of the failed read still touch it, all under latch_.
+  if (--pages_[frame_id].pin_count_ == 0) {
+    replacer_->SetEvictable(frame_id, true);
+    replacer_->Remove(frame_id);
+    free_list_.emplace_back(frame_id);
+  }
+}
+
+void BufferPoolManagerInstance::RestoreVictim(frame_id_t frame_id, page_id_t page_id, page_id_t victim_page_id) {
+  page_table_->Remove(page_id);
+  pages_[frame_id].page_id_ = victim_page_id;
+  pages_[frame_id].is_dirty_ = true;
+  // Settle the pin count before the victim is visible to hits again, which pin it without latch_.
+  --pages_[frame_id].pin_count_;
+  replacer_->SetEvictable(frame_id, pages_[frame_id].pin_count_ == 0);
+  page_table_->Insert(victim_page_id, frame_id);
+  FinishIo(frame_id, victim_page_id);
+}
+
+auto BufferPoolManagerInstance::ScheduleIo(bool is_write, page_id_t page_id, char *data) -> std::future<bool> {
+  auto promise = disk_scheduler_->CreatePromise();
+  auto future = promise.get_future();
+  disk_scheduler_->Schedule({is_write, data, page_id, std::move(promise)});
+  return future;
+}
+
+auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
+  if (read_only_) {
+    return nullptr;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  frame_id_t fid = -1;
+  page_id_t victim_page_id = INVALID_PAGE_ID;
+  if (!AcquireFrame(&fid, &victim_page_id)) {
     return nullptr;
   }
+  *page_id = AllocatePage();
   pages_[fid].is_dirty_ = false;
   pages_[fid].pin_count_ = 1;
-  *page_id = AllocatePage();
   pages_[fid].page_id_ = *page_id;
-  pages_[fid].ResetMemory();
   replacer_->RecordAccess(fid);
   replacer_->SetEvictable(fid, false);
+  if (victim_page_id == INVALID_PAGE_ID) {
+    pages_[fid].ResetMemory();
+    page_table_->Insert(*page_id, fid);
+    return &pages_[fid];
+  }
+
+  // The frame still holds the dirty victim: write it back without blocking the rest of the pool.
+  io_in_progress_[fid] = true;
   page_table_->Insert(*page_id, fid);
+  lock.unlock();
+  try {
+    disk_manager_->WritePage(victim_page_id, pages_[fid].GetData());
+  } catch (const Exception &e) {
+    // The frame holds the only current copy of the victim: keep it instead of the new page.
+    lock.lock();
+    RestoreVictim(fid, *page_id, victim_page_id);
+    DeallocatePage(*page_id);
+    throw;
+  }
+  pages_[fid].ResetMemory();
+  lock.lock();
+  FinishIo(fid, victim_page_id);
   return &pages_[fid];
 }
 
-auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  std::scoped_lock<std::mutex> lock(latch_);
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * { return FetchPgImp(page_id, nullptr); }
+
+auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
   if (page_id == INVALID_PAGE_ID) {
     return nullptr;
   }
   frame_id_t fid = -1;
-  if (page_table_->Find(page_id, fid)) {
-    ++pages_[fid].pin_count_;
-    replacer_->RecordAccess(fid);
-    replacer_->SetEvictable(fid, false);
-    return &pages_[fid];
+  // A hit only latches the page table stripe of the page.
+  if (PinResident(page_id, strategy == nullptr, &fid)) {
+    ++fetch_hits_;
+    if (strategy != nullptr) {
+      ++strategy->hits_;
+    }
+    // Another thread may still be reading this page in.
+    WaitForIo(fid);
+    if (pages_[fid].GetPageId() == page_id) {
+      return &pages_[fid];
+    }
+    // The read failed. Try it again, so that this fetch gets the error first hand if the page is still unreadable.
+    {
+      std::scoped_lock<std::mutex> lock(latch_);
+      ReleaseFailedPin(fid);
+    }
+    return FetchPgImp(page_id, strategy);
   }
-  if (!free_list_.empty()) {
-    fid = free_list_.front();
-    free_list_.pop_front();
-  } else if (replacer_->Evict(&fid)) {
-    if (pages_[fid].is_dirty_) {
-      disk_manager_->WritePage(pages_[fid].GetPageId(), pages_[fid].GetData());
+
+  std::unique_lock<std::mutex> lock(latch_);
+  while (true) {
+    // Check again: another thread may have read the page in while this one waited for latch_.
+    if (PinResident(page_id, strategy == nullptr, &fid)) {
+      ++fetch_hits_;
+      if (strategy != nullptr) {
+        ++strategy->hits_;
+      }
+      io_cv_[fid].wait(lock, [&] { return !io_in_progress_[fid]; });
+      if (pages_[fid].GetPageId() == page_id) {
+        return &pages_[fid];
+      }
+      // The read failed; try it again.
+      ReleaseFailedPin(fid);
+      continue;
     }
-    page_table_->Remove(pages_[fid].GetPageId());
-  } else {
+    if (writeback_pages_.count(page_id) == 0) {
+      break;
+    }
+    // The page was just evicted and its write-back has not landed yet, so the disk copy is stale.
+    writeback_cv_.wait(lock);
+  }
+
+  page_id_t victim_page_id = INVALID_PAGE_ID;
+  if (!AcquireFrame(&fid, &victim_page_id)) {
     return nullptr;
   }
   pages_[fid].is_dirty_ = false;
   pages_[fid].pin_count_ = 1;
   pages_[fid].page_id_ = page_id;
-  pages_[fid].ResetMemory();
-  disk_manager_->ReadPage(page_id, pages_[fid].GetData());
   replacer_->RecordAccess(fid);
   replacer_->SetEvictable(fid, false);
+  if (victim_page_id == INVALID_PAGE_ID) {
+    // Zero-copy: if the disk manager has the page in memory, the frame serves a view of it and nothing is read.
+    auto *view = disk_manager_->GetPageView(page_id);
+    if (view != nullptr) {
+      pages_[fid].data_ = const_cast<char *>(view);
+      page_table_->Insert(page_id, fid);
+      ++fetch_misses_;
+      ++view_fetches_;
+      if (strategy != nullptr) {
+        ++strategy->misses_;
+        lock.unlock();
+        AddToRing(strategy, page_id);
+      }
+      return &pages_[fid];
+    }
+  }
+  // Publish the mapping only once the frame is marked as being read, so that hits on it wait for the read.
+  io_in_progress_[fid] = true;
   page_table_->Insert(page_id, fid);
+  lock.unlock();
+
+  std::exception_ptr read_error;
+  if (victim_page_id == INVALID_PAGE_ID) {
+    pages_[fid].ResetMemory();
+    try {
+      disk_manager_->ReadPage(page_id, pages_[fid].GetData());
+    } catch (const Exception &e) {
+      read_error = std::current_exception();
+    }
+  } else {
+    // Copy the victim out and hand its write-back to the scheduler, so that it is in flight while this thread reads
+    // the new page. The copy is on the heap, as a large page would take too much of the stack.
+    auto victim_data = std::make_unique<char[]>(BUSTUB_PAGE_SIZE);
+    memcpy(victim_data.get(), pages_[fid].GetData(), BUSTUB_PAGE_SIZE);
+    auto write_done = ScheduleIo(true, victim_page_id, victim_data.get());
+    pages_[fid].ResetMemory();
+    try {
+      disk_manager_->ReadPage(page_id, pages_[fid].GetData());
+    } catch (const Exception &e) {
+      read_error = std::current_exception();
+    }
+    if (!write_done.get()) {
+      // The copy is the only current one of the victim: put it back in the frame instead of the page fetched.
+      memcpy(pages_[fid].GetData(), victim_data.get(), BUSTUB_PAGE_SIZE);
+      lock.lock();
+      RestoreVictim(fid, page_id, victim_page_id);
+      throw Exception(ExceptionType::IO, "cannot fetch page " + std::to_string(page_id) + ": writing back page " +
+                                             std::to_string(victim_page_id) + " failed");
+    }
+  }
+
+  lock.lock();
+  if (read_error) {
+    // Keep the page out of the pool, so that the next fetch reads it again.
+    DropFailedRead(fid, page_id);
+    FinishIo(fid, victim_page_id);
+    ReleaseFailedPin(fid);
+    std::rethrow_exception(read_error);
+  }
+  FinishIo(fid, victim_page_id);
+  ++fetch_misses_;
+  if (strategy != nullptr) {
+    ++strategy->misses_;
+    lock.unlock();
+    AddToRing(strategy, page_id);
+  }
   return &pages_[fid];
 }
 
-auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+void BufferPoolManagerInstance::AddToRing(BufferAccessStrategy *strategy, page_id_t page_id) {
+  strategy->ring_.emplace_back(this, page_id);
+  while (strategy->ring_.size() > strategy->ring_size_) {
+    auto [instance, ring_page_id] = strategy->ring_.front();
+    strategy->ring_.pop_front();
+    instance->ReleaseRingPage(ring_page_id);
+  }
+}
+
+void BufferPoolManagerInstance::ReleaseRingPage(page_id_t page_id) {
+  std::unique_lock<std::mutex> lock(latch_);
   frame_id_t fid = -1;
-  if (!page_table_->Find(page_id, fid)) {
-    return false;
+  bool dirty = false;
+  bool released = page_table_->RemoveIf(page_id, [&](frame_id_t frame_id) {
+    // Leave the page alone if it is in use, or if somebody other than the ring has accessed it.
+    if (pages_[frame_id].pin_count_ > 0 || io_in_progress_[frame_id] || replacer_->GetAccessCount(frame_id) > 1) {
+      return false;
+    }
+    fid = frame_id;
+    dirty = pages_[frame_id].is_dirty_;
+    replacer_->Remove(frame_id);
+    return true;
+  });
+  if (!released) {
+    return;
   }
-  if (pages_[fid].pin_count_ > 0) {
-    --pages_[fid].pin_count_;
-    if (pages_[fid].pin_count_ == 0) {
+  if (dirty) {
+    // Same as evicting a dirty victim, except that the frame goes to the free list instead of to a new page.
+    writeback_pages_.insert(page_id);
+    io_in_progress_[fid] = true;
+    ++foreground_writes_;
+    lock.unlock();
+    bool written = true;
+    try {
+      disk_manager_->WritePage(page_id, pages_[fid].GetData());
+    } catch (const Exception &e) {
+      written = false;
+    }
+    lock.lock();
+    if (!written) {
+      // Keep the page, still dirty, rather than lose its only current copy. An eviction tries the write again.
+      page_table_->Insert(page_id, fid);
+      replacer_->RecordAccess(fid);
       replacer_->SetEvictable(fid, true);
+      FinishIo(fid, page_id);
+      return;
     }
-  } else {
-    return false;
+    FinishIo(fid, page_id);
   }
-  if (is_dirty) {
-    pages_[fid].is_dirty_ = is_dirty;
+  pages_[fid].is_dirty_ = false;
+  pages_[fid].page_id_ = INVALID_PAGE_ID;
+  // The next read of the ring's operation takes this frame before any other free frame.
+  free_list_.push_front(fid);
+}
+
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id) { PrefetchPgImp(page_id, nullptr); }
+
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  // Never speculate on pages that have not been allocated yet: a frame for them would clash with a later NewPage.
+  if (page_id == INVALID_PAGE_ID || page_id >= next_page_id_) {
+    return;
+  }
+  // A page the disk manager holds in memory is fetched without I/O anyway.
+  if (disk_manager_->GetPageView(page_id) != nullptr) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(latch_);
+  frame_id_t fid = -1;
+  if (page_table_->Find(page_id, &fid) || writeback_pages_.count(page_id) > 0) {
+    return;
+  }
+  if (free_list_.empty()) {
+    // Every eviction happens under latch_, so this is the frame AcquireFrame() will evict, unless a hit pins it first.
+    auto victims = replacer_->GetEvictionCandidates(1);
+    bool dirty = true;
+    if (!victims.empty()) {
+      page_table_->Apply(pages_[victims[0]].GetPageId(),
+                         [&](frame_id_t frame_id) { dirty = pages_[frame_id].is_dirty_; });
+    }
+    if (dirty) {
+      return;
+    }
+  }
+  page_id_t victim_page_id = INVALID_PAGE_ID;
+  if (!AcquireFrame(&fid, &victim_page_id, false)) {
+    return;
+  }
+  pages_[fid].is_dirty_ = false;
+  pages_[fid].pin_count_ = 1;
+  pages_[fid].page_id_ = page_id;
+  replacer_->RecordAccess(fid);
+  replacer_->SetEvictable(fid, false);
+  io_in_progress_[fid] = true;
+  page_table_->Insert(page_id, fid);
+  ++prefetch_reads_;
+  lock.unlock();
+
+  pages_[fid].ResetMemory();
+  disk_scheduler_->Schedule({false, pages_[fid].GetData(), page_id, disk_scheduler_->CreatePromise(),
+                             [this, fid, page_id](bool success) {
+                               // Drop the prefetch pin together with finishing the read, so that whoever waited for
+                               // the read sees the pin count of its own pins only. A failed read is left for the
+                               // fetch that reads the page again to report.
+                               std::scoped_lock<std::mutex> lock(latch_);
+                               if (!success) {
+                                 DropFailedRead(fid, page_id);
+                               }
+                               FinishIo(fid, INVALID_PAGE_ID);
+                               if (success) {
+                                 UnpinPgImp(page_id, false);
+                               } else {
+                                 ReleaseFailedPin(fid);
+                               }
+                             }});
+  if (strategy != nullptr) {
+    AddToRing(strategy, page_id);
   }
-  return true;
+}
+
+auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  bool unpinned = false;
+  page_table_->Apply(page_id, [&](frame_id_t fid) {
+    if (pages_[fid].pin_count_ <= 0) {
+      return;
+    }
+    unpinned = true;
+    if (--pages_[fid].pin_count_ == 0) {
+      replacer_->SetEvictable(fid, true);
+    }
+    // A view is mapped read-only, so nobody can have modified it.
+    if (is_dirty && !IsView(fid)) {
+      pages_[fid].is_dirty_ = true;
+    }
+  });
+  return unpinned;
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
   if (page_id == INVALID_PAGE_ID) {
     return false;
   }
   frame_id_t fid = -1;
-  if (!page_table_->Find(page_id, fid)) {
-    return false;
+  bool is_view = false;
+  // Pin the frame so that it cannot be evicted while it is written. Clear the flag before writing: a writer that
+  // modifies the page from now on will set it again when it unpins.
+  bool found = page_table_->Apply(page_id, [&](frame_id_t frame_id) {
+    if (IsView(frame_id)) {
+      // The page is the db file itself; there is nothing to write.
+      is_view = true;
+      return;
+    }
+    fid = frame_id;
+    ++pages_[fid].pin_count_;
+    replacer_->SetEvictable(fid, false);
+    pages_[fid].is_dirty_ = false;
+  });
+  if (!found || is_view) {
+    return found;
   }
-  disk_manager_->WritePage(page_id, pages_[fid].GetData());
-  pages_[fid].is_dirty_ = false;
+  WaitForIo(fid);
+  try {
+    disk_manager_->WritePage(page_id, pages_[fid].GetData());
+  } catch (const Exception &e) {
+    // The page was not written: mark it dirty again.
+    UnpinPgImp(page_id, true);
+    throw;
+  }
+  UnpinPgImp(page_id, false);
   return true;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  for (size_t i = 0; i < pool_size_; ++i) {
-    FlushPgImp(pages_[i].GetPageId());
+  std::vector<page_id_t> page_ids;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    for (size_t i = 0; i < pool_size_; ++i) {
+      if (pages_[i].GetPageId() != INVALID_PAGE_ID) {
+        page_ids.push_back(pages_[i].GetPageId());
+      }
+    }
+  }
+  for (auto page_id : page_ids) {
+    FlushPgImp(page_id);
   }
+  // a flush of the whole pool is a checkpoint: the batch the sync policy is collecting cannot wait
+  disk_manager_->SyncPages();
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
-  std::scoped_lock<std::mutex> lock(latch_);
+  return TryDeletePgImp(page_id) == DeletePageResult::DELETED;
+}
+
+auto BufferPoolManagerInstance::TryDeletePgImp(page_id_t page_id) -> DeletePageResult {
+  std::unique_lock<std::mutex> lock(latch_);
   if (page_id == INVALID_PAGE_ID) {
-    return true;
+    return DeletePageResult::DELETED;
   }
-  frame_id_t fid = 0;
-  if (!page_table_->Find(page_id, fid)) {
-    return true;
+  if (read_only_) {
+    return DeletePageResult::NOT_ALLOCATED;
   }
-  if (pages_[fid].GetPinCount() != 0) {
-    return false;
+  // An evicted copy of the page may still be on its way to disk. Let it land before the page can be reused.
+  writeback_cv_.wait(lock, [&] { return writeback_pages_.count(page_id) == 0; });
+  if (!IsAllocatedPage(page_id)) {
+    return DeletePageResult::NOT_ALLOCATED;
+  }
+  frame_id_t fid = -1;
+  bool pinned = false;
+  bool deleted = page_table_->RemoveIf(page_id, [&](frame_id_t frame_id) {
+    if (pages_[frame_id].GetPinCount() != 0) {
+      pinned = true;
+      return false;
+    }
+    fid = frame_id;
+    replacer_->Remove(frame_id);
+    return true;
+  });
+  if (!deleted) {
+    if (pinned) {
+      return DeletePageResult::PINNED;
+    }
+    DeallocatePage(page_id);
+    return DeletePageResult::DELETED;
   }
   pages_[fid].is_dirty_ = false;
   pages_[fid].pin_count_ = 0;
   pages_[fid].page_id_ = INVALID_PAGE_ID;
   pages_[fid].ResetMemory();
-  page_table_->Remove(page_id);
-  replacer_->Remove(fid);
   free_list_.emplace_back(fid);
   DeallocatePage(page_id);
-  return true;
+  return DeletePageResult::DELETED;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+void BufferPoolManagerInstance::StartPageCleaner() {
+  std::scoped_lock<std::mutex> lock(page_cleaner_latch_);
+  if (page_cleaner_running_) {
+    return;
+  }
+  page_cleaner_running_ = true;
+  page_cleaner_thread_ = std::thread([this] { RunPageCleaner(); });
+}
+
+void BufferPoolManagerInstance::StopPageCleaner() {
+  {
+    std::scoped_lock<std::mutex> lock(page_cleaner_latch_);
+    if (!page_cleaner_running_) {
+      return;
+    }
+    page_cleaner_running_ = false;
+  }
+  page_cleaner_cv_.notify_all();
+  page_cleaner_thread_.join();
+}
+
+void BufferPoolManagerInstance::WakePageCleaner() {
+  {
+    std::scoped_lock<std::mutex> lock(page_cleaner_latch_);
+    page_cleaner_wakeup_ = true;
+  }
+  page_cleaner_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::RunPageCleaner() {
+  std::unique_lock<std::mutex> lock(page_cleaner_latch_);
+  while (page_cleaner_running_) {
+    page_cleaner_wakeup_ = false;
+    lock.unlock();
+    CleanColdFrames();
+    lock.lock();
+    page_cleaner_cv_.wait_for(lock, page_cleaner_interval,
+                              [&] { return !page_cleaner_running_ || page_cleaner_wakeup_; });
+  }
+}
+
+auto BufferPoolManagerInstance::CleanColdFrames() -> size_t {
+  std::vector<std::pair<frame_id_t, page_id_t>> batch;
+  {
+    std::scoped_lock<std::mutex> lock(latch_);
+    auto target = static_cast<size_t>(static_cast<double>(pool_size_) * page_cleaner_clean_ratio);
+    if (free_list_.size() >= target) {
+      return 0;
+    }
+    for (auto fid : replacer_->GetEvictionCandidates(target - free_list_.size())) {
+      page_id_t page_id = pages_[fid].GetPageId();
+      // Same protocol as FlushPgImp: pin so the frame is not reused during the write, and clear the dirty flag up
+      // front so that a concurrent modification marks it dirty again on unpin.
+      page_table_->Apply(page_id, [&](frame_id_t frame_id) {
+        if (pages_[frame_id].pin_count_ > 0 || !pages_[frame_id].is_dirty_) {
+          return;
+        }
+        ++pages_[frame_id].pin_count_;
+        replacer_->SetEvictable(frame_id, false);
+        pages_[frame_id].is_dirty_ = false;
+        batch.emplace_back(frame_id, page_id);
+      });
+    }
+  }
+  if (batch.empty()) {
+    return 0;
+  }
+
+  std::vector<std::future<bool>> writes;
+  writes.reserve(batch.size());
+  for (auto [fid, page_id] : batch) {
+    writes.push_back(ScheduleIo(true, page_id, pages_[fid].GetData()));
+  }
+  size_t num_written = 0;
+  for (size_t i = 0; i < batch.size(); ++i) {
+    // A page that was not written is marked dirty again, to be written by a later round or its eviction.
+    bool written = writes[i].get();
+    UnpinPgImp(batch[i].second, !written);
+    num_written += written ? 1 : 0;
+  }
+  background_writes_ += num_written;
+  return num_written;
+}
+
+auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
+  // Reuse a deallocated page first, so that the db file only grows when no page is free.
+  std::vector<page_id_t> in_use;
+  auto page_id = disk_manager_->AllocateFreePage(instance_index_, num_instances_);
+  while (page_id != INVALID_PAGE_ID) {
+    // A free page at or above next_page_id_ is handed out from there instead; handing it out now would do it twice.
+    if (page_id >= next_page_id_) {
+      page_id = disk_manager_->AllocateFreePage(instance_index_, num_instances_);
+      continue;
+    }
+    // A stale reader may have fetched the page after it was deleted. Drop that copy so that it cannot shadow the new
+    // page, unless the reader still holds it; then leave the page for a later allocation.
+    bool pinned = false;
+    page_table_->RemoveIf(page_id, [&](frame_id_t fid) {
+      if (pages_[fid].GetPinCount() != 0) {
+        pinned = true;
+        return false;
+      }
+      replacer_->Remove(fid);
+      pages_[fid].is_dirty_ = false;
+      pages_[fid].page_id_ = INVALID_PAGE_ID;
+      pages_[fid].ResetMemory();
+      free_list_.emplace_back(fid);
+      return true;
+    });
+    if (!pinned) {
+      break;
+    }
+    in_use.push_back(page_id);
+    page_id = disk_manager_->AllocateFreePage(instance_index_, num_instances_);
+  }
+  for (auto in_use_page_id : in_use) {
+    disk_manager_->DeallocatePage(in_use_page_id);
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = next_page_id_.fetch_add(static_cast<page_id_t>(num_instances_));
+  }
+  ValidatePageId(page_id);
+  return page_id;
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  BUSTUB_ASSERT(static_cast<uint32_t>(page_id) % num_instances_ == instance_index_,
+                "allocated pages mod back to this BPI");
+}
 
 }  // namespace bustub
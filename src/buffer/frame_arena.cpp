@@ -0,0 +1,116 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.cpp
+//
+// Identification: src/buffer/frame_arena.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_arena.h"
+
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include "common/exception.h"
+#include "common/logger.h"
+
+namespace bustub {
+
+namespace {
+
+/** Number of bits in a NUMA node mask, plus one: the kernel ignores the last bit of maxnode. */
+constexpr unsigned long NUMA_MAX_NODE = 64 + 1;  // NOLINT
+
+auto RoundUp(size_t size, size_t alignment) -> size_t { return (size + alignment - 1) / alignment * alignment; }
+
+}  // namespace
+
+FrameArena::FrameArena(size_t num_frames, FrameMemory memory, FrameNumaPolicy numa_policy, uint64_t numa_nodes)
+    : size_(num_frames * BUSTUB_PAGE_SIZE), memory_(memory) {
+  // every frame is aligned for direct I/O, which transfers straight between the frame and the disk
+  static_assert(BUSTUB_PAGE_SIZE % DIRECT_IO_ALIGNMENT == 0);
+  if (memory_ == FrameMemory::HEAP) {
+    data_ = new (std::align_val_t{DIRECT_IO_ALIGNMENT}) char[size_]();
+    return;
+  }
+
+  mapped_size_ = RoundUp(size_, HUGE_PAGE_SIZE);
+  if (memory_ == FrameMemory::EXPLICIT_HUGE_PAGES) {
+    data_ = Map(MAP_HUGETLB, 0);
+    if (data_ == nullptr) {
+      LOG_WARN("no explicit huge pages available for %zu bytes, falling back to transparent huge pages", mapped_size_);
+      memory_ = FrameMemory::TRANSPARENT_HUGE_PAGES;
+    }
+  }
+  if (memory_ == FrameMemory::TRANSPARENT_HUGE_PAGES) {
+    data_ = Map(0, HUGE_PAGE_SIZE);
+    if (data_ != nullptr && madvise(data_, mapped_size_, MADV_HUGEPAGE) != 0) {
+      LOG_WARN("transparent huge pages are not supported: %s", strerror(errno));
+      memory_ = FrameMemory::MMAP;
+    }
+  }
+  if (memory_ == FrameMemory::MMAP) {
+    data_ = data_ != nullptr ? data_ : Map(0, 0);
+  }
+  if (data_ == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot map " + std::to_string(mapped_size_) + " bytes of frames");
+  }
+  if (numa_policy != FrameNumaPolicy::DEFAULT) {
+    ApplyNumaPolicy(numa_policy, numa_nodes);
+  }
+}
+
+FrameArena::~FrameArena() {
+  if (memory_ == FrameMemory::HEAP) {
+    operator delete[](data_, std::align_val_t{DIRECT_IO_ALIGNMENT});
+  } else {
+    munmap(data_, mapped_size_);
+  }
+}
+
+auto FrameArena::Map(int extra_flags, size_t alignment) -> char * {
+  // Over-allocate by one alignment unit, then unmap the unaligned head and the tail.
+  size_t length = mapped_size_ + alignment;
+  void *region = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+  if (region == MAP_FAILED) {
+    return nullptr;
+  }
+  if (alignment == 0) {
+    return static_cast<char *>(region);
+  }
+  auto start = reinterpret_cast<uintptr_t>(region);
+  auto aligned = RoundUp(start, alignment);
+  if (aligned > start) {
+    munmap(region, aligned - start);
+  }
+  if (start + length > aligned + mapped_size_) {
+    munmap(reinterpret_cast<void *>(aligned + mapped_size_), start + length - aligned - mapped_size_);
+  }
+  return reinterpret_cast<char *>(aligned);
+}
+
+void FrameArena::ApplyNumaPolicy(FrameNumaPolicy numa_policy, uint64_t numa_nodes) {
+  // Use the raw system calls, so that bustub does not depend on libnuma.
+  if (numa_nodes == 0 &&
+      syscall(SYS_get_mempolicy, nullptr, &numa_nodes, NUMA_MAX_NODE, nullptr, MPOL_F_MEMS_ALLOWED) != 0) {
+    LOG_WARN("cannot read the allowed NUMA nodes: %s", strerror(errno));
+    return;
+  }
+  int mode = numa_policy == FrameNumaPolicy::INTERLEAVE ? MPOL_INTERLEAVE : MPOL_BIND;
+  if (syscall(SYS_mbind, data_, mapped_size_, mode, &numa_nodes, NUMA_MAX_NODE, 0) != 0) {
+    LOG_WARN("cannot apply NUMA policy to the buffer pool frames: %s", strerror(errno));
+  }
+}
+
+}  // namespace bustub
@@ -12,57 +12,40 @@
 
 #include "buffer/lru_k_replacer.h"
 
+#include <algorithm>
+
 namespace bustub {
 
 LRUKReplacer::LRUKReplacer(size_t num_frames, const size_t &k)
-    : replacer_size_(num_frames),
-      k_(k),
-      head0_(new Info),
-      head1_(new Info),
-      dir0_(num_frames, nullptr),
-      dir1_(num_frames, nullptr) {
-  head0_->pre_ = head0_;
-  head0_->nxt_ = head0_;
-  head1_->pre_ = head1_;
-  head1_->nxt_ = head1_;
+    : replacer_size_(num_frames), k_(k), node_store_(num_frames), access_history_(num_frames * k) {
+  BUSTUB_ASSERT(k_ > 0, "k must be positive");
+}
+
+auto LRUKReplacer::GetEvictionKey(frame_id_t frame_id) const -> EvictionKey {
+  const auto &node = node_store_[frame_id];
+  const size_t *history = &access_history_[frame_id * k_];
+  if (node.num_accesses_ < k_) {
+    return {history[0], frame_id};
+  }
+  // The oldest of the last k accesses sits right after the newest one in the circular buffer.
+  return {history[node.num_accesses_ % k_], frame_id};
+}
+
+auto LRUKReplacer::GetEvictableSet(frame_id_t frame_id) -> std::set<EvictionKey> & {
+  return node_store_[frame_id].num_accesses_ < k_ ? history_ : cache_;
 }
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
   std::scoped_lock<std::mutex> lock(latch_);
-  if (curr_size_ == 0) {
+  auto &victims = history_.empty() ? cache_ : history_;
+  if (victims.empty()) {
     return false;
   }
-  if (siz0_ > 0) {
-    auto p = head0_;
-    while (p->nxt_ != head0_) {
-      p = p->nxt_;
-      if (p->unpin_) {
-        BUSTUB_ASSERT(p->frame_id_ >= 0, "Wrong frame id");
-        p->pre_->nxt_ = p->nxt_;
-        p->nxt_->pre_ = p->pre_;
-        *frame_id = p->frame_id_;
-        --curr_size_;
-        --siz0_;
-        dir0_[*frame_id] = nullptr;
-        return true;
-      }
-    }
-  }
-  auto p = head1_;
-  while (p->nxt_ != head1_) {
-    p = p->nxt_;
-    if (p->unpin_) {
-      BUSTUB_ASSERT(p->frame_id_ >= 0, "Wrong frame id");
-      p->pre_->nxt_ = p->nxt_;
-      p->nxt_->pre_ = p->pre_;
-      *frame_id = p->frame_id_;
-      --curr_size_;
-      --siz1_;
-      dir1_[*frame_id] = nullptr;
-      return true;
-    }
-  }
-  return false;
+  *frame_id = victims.begin()->second;
+  victims.erase(victims.begin());
+  node_store_[*frame_id] = LRUKNode();
+  --curr_size_;
+  return true;
 }
 
 void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
@@ -70,115 +53,71 @@ void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
   std::scoped_lock<std::mutex> lock(latch_);
   ++current_timestamp_;
 
-  if (dir1_[frame_id] != nullptr) {
-    auto p = dir1_[frame_id];
-    p->record_.emplace_back(current_timestamp_);
-    p->record_.pop_front();
-    p->pre_->nxt_ = p->nxt_;
-    p->nxt_->pre_ = p->pre_;
-
-    p->pre_ = head1_->pre_;
-    p->nxt_ = head1_;
-    head1_->pre_->nxt_ = p.get();
-    head1_->pre_ = p.get();
-  } else if (dir0_[frame_id] != nullptr) {
-    auto p = dir0_[frame_id];
-    p->record_.emplace_back(current_timestamp_);
-    if (p->record_.size() == k_) {
-      siz0_ -= static_cast<size_t>(p->unpin_);
-      siz1_ += static_cast<size_t>(p->unpin_);
-      p->pre_->nxt_ = p->nxt_;
-      p->nxt_->pre_ = p->pre_;
-
-      p->pre_ = head1_->pre_;
-      p->nxt_ = head1_;
-      head1_->pre_->nxt_ = p.get();
-      head1_->pre_ = p.get();
-      std::swap(dir0_[frame_id], dir1_[frame_id]);
-    }
-  } else {
-    auto p = std::make_shared<LRUKReplacer::Info>();
-    if (k_ == 1) {
-      p->pre_ = head1_->pre_;
-      p->nxt_ = head1_;
-      head1_->pre_->nxt_ = p.get();
-      head1_->pre_ = p.get();
-      p->frame_id_ = frame_id;
-      p->record_.emplace_back(current_timestamp_);
-      ++siz1_;
-      dir1_[frame_id] = p;
-    } else {
-      p->pre_ = head0_->pre_;
-      p->nxt_ = head0_;
-      head0_->pre_->nxt_ = p.get();
-      head0_->pre_ = p.get();
-      p->frame_id_ = frame_id;
-      p->record_.emplace_back(current_timestamp_);
-      ++siz0_;
-      dir0_[frame_id] = p;
-    }
-    ++curr_size_;
+  auto &node = node_store_[frame_id];
+  if (node.num_accesses_ == 0) {
+    curr_size_ += static_cast<size_t>(node.is_evictable_);
+  } else if (node.is_evictable_) {
+    GetEvictableSet(frame_id).erase(GetEvictionKey(frame_id));
+  }
+  access_history_[frame_id * k_ + node.num_accesses_ % k_] = current_timestamp_;
+  ++node.num_accesses_;
+  if (node.is_evictable_) {
+    GetEvictableSet(frame_id).insert(GetEvictionKey(frame_id));
   }
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
   BUSTUB_ASSERT(frame_id >= 0 && frame_id < static_cast<int>(replacer_size_), "Invalid frame_id_t in SetEvictable!");
   std::scoped_lock<std::mutex> lock(latch_);
-  if (dir0_[frame_id] != nullptr) {
-    auto p = dir0_[frame_id];
-    if (p->unpin_ ^ set_evictable) {
-      p->unpin_ = set_evictable;
-      siz0_ += set_evictable ? 1 : -1;
-      curr_size_ += set_evictable ? 1 : -1;
-    }
-  } else if (dir1_[frame_id] != nullptr) {
-    auto p = dir1_[frame_id];
-    if (p->unpin_ ^ set_evictable) {
-      p->unpin_ = set_evictable;
-      siz1_ += set_evictable ? 1 : -1;
-      curr_size_ += set_evictable ? 1 : -1;
-    }
+  auto &node = node_store_[frame_id];
+  if (node.num_accesses_ == 0 || node.is_evictable_ == set_evictable) {
+    return;
+  }
+  node.is_evictable_ = set_evictable;
+  if (set_evictable) {
+    GetEvictableSet(frame_id).insert(GetEvictionKey(frame_id));
+    ++curr_size_;
+  } else {
+    GetEvictableSet(frame_id).erase(GetEvictionKey(frame_id));
+    --curr_size_;
   }
 }
 
 void LRUKReplacer::Remove(frame_id_t frame_id) {
   BUSTUB_ASSERT(frame_id >= 0 && frame_id < static_cast<int>(replacer_size_), "Invalid frame_id_t in Remove!");
   std::scoped_lock<std::mutex> lock(latch_);
-  if (dir0_[frame_id] == nullptr) {
-    if (dir1_[frame_id] == nullptr) {
-      return;
-    }
-    if (dir1_[frame_id]->unpin_) {
-      auto p = dir1_[frame_id];
-      p->pre_->nxt_ = p->nxt_;
-      p->nxt_->pre_ = p->pre_;
-      dir1_[frame_id] = nullptr;
-      --siz1_;
-      --curr_size_;
-      return;
-    }
-    BUSTUB_ASSERT(0, "Cannot remove a non-evictable frame!");
-  } else {
-    if (dir0_[frame_id]->unpin_) {
-      auto p = dir0_[frame_id];
-      p->pre_->nxt_ = p->nxt_;
-      p->nxt_->pre_ = p->pre_;
-      dir0_[frame_id] = nullptr;
-      --siz0_;
-      --curr_size_;
-      return;
+  auto &node = node_store_[frame_id];
+  if (node.num_accesses_ == 0) {
+    return;
+  }
+  BUSTUB_ASSERT(node.is_evictable_, "Cannot remove a non-evictable frame!");
+  GetEvictableSet(frame_id).erase(GetEvictionKey(frame_id));
+  node = LRUKNode();
+  --curr_size_;
+}
+
+auto LRUKReplacer::GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t> {
+  std::scoped_lock<std::mutex> lock(latch_);
+  std::vector<frame_id_t> candidates;
+  for (const auto *victims : {&history_, &cache_}) {
+    for (auto it = victims->begin(); it != victims->end() && candidates.size() < max_frames; ++it) {
+      candidates.push_back(it->second);
     }
-    BUSTUB_ASSERT(0, "Cannot remove a non-evictable frame!");
   }
+  return candidates;
+}
+
+auto LRUKReplacer::GetAccessCount(frame_id_t frame_id) -> size_t {
+  BUSTUB_ASSERT(frame_id >= 0 && frame_id < static_cast<int>(replacer_size_), "Invalid frame_id_t in GetAccessCount!");
+  std::scoped_lock<std::mutex> lock(latch_);
+  return std::min(node_store_[frame_id].num_accesses_, k_);
 }
 
 auto LRUKReplacer::Size() -> size_t {
   std::scoped_lock<std::mutex> lock(latch_);
   return curr_size_;
 }
-LRUKReplacer::~LRUKReplacer() {
-  delete head0_;
-  delete head1_;
-}
+
+LRUKReplacer::~LRUKReplacer() = default;
 
 }  // namespace bustub
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.cpp
+//
+// Identification: src/buffer/page_table.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/page_table.h"
+
+#include <utility>
+
+namespace bustub {
+
+PageTable::PageTable(size_t expected_entries, size_t num_stripes) {
+  while ((static_cast<size_t>(1) << stripe_bits_) < num_stripes) {
+    ++stripe_bits_;
+  }
+  stripes_ = std::vector<Stripe>(static_cast<size_t>(1) << stripe_bits_);
+  // Start each stripe at most half full if the entries spread evenly; Insert() grows the unlucky ones.
+  size_t capacity_bits = 3;
+  while ((static_cast<size_t>(1) << capacity_bits) * stripes_.size() < 2 * expected_entries) {
+    ++capacity_bits;
+  }
+  for (auto &stripe : stripes_) {
+    stripe.capacity_bits_ = capacity_bits;
+    stripe.slots_.resize(static_cast<size_t>(1) << capacity_bits);
+  }
+}
+
+auto PageTable::Find(page_id_t page_id, frame_id_t *frame_id) -> bool {
+  return Apply(page_id, [&](frame_id_t fid) { *frame_id = fid; });
+}
+
+void PageTable::Insert(page_id_t page_id, frame_id_t frame_id) {
+  BUSTUB_ASSERT(page_id != INVALID_PAGE_ID, "cannot map the invalid page id");
+  Stripe &stripe = GetStripe(page_id);
+  std::scoped_lock<std::mutex> lock(stripe.latch_);
+  if (size_t slot = FindSlot(stripe, page_id); slot != NOT_FOUND) {
+    stripe.slots_[slot].frame_id_ = frame_id;
+    return;
+  }
+  if (2 * (stripe.size_ + 1) > stripe.slots_.size()) {
+    Grow(stripe);
+  }
+  size_t mask = stripe.slots_.size() - 1;
+  size_t slot = HomeSlot(stripe, page_id);
+  while (stripe.slots_[slot].page_id_ != INVALID_PAGE_ID) {
+    slot = (slot + 1) & mask;
+  }
+  stripe.slots_[slot] = {page_id, frame_id};
+  ++stripe.size_;
+}
+
+auto PageTable::FindSlot(const Stripe &stripe, page_id_t page_id) const -> size_t {
+  size_t mask = stripe.slots_.size() - 1;
+  // The table is never more than half full, so the probe always reaches an empty slot.
+  for (size_t slot = HomeSlot(stripe, page_id);; slot = (slot + 1) & mask) {
+    if (stripe.slots_[slot].page_id_ == page_id) {
+      return slot;
+    }
+    if (stripe.slots_[slot].page_id_ == INVALID_PAGE_ID) {
+      return NOT_FOUND;
+    }
+  }
+}
+
+void PageTable::EraseSlot(Stripe &stripe, size_t slot) {
+  size_t mask = stripe.slots_.size() - 1;
+  size_t hole = slot;
+  for (size_t next = (hole + 1) & mask; stripe.slots_[next].page_id_ != INVALID_PAGE_ID; next = (next + 1) & mask) {
+    // An entry may move back into the hole only if its home slot does not lie cyclically in (hole, next].
+    size_t home = HomeSlot(stripe, stripe.slots_[next].page_id_);
+    bool home_after_hole = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+    if (!home_after_hole) {
+      stripe.slots_[hole] = stripe.slots_[next];
+      hole = next;
+    }
+  }
+  stripe.slots_[hole] = Slot();
+  --stripe.size_;
+}
+
+void PageTable::Grow(Stripe &stripe) {
+  std::vector<Slot> old_slots(static_cast<size_t>(1) << (stripe.capacity_bits_ + 1));
+  std::swap(old_slots, stripe.slots_);
+  ++stripe.capacity_bits_;
+  size_t mask = stripe.slots_.size() - 1;
+  for (const auto &entry : old_slots) {
+    if (entry.page_id_ == INVALID_PAGE_ID) {
+      continue;
+    }
+    size_t slot = HomeSlot(stripe, entry.page_id_);
+    while (stripe.slots_[slot].page_id_ != INVALID_PAGE_ID) {
+      slot = (slot + 1) & mask;
+    }
+    stripe.slots_[slot] = entry;
+  }
+}
+
+}  // namespace bustub
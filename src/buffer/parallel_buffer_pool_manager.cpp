@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager)
+    : num_instances_(num_instances), pool_size_(pool_size), disk_scheduler_(new DiskScheduler(disk_manager)) {
+  BUSTUB_ASSERT(num_instances_ > 0, "a parallel buffer pool needs at least one instance");
+  instances_.reserve(num_instances_);
+  for (size_t i = 0; i < num_instances_; ++i) {
+    instances_.push_back(new BufferPoolManagerInstance(pool_size_, num_instances_, static_cast<uint32_t>(i),
+                                                       disk_manager, replacer_k, log_manager, disk_scheduler_));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  // The page cleaners schedule writes on the shared scheduler: stop them before it goes away. Then drain the
+  // scheduler: completions of in-flight prefetches still reference the instances.
+  StopPageCleaner();
+  delete disk_scheduler_;
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  BUSTUB_ASSERT(page_id >= 0, "cannot route an invalid page id");
+  return instances_[static_cast<size_t>(page_id) % num_instances_];
+}
+
+void ParallelBufferPoolManager::StartPageCleaner() {
+  for (auto *instance : instances_) {
+    instance->StartPageCleaner();
+  }
+}
+
+void ParallelBufferPoolManager::StopPageCleaner() {
+  for (auto *instance : instances_) {
+    instance->StopPageCleaner();
+  }
+}
+
+auto ParallelBufferPoolManager::GetForegroundWrites() const -> size_t {
+  size_t writes = 0;
+  for (auto *instance : instances_) {
+    writes += instance->GetForegroundWrites();
+  }
+  return writes;
+}
+
+auto ParallelBufferPoolManager::GetBackgroundWrites() const -> size_t {
+  size_t writes = 0;
+  for (auto *instance : instances_) {
+    writes += instance->GetBackgroundWrites();
+  }
+  return writes;
+}
+
+auto ParallelBufferPoolManager::GetFetchHits() const -> size_t {
+  size_t hits = 0;
+  for (auto *instance : instances_) {
+    hits += instance->GetFetchHits();
+  }
+  return hits;
+}
+
+auto ParallelBufferPoolManager::GetFetchMisses() const -> size_t {
+  size_t misses = 0;
+  for (auto *instance : instances_) {
+    misses += instance->GetFetchMisses();
+  }
+  return misses;
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  size_t start = next_instance_.fetch_add(1) % num_instances_;
+  for (size_t i = 0; i < num_instances_; ++i) {
+    Page *page = instances_[(start + i) % num_instances_]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  if (page_id == INVALID_PAGE_ID) {
+    return nullptr;
+  }
+  return GetBufferPoolManager(page_id)->FetchPage(page_id, strategy);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return false;
+  }
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  for (auto *instance : instances_) {
+    instance->FlushAllPages();
+  }
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  if (page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+auto ParallelBufferPoolManager::TryDeletePgImp(page_id_t page_id) -> DeletePageResult {
+  if (page_id == INVALID_PAGE_ID) {
+    return DeletePageResult::DELETED;
+  }
+  return GetBufferPoolManager(page_id)->TryDeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  GetBufferPoolManager(page_id)->PrefetchPage(page_id);
+}
+
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) {
+  if (page_id == INVALID_PAGE_ID) {
+    return;
+  }
+  GetBufferPoolManager(page_id)->PrefetchPage(page_id, strategy);
+}
+
+}  // namespace bustub
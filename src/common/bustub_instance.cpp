@@ -33,6 +33,8 @@
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/disk/disk_manager_memory.h"
+#include "storage/index/key_normalizer.h"
+#include "storage/page/header_page.h"
 #include "type/value_factory.h"
 
 namespace bustub {
@@ -41,6 +43,25 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn) -> std::unique_ptr<Ex
   return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_);
 }
 
+/**
+ * Allocate the header page, in which the indexes record their root page ids, as the first page of a new buffer pool.
+ * Otherwise the first table heap gets page 0, and the indexes write their records over its tuples. A db file of an
+ * earlier run already has its header page; the catalog starts out empty, so its records are cleared.
+ */
+static void CreateHeaderPage(BufferPoolManager *buffer_pool_manager, DiskManager *disk_manager) {
+  HeaderPage *header_page;
+  if (disk_manager->GetNumPages() > HEADER_PAGE_ID) {
+    header_page = reinterpret_cast<HeaderPage *>(buffer_pool_manager->FetchPage(HEADER_PAGE_ID));
+    BUSTUB_ENSURE(header_page != nullptr, "cannot fetch the header page");
+  } else {
+    page_id_t header_page_id;
+    header_page = reinterpret_cast<HeaderPage *>(buffer_pool_manager->NewPage(&header_page_id));
+    BUSTUB_ENSURE(header_page != nullptr && header_page_id == HEADER_PAGE_ID, "cannot allocate the header page");
+  }
+  header_page->Init();
+  buffer_pool_manager->UnpinPage(HEADER_PAGE_ID, true);
+}
+
 BustubInstance::BustubInstance(const std::string &db_file_name) {
   enable_logging = false;
 
@@ -53,7 +74,12 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    auto *buffer_pool_manager = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    if (enable_page_cleaner) {
+      buffer_pool_manager->StartPageCleaner();
+    }
+    buffer_pool_manager_ = buffer_pool_manager;
+    CreateHeaderPage(buffer_pool_manager_, disk_manager_);
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -71,6 +97,10 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
 
   // Execution engine.
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
+
+  if (enable_vacuum && buffer_pool_manager_ != nullptr) {
+    StartVacuum();
+  }
 }
 
 BustubInstance::BustubInstance() {
@@ -85,7 +115,12 @@ BustubInstance::BustubInstance() {
   // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
   // buffer pool size specified in `config.h`.
   try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    auto *buffer_pool_manager = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    if (enable_page_cleaner) {
+      buffer_pool_manager->StartPageCleaner();
+    }
+    buffer_pool_manager_ = buffer_pool_manager;
+    CreateHeaderPage(buffer_pool_manager_, disk_manager_);
   } catch (NotImplementedException &e) {
     std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
     buffer_pool_manager_ = nullptr;
@@ -103,6 +138,10 @@ BustubInstance::BustubInstance() {
 
   // Execution engine.
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
+
+  if (enable_vacuum && buffer_pool_manager_ != nullptr) {
+    StartVacuum();
+  }
 }
 
 void BustubInstance::CmdDisplayTables(ResultWriter &writer) {
@@ -146,6 +185,74 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdVacuum(ResultWriter &writer) {
+  auto reclaimed = VacuumTables();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  writer.WriteHeaderCell("name");
+  writer.WriteHeaderCell("pages");
+  writer.WriteHeaderCell("bytes_reclaimed");
+  writer.EndHeader();
+  for (const auto &[name, bytes_reclaimed] : reclaimed) {
+    writer.BeginRow();
+    writer.WriteCell(name);
+    writer.WriteCell(fmt::format("{}", catalog_->GetTable(name)->table_->GetNumPages()));
+    writer.WriteCell(fmt::format("{}", bytes_reclaimed));
+    writer.EndRow();
+  }
+  writer.EndTable();
+}
+
+auto BustubInstance::VacuumTables() -> std::vector<std::pair<std::string, size_t>> {
+  std::vector<std::pair<std::string, TableHeap *>> tables;
+  {
+    std::shared_lock<std::shared_mutex> l(catalog_lock_);
+    for (const auto &name : catalog_->GetTableNames()) {
+      // Tables created without a heap, e.g. in a shell without a buffer pool, have nothing to vacuum.
+      auto *table = catalog_->GetTable(name)->table_.get();
+      if (table != nullptr) {
+        tables.emplace_back(name, table);
+      }
+    }
+  }
+  // Tables are never dropped, so their heaps outlive the catalog lock.
+  std::vector<std::pair<std::string, size_t>> reclaimed;
+  for (const auto &[name, table] : tables) {
+    reclaimed.emplace_back(name, table->Vacuum());
+  }
+  return reclaimed;
+}
+
+void BustubInstance::StartVacuum() {
+  std::scoped_lock<std::mutex> lock(vacuum_latch_);
+  if (vacuum_running_) {
+    return;
+  }
+  vacuum_running_ = true;
+  vacuum_thread_ = std::thread([this] { RunVacuum(); });
+}
+
+void BustubInstance::StopVacuum() {
+  {
+    std::scoped_lock<std::mutex> lock(vacuum_latch_);
+    if (!vacuum_running_) {
+      return;
+    }
+    vacuum_running_ = false;
+  }
+  vacuum_cv_.notify_all();
+  vacuum_thread_.join();
+}
+
+void BustubInstance::RunVacuum() {
+  std::unique_lock<std::mutex> lock(vacuum_latch_);
+  while (!vacuum_cv_.wait_for(lock, vacuum_interval, [this] { return !vacuum_running_; })) {
+    lock.unlock();
+    VacuumTables();
+    lock.lock();
+  }
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -159,6 +266,7 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 
 \dt: show all tables
 \di: show all indices
+\vacuum: compact all tables and reclaim their empty pages
 \help: show this message again
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
@@ -174,7 +282,15 @@ see the execution plan of your query.
 
 auto BustubInstance::ExecuteSql(const std::string &sql, ResultWriter &writer) -> bool {
   auto txn = txn_manager_->Begin();
-  auto result = ExecuteSqlTxn(sql, writer, txn);
+  bool result;
+  try {
+    result = ExecuteSqlTxn(sql, writer, txn);
+  } catch (...) {
+    // A statement that fails outside the executors (e.g. CREATE INDEX) must still end its transaction.
+    txn_manager_->Abort(txn);
+    delete txn;
+    throw;
+  }
   txn_manager_->Commit(txn);
   delete txn;
   return result;
@@ -191,6 +307,10 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       CmdDisplayIndices(writer);
       return true;
     }
+    if (sql == "\\vacuum") {
+      CmdVacuum(writer);
+      return true;
+    }
     if (sql == "\\help") {
       CmdDisplayHelp(writer);
       return true;
@@ -226,21 +346,16 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
 
         std::vector<uint32_t> col_ids;
         for (const auto &col : index_stmt.cols_) {
-          auto idx = index_stmt.table_->schema_.GetColIdx(col->col_name_.back());
-          col_ids.push_back(idx);
-          if (index_stmt.table_->schema_.GetColumn(idx).GetType() != TypeId::INTEGER) {
-            throw NotImplementedException("only support creating index on integer column");
-          }
-        }
-        if (col_ids.size() != 1) {
-          throw NotImplementedException("only support creating index with exactly one column");
+          col_ids.push_back(index_stmt.table_->schema_.GetColIdx(col->col_name_.back()));
         }
         auto key_schema = Schema::CopySchema(&index_stmt.table_->schema_, col_ids);
+        if (key_schema.IsInlined() && KeyNormalizer::GetNormalizedSize(key_schema) + KeyNormalizer::RID_SIZE > 64) {
+          throw NotImplementedException("index key is wider than 56 bytes");
+        }
 
         std::unique_lock<std::shared_mutex> l(catalog_lock_);
-        auto info = catalog_->CreateIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>(
-            txn, index_stmt.index_name_, index_stmt.table_->table_, index_stmt.table_->schema_, key_schema, col_ids,
-            INTEGER_SIZE, IntegerHashFunctionType{});
+        auto info = catalog_->CreateIndex(txn, index_stmt.index_name_, index_stmt.table_->table_,
+                                          index_stmt.table_->schema_, key_schema, col_ids);
         l.unlock();
 
         if (info == nullptr) {
@@ -388,6 +503,7 @@ void BustubInstance::GenerateMockTable() {
 }
 
 BustubInstance::~BustubInstance() {
+  StopVacuum();
   if (enable_logging) {
     log_manager_->StopFlushThread();
   }
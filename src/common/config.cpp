@@ -20,4 +20,24 @@ std::chrono::duration<int64_t> log_timeout = std::chrono::seconds(1);
 
 std::chrono::milliseconds cycle_detection_interval = std::chrono::milliseconds(50);
 
+std::atomic<bool> enable_page_cleaner(false);
+
+std::chrono::milliseconds page_cleaner_interval = std::chrono::milliseconds(10);
+
+double page_cleaner_clean_ratio = 0.25;
+
+std::atomic<bool> enable_vacuum(false);
+
+std::chrono::milliseconds vacuum_interval = std::chrono::seconds(1);
+
+double seq_scan_ring_threshold = 0.25;
+
+double index_fill_factor = 0.9;
+
+FrameMemory frame_memory = FrameMemory::HEAP;
+
+FrameNumaPolicy frame_numa_policy = FrameNumaPolicy::DEFAULT;
+
+uint64_t frame_numa_nodes = 0;
+
 }  // namespace bustub
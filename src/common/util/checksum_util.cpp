@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_util.cpp
+//
+// Identification: src/common/util/checksum_util.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/checksum_util.h"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace bustub {
+
+namespace {
+
+/** The CRC32C polynomial, bit-reflected. */
+constexpr uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+auto MakeCrc32cTable() -> std::array<uint32_t, 256> {
+  std::array<uint32_t, 256> table{};
+  for (uint32_t i = 0; i < 256; ++i) {
+    uint32_t crc = i;
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLYNOMIAL : 0);
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+auto Crc32cSoftware(uint32_t crc, const char *data, size_t len) -> uint32_t {
+  static const std::array<uint32_t, 256> TABLE = MakeCrc32cTable();
+  for (size_t i = 0; i < len; ++i) {
+    crc = (crc >> 8) ^ TABLE[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF];
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2"))) auto Crc32cHardware(uint32_t crc, const char *data, size_t len) -> uint32_t {
+  uint64_t crc64 = crc;
+  for (; len >= sizeof(uint64_t); data += sizeof(uint64_t), len -= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(uint64_t));
+    crc64 = _mm_crc32_u64(crc64, word);
+  }
+  crc = static_cast<uint32_t>(crc64);
+  for (; len > 0; ++data, --len) {
+    crc = _mm_crc32_u8(crc, static_cast<uint8_t>(*data));
+  }
+  return crc;
+}
+
+auto HasCrc32Instruction() -> bool {
+  static const bool HAS_SSE4_2 = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2") != 0;
+  }();
+  return HAS_SSE4_2;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+
+auto Crc32cHardware(uint32_t crc, const char *data, size_t len) -> uint32_t {
+  for (; len >= sizeof(uint64_t); data += sizeof(uint64_t), len -= sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(uint64_t));
+    crc = __crc32cd(crc, word);
+  }
+  for (; len > 0; ++data, --len) {
+    crc = __crc32cb(crc, static_cast<uint8_t>(*data));
+  }
+  return crc;
+}
+
+auto HasCrc32Instruction() -> bool { return true; }
+
+#else
+
+auto Crc32cHardware(uint32_t crc, const char *data, size_t len) -> uint32_t { return Crc32cSoftware(crc, data, len); }
+
+auto HasCrc32Instruction() -> bool { return false; }
+
+#endif
+
+}  // namespace
+
+auto ChecksumUtil::Crc32c(const char *data, size_t len) -> uint32_t {
+  uint32_t crc = ~0U;
+  crc = HasCrc32Instruction() ? Crc32cHardware(crc, data, len) : Crc32cSoftware(crc, data, len);
+  return ~crc;
+}
+
+auto ChecksumUtil::IsHardwareAccelerated() -> bool { return HasCrc32Instruction(); }
+
+}  // namespace bustub
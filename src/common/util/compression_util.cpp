@@ -0,0 +1,206 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.cpp
+//
+// Identification: src/common/util/compression_util.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/compression_util.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace bustub {
+
+namespace {
+
+/** Shortest back reference worth encoding. */
+constexpr size_t MIN_MATCH = 4;
+
+/** Farthest back reference the 2-byte offset can encode. */
+constexpr size_t MAX_OFFSET = 65535;
+
+/** A nibble of the token with this value is continued by length bytes. */
+constexpr size_t NIBBLE_MAX = 15;
+
+constexpr int HASH_BITS = 12;
+
+auto Load32(const uint8_t *p) -> uint32_t {
+  uint32_t value;
+  memcpy(&value, p, sizeof(uint32_t));
+  return value;
+}
+
+auto Load64(const uint8_t *p) -> uint64_t {
+  uint64_t value;
+  memcpy(&value, p, sizeof(uint64_t));
+  return value;
+}
+
+auto Hash(uint32_t sequence) -> uint32_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** @return the number of bytes a length takes beyond its nibble */
+auto ExtraLengthBytes(size_t length) -> size_t { return length < NIBBLE_MAX ? 0 : (length - NIBBLE_MAX) / 255 + 1; }
+
+auto WriteExtraLength(uint8_t *op, size_t length) -> uint8_t * {
+  if (length < NIBBLE_MAX) {
+    return op;
+  }
+  length -= NIBBLE_MAX;
+  for (; length >= 255; length -= 255) {
+    *op++ = 255;
+  }
+  *op++ = static_cast<uint8_t>(length);
+  return op;
+}
+
+/** Read the bytes continuing a nibble of 15 onto length. @return false if the input ends first */
+auto ReadExtraLength(const uint8_t **ip, const uint8_t *ip_end, size_t *length) -> bool {
+  uint8_t byte;
+  do {
+    if (*ip >= ip_end) {
+      return false;
+    }
+    byte = *(*ip)++;
+    *length += byte;
+  } while (byte == 255);
+  return true;
+}
+
+/** @return the number of bytes at a and b that are equal, comparing no further than limit */
+auto MatchLength(const uint8_t *a, const uint8_t *b, const uint8_t *limit) -> size_t {
+  const uint8_t *start = b;
+  while (b + sizeof(uint64_t) <= limit) {
+    uint64_t diff = Load64(a) ^ Load64(b);
+    if (diff != 0) {
+      return b - start + __builtin_ctzll(diff) / 8;
+    }
+    a += sizeof(uint64_t);
+    b += sizeof(uint64_t);
+  }
+  while (b < limit && *a == *b) {
+    ++a;
+    ++b;
+  }
+  return b - start;
+}
+
+}  // namespace
+
+auto CompressionUtil::Compress(const char *src, size_t len, char *dst, size_t capacity) -> size_t {
+  const auto *in = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *in_end = in + len;
+  auto *op = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *op_end = op + capacity;
+  // Positions of the last 4-byte sequences seen, by hash. A stale or colliding entry only fails the comparison.
+  std::array<uint32_t, 1 << HASH_BITS> table{};
+
+  const uint8_t *anchor = in;
+  const uint8_t *ip = in;
+  size_t misses = 0;
+  while (ip + MIN_MATCH <= in_end) {
+    uint32_t sequence = Load32(ip);
+    uint32_t hash = Hash(sequence);
+    const uint8_t *candidate = in + table[hash];
+    table[hash] = static_cast<uint32_t>(ip - in);
+    if (candidate >= ip || static_cast<size_t>(ip - candidate) > MAX_OFFSET || Load32(candidate) != sequence) {
+      // Skip ahead faster the longer nothing matches, so that incompressible data costs little.
+      ip += 1 + (misses++ >> 5);
+      continue;
+    }
+    misses = 0;
+    size_t literals = ip - anchor;
+    size_t match = MIN_MATCH + MatchLength(candidate + MIN_MATCH, ip + MIN_MATCH, in_end);
+    size_t sequence_size = 1 + ExtraLengthBytes(literals) + literals + 2 + ExtraLengthBytes(match - MIN_MATCH);
+    if (sequence_size > static_cast<size_t>(op_end - op)) {
+      return 0;
+    }
+    uint8_t *token = op++;
+    *token = static_cast<uint8_t>(std::min(literals, NIBBLE_MAX) << 4 | std::min(match - MIN_MATCH, NIBBLE_MAX));
+    op = WriteExtraLength(op, literals);
+    memcpy(op, anchor, literals);
+    op += literals;
+    auto offset = static_cast<uint16_t>(ip - candidate);
+    *op++ = static_cast<uint8_t>(offset);
+    *op++ = static_cast<uint8_t>(offset >> 8);
+    op = WriteExtraLength(op, match - MIN_MATCH);
+    ip += match;
+    anchor = ip;
+  }
+
+  size_t literals = in_end - anchor;
+  if (1 + ExtraLengthBytes(literals) + literals > static_cast<size_t>(op_end - op)) {
+    return 0;
+  }
+  *op++ = static_cast<uint8_t>(std::min(literals, NIBBLE_MAX) << 4);
+  op = WriteExtraLength(op, literals);
+  memcpy(op, anchor, literals);
+  op += literals;
+  return op - reinterpret_cast<uint8_t *>(dst);
+}
+
+auto CompressionUtil::Decompress(const char *src, size_t len, char *dst, size_t dst_len) -> bool {
+  const auto *ip = reinterpret_cast<const uint8_t *>(src);
+  const uint8_t *ip_end = ip + len;
+  auto *out = reinterpret_cast<uint8_t *>(dst);
+  uint8_t *op = out;
+  uint8_t *op_end = out + dst_len;
+
+  while (true) {
+    // the data must end with the literals of a sequence, so a cut-off image never decompresses
+    if (ip == ip_end) {
+      return false;
+    }
+    uint8_t token = *ip++;
+    size_t literals = token >> 4;
+    if (literals == NIBBLE_MAX && !ReadExtraLength(&ip, ip_end, &literals)) {
+      return false;
+    }
+    if (literals > static_cast<size_t>(ip_end - ip) || literals > static_cast<size_t>(op_end - op)) {
+      return false;
+    }
+    memcpy(op, ip, literals);
+    ip += literals;
+    op += literals;
+    // the last sequence has no match
+    if (ip == ip_end) {
+      return op == op_end;
+    }
+
+    if (ip_end - ip < 2) {
+      return false;
+    }
+    size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+    ip += 2;
+    size_t match = token & NIBBLE_MAX;
+    if (match == NIBBLE_MAX && !ReadExtraLength(&ip, ip_end, &match)) {
+      return false;
+    }
+    match += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(op - out) || match > static_cast<size_t>(op_end - op)) {
+      return false;
+    }
+    const uint8_t *from = op - offset;
+    if (offset >= match) {
+      memcpy(op, from, match);
+      op += match;
+    } else {
+      // The match overlaps the bytes it produces, e.g. a run of one byte repeated. The bytes from `from` on repeat
+      // with a period of offset, so every step can copy all bytes produced so far, doubling the step.
+      uint8_t *match_end = op + match;
+      while (op < match_end) {
+        size_t step = std::min(static_cast<size_t>(op - from), static_cast<size_t>(match_end - op));
+        memcpy(op, from, step);
+        op += step;
+      }
+    }
+  }
+}
+
+}  // namespace bustub
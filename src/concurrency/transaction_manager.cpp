@@ -46,7 +46,7 @@ auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level)
 void TransactionManager::Commit(Transaction *txn) {
   txn->SetState(TransactionState::COMMITTED);
 
-  // Perform all deletes before we commit.
+  // Perform all deletes before we commit, and drop the old versions of updated tuples.
   auto write_set = txn->GetWriteSet();
   while (!write_set->empty()) {
     auto &item = write_set->back();
@@ -54,6 +54,8 @@ void TransactionManager::Commit(Transaction *txn) {
     if (item.wtype_ == WType::DELETE) {
       // Note that this also releases the lock when holding the page latch.
       table->ApplyDelete(item.rid_, txn);
+    } else if (item.wtype_ == WType::UPDATE) {
+      table->ApplyUpdate(item.tuple_);
     }
     write_set->pop_back();
   }
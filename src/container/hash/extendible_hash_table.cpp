@@ -91,7 +91,7 @@ void ExtendibleHashTable<K, V>::Insert(const K &key, const V &value) {
     dir_[hi]->IncrementDepth();
     if (GetGlobalDepthInternal() < GetLocalDepthInternal(hi)) {
       ++global_depth_;
-      for (size_t i = 0; i < 1 << (GetGlobalDepthInternal() - 1); ++i) {
+      for (size_t i = 0; i < (1UL << (GetGlobalDepthInternal() - 1)); ++i) {
         dir_.emplace_back(dir_[i]);
       }
     }
@@ -107,7 +107,7 @@ auto ExtendibleHashTable<K, V>::RedistributeBucket(std::shared_ptr<Bucket> bucke
   auto q = pp | 1 << (bucket->GetDepth() - 1);
   dir_[q] = std::make_shared<Bucket>(bucket_size_, bucket->GetDepth());
   ++num_buckets_;
-  for (size_t i = 3; i < 1 << (GetGlobalDepthInternal() - bucket->GetDepth() + 1); i += 2) {
+  for (size_t i = 3; i < (1UL << (GetGlobalDepthInternal() - bucket->GetDepth() + 1)); i += 2) {
     dir_[pp | i << (bucket->GetDepth() - 1)] = dir_[q];
   }
   auto iter = bucket->GetItems().begin();
@@ -28,7 +28,7 @@ void DeleteExecutor::Init() {
                                                 table_info_->oid_)) {
       throw ExecutionException("delete table lock failed");
     }
-  } catch (TransactionAbortException e) {
+  } catch (TransactionAbortException &e) {
     throw ExecutionException("delete table lock failed" + e.GetInfo());
   }
   indexes_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
@@ -47,7 +47,7 @@ auto DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
                                                 table_info_->oid_, r)) {
         throw ExecutionException("delete row lock failed");
       }
-    } catch (TransactionAbortException e) {
+    } catch (TransactionAbortException &e) {
       throw ExecutionException("delete row lock failed" + e.GetInfo());
     }
     if (table_info_->table_->MarkDelete(r, this->GetExecutorContext()->GetTransaction())) {
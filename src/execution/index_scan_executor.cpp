@@ -17,9 +17,7 @@ IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanP
     : AbstractExecutor(exec_ctx),
       plan_{plan},
       index_info_{exec_ctx_->GetCatalog()->GetIndex(plan_->index_oid_)},
-      table_info_{exec_ctx_->GetCatalog()->GetTable(index_info_->table_name_)},
-      index_{dynamic_cast<BPlusTreeIndexForOneIntegerColumn *>(index_info_->index_.get())},
-      iter_(index_->GetBeginIterator()) {}
+      table_info_{exec_ctx_->GetCatalog()->GetTable(index_info_->table_name_)} {}
 
 void IndexScanExecutor::Init() {
   if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
@@ -29,29 +27,39 @@ void IndexScanExecutor::Init() {
       if (!locked) {
         throw ExecutionException("IndexScan Executor Get Table Lock Failed");
       }
-    } catch (TransactionAbortException e) {
+    } catch (TransactionAbortException &e) {
       throw ExecutionException("IndexScan Executor Get Table Lock Failed" + e.GetInfo());
     }
   }
+  // Collect the RIDs up front so that no leaf stays latched while the rows are emitted: a parent that deletes or
+  // updates them would otherwise wait for that latch forever.
+  rids_.clear();
+  cursor_ = 0;
+  auto iter = index_info_->index_->Scan(plan_->lower_bound_, plan_->lower_inclusive_, plan_->upper_bound_,
+                                        plan_->upper_inclusive_, exec_ctx_->GetTransaction());
+  for (; !iter->IsEnd(); iter->Next()) {
+    rids_.push_back(iter->GetRid());
+  }
 }
 
 auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  if (iter_ != index_->GetEndIterator()) {
+  while (cursor_ < rids_.size()) {
     if (exec_ctx_->GetTransaction()->GetIsolationLevel() != IsolationLevel::READ_UNCOMMITTED) {
       try {
         bool locked = exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), LockManager::LockMode::SHARED,
-                                                           table_info_->oid_, (*iter_).second);
+                                                           table_info_->oid_, rids_[cursor_]);
         if (!locked) {
           throw ExecutionException("IndexScan Executor Get Table Lock Failed");
         }
-      } catch (TransactionAbortException e) {
+      } catch (TransactionAbortException &e) {
         throw ExecutionException("IndexScan Executor Get Row Lock Failed");
       }
     }
-    *rid = (*iter_).second;
-    auto result = table_info_->table_->GetTuple(*rid, tuple, exec_ctx_->GetTransaction());
-    ++iter_;
-    return result;
+    *rid = rids_[cursor_++];
+    // skip a row deleted since its RID was collected
+    if (table_info_->table_->GetTuple(*rid, tuple, exec_ctx_->GetTransaction())) {
+      return true;
+    }
   }
   return false;
 }
@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <memory>
+#include <vector>
 
 #include "execution/executors/insert_executor.h"
 
@@ -28,7 +29,7 @@ void InsertExecutor::Init() {
                                                 table_info_->oid_)) {
       throw ExecutionException("insert table lock failed");
     }
-  } catch (TransactionAbortException e) {
+  } catch (TransactionAbortException &e) {
     throw ExecutionException("insert table lock failed" + e.GetInfo());
   }
   indexes_ = exec_ctx_->GetCatalog()->GetTableIndexes(table_info_->name_);
@@ -38,26 +39,57 @@ auto InsertExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) -> bool {
   if (finished_) {
     return false;
   }
+  // Pull all tuples first. A batch that fills at least a page is packed into fresh pages by a bulk insert; a small
+  // one goes through the free space map, so that it does not start a page of its own.
+  std::vector<Tuple> tuples;
+  size_t total_size = 0;
   Tuple tup;
   RID emit_rid;
-  int cnt = 0;
   while (child_executor_->Next(&tup, &emit_rid)) {
-    if (table_info_->table_->InsertTuple(tup, rid, exec_ctx_->GetTransaction())) {
-      try {
-        if (!exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), LockManager::LockMode::EXCLUSIVE,
-                                                  table_info_->oid_, *rid)) {
-          throw ExecutionException("insert row lock failed");
+    total_size += tup.GetLength();
+    tuples.push_back(tup);
+  }
+  // Fail the statement on a key too long for its index before touching the heap, which would keep rows the index
+  // misses.
+  for (auto &t : tuples) {
+    for (auto &index : indexes_) {
+      auto key = t.KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs());
+      if (!index->index_->KeyFits(key)) {
+        throw ExecutionException("index key is too long for index " + index->name_);
+      }
+    }
+  }
+  std::vector<RID> rids;
+  if (total_size >= BUSTUB_PAGE_SIZE) {
+    table_info_->table_->BulkInsertTuples(tuples, &rids, exec_ctx_->GetTransaction());
+  } else {
+    // Keep the inserted tuples in front, in step with their rids.
+    for (size_t i = 0; i < tuples.size(); ++i) {
+      if (table_info_->table_->InsertTuple(tuples[i], rid, exec_ctx_->GetTransaction())) {
+        if (rids.size() != i) {
+          tuples[rids.size()] = tuples[i];
         }
-      } catch (TransactionAbortException e) {
-        throw ExecutionException("insert row lock failed" + e.GetInfo());
+        rids.push_back(*rid);
       }
+    }
+  }
 
-      for (auto &index : indexes_) {
-        auto key = tup.KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs());
-        index->index_->InsertEntry(key, *rid, this->GetExecutorContext()->GetTransaction());
+  int cnt = 0;
+  for (size_t i = 0; i < rids.size(); ++i) {
+    try {
+      if (!exec_ctx_->GetLockManager()->LockRow(exec_ctx_->GetTransaction(), LockManager::LockMode::EXCLUSIVE,
+                                                table_info_->oid_, rids[i])) {
+        throw ExecutionException("insert row lock failed");
       }
-      ++cnt;
+    } catch (TransactionAbortException &e) {
+      throw ExecutionException("insert row lock failed" + e.GetInfo());
+    }
+
+    for (auto &index : indexes_) {
+      auto key = tuples[i].KeyFromTuple(table_info_->schema_, index->key_schema_, index->index_->GetKeyAttrs());
+      index->index_->InsertEntry(key, rids[i], this->GetExecutorContext()->GetTransaction());
     }
+    ++cnt;
   }
   std::vector<Value> values{};
   values.emplace_back(TypeId::INTEGER, cnt);
@@ -28,42 +28,50 @@ void NestIndexJoinExecutor::Init() {
   child_->Init();
   index_info_ = exec_ctx_->GetCatalog()->GetIndex(plan_->index_oid_);
   table_info_ = exec_ctx_->GetCatalog()->GetTable(index_info_->table_name_);
-  tree_ = dynamic_cast<BPlusTreeIndexForOneIntegerColumn *>(index_info_->index_.get());
+  rids_.clear();
+  cursor_ = 0;
+  left_pending_ = false;
 }
 
 auto NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) -> bool {
-  Tuple lhs;
-  std::vector<Value> res;
-  while (child_->Next(&lhs, rid)) {
-    auto u = plan_->KeyPredicate()->Evaluate(&lhs, child_->GetOutputSchema());
-    std::vector<RID> rids;
-    auto key = Tuple({u}, index_info_->index_->GetKeySchema());
-    tree_->ScanKey(key, &rids, exec_ctx_->GetTransaction());
-
-    Tuple rhs;
-    if (!rids.empty()) {
-      table_info_->table_->GetTuple(rids[0], &rhs, exec_ctx_->GetTransaction());
-      for (size_t i = 0; i < child_->GetOutputSchema().GetColumnCount(); i++) {
-        res.push_back(lhs.GetValue(&child_->GetOutputSchema(), i));
-      }
-      for (size_t i = 0; i < plan_->InnerTableSchema().GetColumnCount(); i++) {
-        res.push_back(rhs.GetValue(&plan_->InnerTableSchema(), i));
+  while (true) {
+    // emit the remaining matches of the current outer tuple, one per call
+    while (cursor_ < rids_.size()) {
+      Tuple rhs;
+      if (table_info_->table_->GetTuple(rids_[cursor_++], &rhs, exec_ctx_->GetTransaction())) {
+        left_pending_ = false;
+        *tuple = JoinTuples(&rhs);
+        return true;
       }
-      *tuple = Tuple(res, &GetOutputSchema());
-      return true;
     }
-    if (plan_->GetJoinType() == JoinType::LEFT) {
-      for (size_t i = 0; i < child_->GetOutputSchema().GetColumnCount(); i++) {
-        res.push_back(lhs.GetValue(&child_->GetOutputSchema(), i));
-      }
-      for (size_t i = 0; i < plan_->InnerTableSchema().GetColumnCount(); i++) {
-        res.push_back(ValueFactory::GetNullValueByType(plan_->InnerTableSchema().GetColumn(i).GetType()));
-      }
-      *tuple = Tuple(res, &GetOutputSchema());
+    if (left_pending_) {
+      left_pending_ = false;
+      *tuple = JoinTuples(nullptr);
       return true;
     }
+
+    if (!child_->Next(&lhs_, rid)) {
+      return false;
+    }
+    auto u = plan_->KeyPredicate()->Evaluate(&lhs_, child_->GetOutputSchema());
+    auto key = Tuple({u}, index_info_->index_->GetKeySchema());
+    rids_.clear();
+    cursor_ = 0;
+    index_info_->index_->ScanKey(key, &rids_, exec_ctx_->GetTransaction());
+    left_pending_ = plan_->GetJoinType() == JoinType::LEFT;
+  }
+}
+
+auto NestIndexJoinExecutor::JoinTuples(const Tuple *rhs) const -> Tuple {
+  std::vector<Value> res;
+  for (size_t i = 0; i < child_->GetOutputSchema().GetColumnCount(); i++) {
+    res.push_back(lhs_.GetValue(&child_->GetOutputSchema(), i));
+  }
+  for (size_t i = 0; i < plan_->InnerTableSchema().GetColumnCount(); i++) {
+    res.push_back(rhs != nullptr ? rhs->GetValue(&plan_->InnerTableSchema(), i)
+                                 : ValueFactory::GetNullValueByType(plan_->InnerTableSchema().GetColumn(i).GetType()));
   }
-  return false;
+  return Tuple(res, &GetOutputSchema());
 }
 
 }  // namespace bustub
@@ -25,11 +25,16 @@ void SeqScanExecutor::Init() {
       if (!locked) {
         throw ExecutionException("SeqScan Executor Get Table Lock Failed");
       }
-    } catch (TransactionAbortException e) {
+    } catch (TransactionAbortException &e) {
       throw ExecutionException("SeqScan Executor Get Table Lock Failed" + e.GetInfo());
     }
   }
-  iter_ = table_info_->table_->Begin(exec_ctx_->GetTransaction());
+  auto pool_size = static_cast<double>(exec_ctx_->GetBufferPoolManager()->GetPoolSize());
+  if (strategy_ == nullptr &&
+      static_cast<double>(table_info_->table_->GetNumPages()) > pool_size * seq_scan_ring_threshold) {
+    strategy_ = std::make_unique<BufferAccessStrategy>(SEQ_SCAN_RING_SIZE);
+  }
+  iter_ = table_info_->table_->Begin(exec_ctx_->GetTransaction(), strategy_.get());
 }
 
 auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
@@ -51,7 +56,7 @@ auto SeqScanExecutor::Next(Tuple *tuple, RID *rid) -> bool {
       if (!locked) {
         throw ExecutionException("SeqScan Executor Get Table Lock Failed");
       }
-    } catch (TransactionAbortException e) {
+    } catch (TransactionAbortException &e) {
       throw ExecutionException("SeqScan Executor Get Row Lock Failed");
     }
   }
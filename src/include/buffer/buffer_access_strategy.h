@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <deque>
+#include <utility>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManagerInstance;
+
+/**
+ * BufferAccessStrategy lets a bulk operation, such as a sequential scan over a large table, cycle through a small ring
+ * of frames instead of the whole buffer pool.
+ *
+ * Pages that are read into the pool on behalf of a strategy are remembered in its ring. Once the ring holds more than
+ * ring_size pages, the oldest one is dropped from the pool again, unless it is pinned or somebody else has accessed it
+ * in the meantime, and its frame goes back to the free list where the next read of the operation picks it up. Fetches
+ * through a strategy do not count as accesses for the LRU-K replacer either, so a scan that touches each page many
+ * times neither makes its own pages look hot nor pushes out the working set of other queries.
+ *
+ * A strategy belongs to a single operation and must not be shared between threads.
+ */
+class BufferAccessStrategy {
+ public:
+  /**
+   * @brief Create a new strategy.
+   * @param ring_size the number of pages the operation may keep in the buffer pool
+   */
+  explicit BufferAccessStrategy(size_t ring_size) : ring_size_(ring_size) {}
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  ~BufferAccessStrategy() = default;
+
+  /** @return the number of pages the operation may keep in the buffer pool */
+  auto GetRingSize() const -> size_t { return ring_size_; }
+
+  /** @return the number of fetches through this strategy that found the page in the buffer pool */
+  auto GetHits() const -> size_t { return hits_; }
+
+  /** @return the number of fetches through this strategy that had to read the page from disk */
+  auto GetMisses() const -> size_t { return misses_; }
+
+ private:
+  friend class BufferPoolManagerInstance;
+
+  /** Maximum number of pages in ring_. */
+  const size_t ring_size_;
+  /** Pages read in on behalf of this strategy, oldest first, with the buffer pool instance that holds them. */
+  std::deque<std::pair<BufferPoolManagerInstance *, page_id_t>> ring_;
+  /** Number of fetches that found the page resident. */
+  size_t hits_{0};
+  /** Number of fetches that read the page from disk. */
+  size_t misses_{0};
+};
+
+}  // namespace bustub
@@ -16,6 +16,7 @@
 #include <mutex>  // NOLINT
 #include <unordered_map>
 
+#include "buffer/buffer_access_strategy.h"
 #include "buffer/lru_replacer.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
@@ -31,6 +32,16 @@ class BufferPoolManager {
   enum class CallbackType { BEFORE, AFTER };
   using bufferpool_callback_fn = void (*)(enum CallbackType, const page_id_t page_id);
 
+  /** Outcome of TryDeletePage(). */
+  enum class DeletePageResult {
+    /** The page was deleted, or page_id was INVALID_PAGE_ID. */
+    DELETED,
+    /** The page is pinned; deleting it may succeed once it is unpinned. */
+    PINNED,
+    /** The page is not allocated, e.g. because it was deleted already, or the pool cannot delete pages at all. */
+    NOT_ALLOCATED,
+  };
+
   BufferPoolManager() = default;
   /**
    * Destroys an existing BufferPoolManager.
@@ -84,6 +95,52 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * @brief Fetch a page on behalf of a bulk operation that cycles through a ring of frames. See BufferAccessStrategy.
+   * @param page_id id of the page to fetch
+   * @param strategy the ring of the calling operation, or nullptr for a normal fetch
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgImp(page_id, strategy);
+  }
+
+  /**
+   * @brief Hint that page_id is about to be fetched. If the page is not resident, start reading it into a free or
+   * clean frame in the background; the frame is cheap to evict until the page is actually fetched. Never blocks on
+   * disk, and silently does nothing if no suitable frame is available.
+   * @param page_id id of the page to prefetch
+   */
+  void PrefetchPage(page_id_t page_id) { PrefetchPgImp(page_id); }
+
+  /**
+   * @brief Prefetch the pages [first_page_id, first_page_id + num_pages). See PrefetchPage().
+   * @param first_page_id id of the first page to prefetch
+   * @param num_pages number of consecutive pages to prefetch
+   */
+  void PrefetchRange(page_id_t first_page_id, size_t num_pages) {
+    for (size_t i = 0; i < num_pages; ++i) {
+      PrefetchPgImp(first_page_id + static_cast<page_id_t>(i));
+    }
+  }
+
+  /**
+   * @brief Prefetch a page on behalf of a bulk operation. The page counts towards the operation's ring once it has
+   * been read. See PrefetchPage() and BufferAccessStrategy.
+   * @param page_id id of the page to prefetch
+   * @param strategy the ring of the calling operation, or nullptr for a normal prefetch
+   */
+  void PrefetchPage(page_id_t page_id, BufferAccessStrategy *strategy) { PrefetchPgImp(page_id, strategy); }
+
+  /**
+   * @brief Delete a page like DeletePage(), but tell a pinned page, which is worth deleting again later, apart from a
+   * page that can never be deleted. Both are decided under the same latch, so a page that was freed and handed out
+   * again in between is never mistaken for the page the caller meant.
+   * @param page_id id of the page to delete
+   * @return whether the page was deleted, and if not, why
+   */
+  auto TryDeletePage(page_id_t page_id) -> DeletePageResult { return TryDeletePgImp(page_id); }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
@@ -108,6 +165,17 @@ class BufferPoolManager {
    */
   virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
 
+  /**
+   * Fetch the requested page on behalf of a buffer access strategy. Buffer pools without ring support do a normal
+   * fetch.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of the calling operation, or nullptr
+   * @return the requested page
+   */
+  virtual auto FetchPgImp(page_id_t page_id, __attribute__((unused)) BufferAccessStrategy *strategy) -> Page * {
+    return FetchPgImp(page_id);
+  }
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -141,5 +209,30 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Starts loading a page in the background. Buffer pools that cannot do asynchronous reads ignore the hint.
+   * @param page_id id of the page to prefetch
+   */
+  virtual void PrefetchPgImp(__attribute__((unused)) page_id_t page_id) {}
+
+  /**
+   * Starts loading a page in the background on behalf of a buffer access strategy.
+   * @param page_id id of the page to prefetch
+   * @param strategy the ring of the calling operation, or nullptr
+   */
+  virtual void PrefetchPgImp(page_id_t page_id, __attribute__((unused)) BufferAccessStrategy *strategy) {
+    PrefetchPgImp(page_id);
+  }
+
+  /**
+   * Deletes a page and tells why it could not be. Buffer pools that do not track allocations report every failed
+   * delete as a pinned page.
+   * @param page_id id of page to be deleted
+   * @return whether the page was deleted, and if not, why
+   */
+  virtual auto TryDeletePgImp(page_id_t page_id) -> DeletePageResult {
+    return DeletePgImp(page_id) ? DeletePageResult::DELETED : DeletePageResult::PINNED;
+  }
 };
 }  // namespace bustub
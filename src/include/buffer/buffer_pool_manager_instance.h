@@ -12,22 +12,33 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
 #include <list>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/frame_arena.h"
 #include "buffer/lru_k_replacer.h"
+#include "buffer/page_table.h"
 #include "common/config.h"
-#include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
 #include "storage/page/page.h"
 
 namespace bustub {
 
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
+ *
+ * On top of a read-only disk manager that can hand out views of its pages (DiskManagerMmap), the pool is read-only:
+ * a fetch that misses points the frame at the view instead of copying the page into the frame's memory, and NewPage
+ * and DeletePage fail. The frame then only holds the page's book-keeping; its own memory is used again once the page
+ * is evicted.
  */
 class BufferPoolManagerInstance : public BufferPoolManager {
  public:
@@ -41,6 +52,20 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
                             LogManager *log_manager = nullptr);
 
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in the parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param disk_scheduler the disk scheduler shared by all BPIs of the parallel BPM, or nullptr for a private one
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, DiskScheduler *disk_scheduler = nullptr);
+
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
    */
@@ -52,6 +77,46 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the pointer to all the pages in the buffer pool. */
   auto GetPages() -> Page * { return pages_; }
 
+  /**
+   * @brief Start the background page cleaner. Every page_cleaner_interval, or as soon as an eviction had to write a
+   * dirty victim, it writes back the dirty frames among the coldest page_cleaner_clean_ratio of the pool, so that
+   * evictions find clean victims. Does nothing if the cleaner is already running.
+   */
+  void StartPageCleaner();
+
+  /** @brief Stop and join the page cleaner thread, if it is running. */
+  void StopPageCleaner();
+
+  /**
+   * @brief Run one round of the page cleaner on the calling thread.
+   * @return the number of pages written back
+   */
+  auto CleanColdFrames() -> size_t;
+
+  /** @brief Return the number of dirty victims written back by NewPage/FetchPage before they could reuse a frame. */
+  auto GetForegroundWrites() const -> size_t { return foreground_writes_; }
+
+  /** @brief Return the number of pages written back by the page cleaner. */
+  auto GetBackgroundWrites() const -> size_t { return background_writes_; }
+
+  /** @brief Return the number of prefetch reads that were started. */
+  auto GetPrefetchReads() const -> size_t { return prefetch_reads_; }
+
+  /** @brief Return the number of fetches that found the page in the buffer pool. */
+  auto GetFetchHits() const -> size_t { return fetch_hits_; }
+
+  /** @brief Return the number of fetches that had to read the page from disk. */
+  auto GetFetchMisses() const -> size_t { return fetch_misses_; }
+
+  /** @brief Return the number of fetch misses that were served zero-copy, as a view of the disk manager's memory. */
+  auto GetViewFetches() const -> size_t { return view_fetches_; }
+
+  /** @brief Return true if the pool is read-only because its disk manager is. */
+  auto IsReadOnly() const -> bool { return read_only_; }
+
+  /** @brief Return the kind of memory the frames were allocated from, after any fallback. */
+  auto GetFrameMemory() const -> FrameMemory { return frame_arena_->GetMemory(); }
+
  protected:
   /**
    * TODO(P1): Add implementation
@@ -68,7 +133,7 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * Also, remember to record the access history of the frame in the replacer for the lru-k algorithm to work.
    *
    * @param[out] page_id id of created page
-   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   * @return nullptr if no new pages could be created or the pool is read-only, otherwise pointer to new page
    */
   auto NewPgImp(page_id_t *page_id) -> Page * override;
 
@@ -85,11 +150,27 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    *
    * In addition, remember to disable eviction and record the access history of the frame like you did for NewPgImp().
    *
+   * A page that cannot be read, e.g. because it fails its checksum, is not left in the pool: the exception of the disk
+   * manager is passed on to the fetcher. Fetchers that waited for the same read try it again themselves.
+   *
    * @param page_id id of page to be fetched
    * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   * @throws Exception of type CORRUPTION if the page could not be read
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * @brief Fetch the requested page on behalf of a buffer access strategy.
+   *
+   * Works like FetchPgImp(page_id), except that a hit is not recorded in the replacer, and a page read from disk joins
+   * the strategy's ring. If that makes the ring overflow, its oldest page is released from the pool.
+   *
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of the calling operation, or nullptr for a normal fetch
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -121,59 +202,262 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Flush all the pages in the buffer pool to disk.
+   * @brief Flush all the pages in the buffer pool to disk, and have the disk manager sync the writes its sync policy
+   * has not synced yet.
    */
   void FlushAllPgsImp() override;
 
   /**
    * TODO(P1): Add implementation
    *
-   * @brief Delete a page from the buffer pool. If page_id is not in the buffer pool, do nothing and return true. If the
-   * page is pinned and cannot be deleted, return false immediately.
+   * @brief Delete a page from the buffer pool and deallocate it on disk. If page_id is not in the buffer pool, only
+   * deallocate it and return true. If the page is pinned and cannot be deleted, return false immediately. A page this
+   * instance does not own, has not allocated yet or has already deallocated is left alone, and false is returned.
    *
    * After deleting the page from the page table, stop tracking the frame in the replacer and add the frame
-   * back to the free list. Also, reset the page's memory and metadata. Finally, you should call DeallocatePage() to
-   * imitate freeing the page on the disk.
+   * back to the free list. Also, reset the page's memory and metadata. Finally, call DeallocatePage() to hand the page
+   * back to the disk manager, which reuses it for a later NewPage.
    *
    * @param page_id id of page to be deleted
-   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   * @return false if the page is not an allocated page of this instance, could not be deleted or the pool is
+   * read-only, true if the page wasn't resident or deletion succeeded
    */
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
+  /**
+   * @brief Delete a page as DeletePgImp() does, telling a pinned page apart from one that is not an allocated page of
+   * this instance. A read-only pool reports every page as not allocated.
+   * @param page_id id of page to be deleted
+   * @return whether the page was deleted, and if not, why
+   */
+  auto TryDeletePgImp(page_id_t page_id) -> DeletePageResult override;
+
+  /**
+   * @brief Start reading page_id into a frame in the background.
+   *
+   * Only a free frame or a clean victim is used, so a prefetch never writes in the foreground. The frame is pinned by
+   * the prefetch while the read is in flight; fetchers of the page wait on the frame like for any other in-progress
+   * read. Once loaded, the frame is unpinned with a single recorded access, so LRU-K evicts it early unless the page
+   * is actually used.
+   *
+   * @param page_id id of page to be prefetched
+   */
+  void PrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * @brief Start reading page_id into a frame in the background on behalf of a buffer access strategy. The page joins
+   * the strategy's ring as soon as the read is started.
+   * @param page_id id of page to be prefetched
+   * @param strategy the ring of the calling operation, or nullptr for a normal prefetch
+   */
+  void PrefetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
   /** Number of pages in the buffer pool. */
   const size_t pool_size_;
-  /** The next page id to be allocated  */
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
+  /** The next page id to be allocated; each instance allocates every num_instances_-th id starting at its index */
   std::atomic<page_id_t> next_page_id_ = 0;
-  /** Bucket size for the extendible hash table */
-  const size_t bucket_size_ = 4;
 
   /** Array of buffer pool pages. */
   Page *pages_;
+  /** The page data of all frames; pages_[i] points to frame i. */
+  FrameArena *frame_arena_;
   /** Pointer to the disk manager. */
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
+  /**
+   * Runs disk requests on background threads. A lone blocking read or write is issued inline on disk_manager_, since
+   * handing it to a worker would only add a thread switch; the scheduler is used when requests can overlap, e.g. the
+   * write-back of a dirty victim while the replacing page is read in.
+   */
+  DiskScheduler *disk_scheduler_;
+  /** True if disk_scheduler_ was created by (and must be deleted with) this instance. */
+  const bool owns_disk_scheduler_;
+  /** True if the disk manager cannot write pages. */
+  const bool read_only_;
   /** Pointer to the log manager. Please ignore this for P1. */
   LogManager *log_manager_ __attribute__((__unused__));
-  /** Page table for keeping track of buffer pool pages. */
-  ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
+  /**
+   * Page table for keeping track of buffer pool pages. The pin count, the dirty flag and the evictable flag in the
+   * replacer of a resident page only change with the page's stripe latch held, so a fetch that hits or an unpin does
+   * not need latch_.
+   */
+  PageTable *page_table_;
   /** Replacer to find unpinned pages for replacement. */
   LRUKReplacer *replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
+  /**
+   * This latch serializes changes to the set of resident pages (adding and removing page table entries, evicting from
+   * the replacer, the free list, page ids) and protects the I/O bookkeeping below. It is never held across a disk read
+   * or write. Lock order: latch_, then a page table stripe, then the replacer.
+   */
   std::mutex latch_;
+  /**
+   * io_in_progress_[i] is true while frame i is being written back and/or read in with latch_ released. It is set and
+   * cleared under latch_, but read without it on the hit path.
+   */
+  std::atomic<bool> *io_in_progress_;
+  /** io_cv_[i] is signalled when the I/O on frame i completes; waiters re-check io_in_progress_[i] under latch_. */
+  std::condition_variable *io_cv_;
+  /** Pages evicted dirty whose write-back is still in flight. They must not be read back until it completes. */
+  std::unordered_set<page_id_t> writeback_pages_;
+  /** Signalled whenever a page leaves writeback_pages_. */
+  std::condition_variable writeback_cv_;
+
+  /** Number of dirty victims written back on the eviction path. */
+  std::atomic<size_t> foreground_writes_{0};
+  /** Number of pages written back by the page cleaner. */
+  std::atomic<size_t> background_writes_{0};
+  /** Number of prefetch reads started. */
+  std::atomic<size_t> prefetch_reads_{0};
+  /** Number of fetches that found their page resident. */
+  std::atomic<size_t> fetch_hits_{0};
+  /** Number of fetches that read their page from disk. */
+  std::atomic<size_t> fetch_misses_{0};
+  /** Number of fetch misses served as a view. */
+  std::atomic<size_t> view_fetches_{0};
+  /** The page cleaner thread, if started. */
+  std::thread page_cleaner_thread_;
+  /** True while the page cleaner should keep running; protected by page_cleaner_latch_. */
+  bool page_cleaner_running_{false};
+  /** Set when an eviction had to write a dirty page, to wake the cleaner before its interval elapses. */
+  bool page_cleaner_wakeup_{false};
+  /** Protects page_cleaner_running_ and page_cleaner_wakeup_. Never held together with latch_ in the cleaner. */
+  std::mutex page_cleaner_latch_;
+  std::condition_variable page_cleaner_cv_;
 
   /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Allocate a page on disk, reusing a page the disk manager has free before growing the file. Caller should
+   * acquire the latch before calling this function.
    * @return the id of the allocated page
    */
   auto AllocatePage() -> page_id_t;
 
+  /**
+   * @brief Validate that the page_id being used is accessible to this BPI, i.e. that it maps to instance_index_.
+   * @param page_id the page id to validate
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
+  /**
+   * @brief Take a frame from the free list, or evict one from the replacer. Caller must hold latch_.
+   *
+   * An evicted page is removed from the page table. If it is dirty, its id is added to writeback_pages_ and returned
+   * through victim_page_id; the caller must write the frame's current contents back to that page, with latch_
+   * released, before reusing the frame, and then call FinishIo(). A victim that a concurrent hit pinned after the
+   * replacer chose it is handed back to the replacer and the next one is tried.
+   *
+   * @param[out] frame_id the frame to reuse
+   * @param[out] victim_page_id the dirty page that must be written back, or INVALID_PAGE_ID
+   * @param allow_dirty_victim if false, give up instead of evicting a dirty page
+   * @return false if all frames are pinned, true otherwise
+   */
+  auto AcquireFrame(frame_id_t *frame_id, page_id_t *victim_page_id, bool allow_dirty_victim = true) -> bool;
+
+  /**
+   * @brief Pin a resident page with only its page table stripe latched.
+   * @param page_id the page to pin
+   * @param record_access true to record the access in the replacer
+   * @param[out] frame_id the frame holding the page, if it is resident
+   * @return true if the page was resident and has been pinned
+   */
+  auto PinResident(page_id_t page_id, bool record_access, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Wait until the I/O on a pinned frame has completed. Caller must not hold latch_.
+   * @param frame_id the frame
+   */
+  void WaitForIo(frame_id_t frame_id);
+
+  /**
+   * @brief Mark the I/O on a frame as complete and wake up everyone waiting for it. Caller must hold latch_.
+   * @param frame_id the frame whose I/O finished
+   * @param victim_page_id the page that was written back from the frame, or INVALID_PAGE_ID
+   */
+  void FinishIo(frame_id_t frame_id, page_id_t victim_page_id);
+
+  /**
+   * @brief Unmap a page whose read failed from its frame, before the I/O on the frame is finished. Fetchers that pinned
+   * the frame while the read was in flight find the frame holds no page once they wake up. Caller must hold latch_.
+   * @param frame_id the frame the page was read into
+   * @param page_id the page
+   */
+  void DropFailedRead(frame_id_t frame_id, page_id_t page_id);
+
+  /**
+   * @brief Drop a pin on a frame whose read failed. The last pin returns the frame to the free list. If RestoreVictim()
+   * gave the frame back to its victim, the pin is dropped under the victim's page table stripe instead, since hits on
+   * the victim pin it without latch_. Caller must hold latch_.
+   * @param frame_id the frame
+   */
+  void ReleaseFailedPin(frame_id_t frame_id);
+
+  /**
+   * @brief Give a frame back to the dirty victim whose write-back failed, in place of the page it was taken for, and
+   * drop the caller's pin. The frame must hold the victim's data again. Fetchers that pinned the frame for page_id
+   * find it holds another page once they wake up. Caller must hold latch_.
+   * @param frame_id the frame
+   * @param page_id the page the frame was taken for
+   * @param victim_page_id the victim, which stays resident and dirty
+   */
+  void RestoreVictim(frame_id_t frame_id, page_id_t page_id, page_id_t victim_page_id);
+
+  /**
+   * @brief Hand a page read or write to the disk scheduler without waiting for it.
+   * @param is_write true for a write, false for a read
+   * @param page_id the page to read or write
+   * @param data the buffer to read into or write from; must stay valid until the returned future is ready
+   * @return a future that becomes ready when the request has completed
+   */
+  auto ScheduleIo(bool is_write, page_id_t page_id, char *data) -> std::future<bool>;
+
+  /**
+   * @brief Append a page that was read in on behalf of a strategy to its ring, and release the oldest pages of the
+   * ring until it fits again. Caller must not hold latch_: the released pages may belong to other instances.
+   * @param strategy the strategy the page was read for
+   * @param page_id the page that was read
+   */
+  void AddToRing(BufferAccessStrategy *strategy, page_id_t page_id);
+
+  /**
+   * @brief Drop a page that fell out of a strategy's ring from the pool and put its frame at the front of the free
+   * list, writing it back first if it is dirty. Pages that are pinned, still being read, or that have been accessed
+   * more than once (i.e. by somebody other than the ring) stay where they are.
+   * @param page_id the page to release
+   */
+  void ReleaseRingPage(page_id_t page_id);
+
+  /** @brief Return true if a frame serves a view of the disk manager's memory instead of its own. */
+  auto IsView(frame_id_t frame_id) -> bool { return pages_[frame_id].data_ != frame_arena_->GetFrame(frame_id); }
+
+  /** @brief Point a frame back at its own memory, after it served a view. Caller must hold latch_. */
+  void DetachView(frame_id_t frame_id) { pages_[frame_id].data_ = frame_arena_->GetFrame(frame_id); }
+
+  /** @brief The page cleaner thread's loop. */
+  void RunPageCleaner();
+
+  /** @brief Wake the page cleaner early, if it is running. */
+  void WakePageCleaner();
+
   /**
    * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
+  void DeallocatePage(page_id_t page_id) { disk_manager_->DeallocatePage(page_id); }
+
+  /**
+   * @brief Check that page_id is a page this instance handed out and has not deallocated since. Only such a page may
+   * be deallocated: any other would enter the free pages of the wrong instance, or be handed out twice. Caller should
+   * acquire the latch before calling this function.
+   * @param page_id the page id to check
+   * @return true if the page is allocated and owned by this instance
+   */
+  auto IsAllocatedPage(page_id_t page_id) -> bool {
+    return page_id >= 0 && static_cast<uint32_t>(page_id) % num_instances_ == instance_index_ &&
+           page_id < next_page_id_ && !disk_manager_->IsPageFree(page_id);
   }
 
   // TODO(student): You may add additional private members and helper functions
@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_arena.h
+//
+// Identification: src/include/buffer/frame_arena.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * FrameArena holds the page data of all frames of a buffer pool in one contiguous region.
+ *
+ * With a heap allocation every 4KB frame needs its own TLB entry, so random accesses across a pool of many gigabytes
+ * miss the TLB on almost every page. Backed by 2MB huge pages, the same pool needs 512 times fewer entries. The region
+ * can also be interleaved across, or bound to, NUMA nodes before any of it is touched.
+ *
+ * If the requested kind of memory is not available (no huge pages reserved, madvise or mbind unsupported), the arena
+ * falls back to the next weaker kind and logs a warning; GetMemory() returns what was actually used.
+ */
+class FrameArena {
+ public:
+  /**
+   * @brief Allocate the frames of a buffer pool. The memory is zeroed.
+   * @param num_frames number of BUSTUB_PAGE_SIZE frames
+   * @param memory the kind of memory to allocate
+   * @param numa_policy the NUMA placement of the region; ignored for FrameMemory::HEAP
+   * @param numa_nodes bit mask of the nodes for numa_policy, 0 for all nodes the process may allocate on
+   */
+  FrameArena(size_t num_frames, FrameMemory memory, FrameNumaPolicy numa_policy = FrameNumaPolicy::DEFAULT,
+             uint64_t numa_nodes = 0);
+
+  DISALLOW_COPY_AND_MOVE(FrameArena);
+
+  /** @brief Release the region. */
+  ~FrameArena();
+
+  /** @return the page data of a frame */
+  auto GetFrame(frame_id_t frame_id) -> char * { return data_ + static_cast<size_t>(frame_id) * BUSTUB_PAGE_SIZE; }
+
+  /** @return the kind of memory the region was actually allocated from */
+  auto GetMemory() const -> FrameMemory { return memory_; }
+
+ private:
+  /** @brief Map an anonymous region of mapped_size_ bytes; with alignment > 0, its start is aligned to it. */
+  auto Map(int extra_flags, size_t alignment) -> char *;
+
+  /** @brief Apply a NUMA policy to the region before it is first touched. */
+  void ApplyNumaPolicy(FrameNumaPolicy numa_policy, uint64_t numa_nodes);
+
+  /** Start of the region. */
+  char *data_{nullptr};
+  /** Bytes used by the frames. */
+  const size_t size_;
+  /** Bytes mapped, i.e. size_ rounded up to whole huge pages; 0 for a heap allocation. */
+  size_t mapped_size_{0};
+  FrameMemory memory_;
+};
+
+}  // namespace bustub
@@ -12,10 +12,8 @@
 
 #pragma once
 
-#include <limits>
-#include <list>
-#include <memory>
 #include <mutex>  // NOLINT
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -34,6 +32,9 @@ namespace bustub {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward k-distance,
  * classical LRU algorithm is used to choose victim.
+ *
+ * Only evictable frames are kept in the two ordered sets the victim is chosen from, so pinned frames cost nothing at
+ * eviction time, and Evict(), RecordAccess(), SetEvictable() and Remove() are all O(log n).
  */
 class LRUKReplacer {
  public:
@@ -124,6 +125,24 @@ class LRUKReplacer {
    */
   void Remove(frame_id_t frame_id);
 
+  /**
+   * @brief Return up to max_frames evictable frames, in the order Evict() would choose them, without evicting them.
+   * Used by the page cleaner to find the frames that are about to be reused.
+   *
+   * @param max_frames maximum number of frames to return
+   * @return the coldest evictable frames, coldest first
+   */
+  auto GetEvictionCandidates(size_t max_frames) -> std::vector<frame_id_t>;
+
+  /**
+   * @brief Return how many accesses of a frame the replacer remembers, at most k. Used to tell pages that only a
+   * buffer access strategy has touched from pages other queries are using.
+   *
+   * @param frame_id id of the frame
+   * @return the number of recorded accesses, or 0 if the frame is not tracked
+   */
+  auto GetAccessCount(frame_id_t frame_id) -> size_t;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -133,27 +152,41 @@ class LRUKReplacer {
    */
   auto Size() -> size_t;
 
-  struct Info {
-    explicit Info(frame_id_t fid = -1, bool unpin = true) : frame_id_(fid), unpin_(unpin) {}
-    frame_id_t frame_id_;
-    bool unpin_;
-    Info *pre_{nullptr};
-    Info *nxt_{nullptr};
-    std::list<size_t> record_;
+  /** Per-frame bookkeeping. A frame is tracked by the replacer iff it has at least one recorded access. */
+  struct LRUKNode {
+    /** Total number of accesses recorded since the frame was last evicted or removed. */
+    size_t num_accesses_{0};
+    /** Frames are evictable until told otherwise. */
+    bool is_evictable_{true};
   };
 
+  /** (timestamp, frame id) pairs ordering the evictable frames; the first element is evicted first. */
+  using EvictionKey = std::pair<size_t, frame_id_t>;
+
+  /**
+   * @brief Return the key a tracked frame is ordered by: its first access while it has fewer than k accesses
+   * (LRU among +inf distances), and its k-th most recent access afterwards. Caller must hold latch_.
+   */
+  auto GetEvictionKey(frame_id_t frame_id) const -> EvictionKey;
+
+  /** @brief Return the set an evictable, tracked frame belongs to. Caller must hold latch_. */
+  auto GetEvictableSet(frame_id_t frame_id) -> std::set<EvictionKey> &;
+
   // private:
   // TODO(student): implement me! You can replace these member variables as you like.
   // Remove maybe_unused if you start using them.
   size_t current_timestamp_{0};
   size_t curr_size_{0};
-  size_t siz0_{0};
-  size_t siz1_{0};
   const size_t replacer_size_;
   const size_t k_;
   std::mutex latch_;
-  Info *head0_, *head1_;
-  std::vector<std::shared_ptr<Info>> dir0_, dir1_;
+  std::vector<LRUKNode> node_store_;
+  /** The last k access timestamps of frame f, as a circular buffer at access_history_[f * k_, (f + 1) * k_). */
+  std::vector<size_t> access_history_;
+  /** Evictable frames with fewer than k accesses, i.e. with +inf backward k-distance. */
+  std::set<EvictionKey> history_;
+  /** Evictable frames with at least k accesses. */
+  std::set<EvictionKey> cache_;
 };
 
 }  // namespace bustub
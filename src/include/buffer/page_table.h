@@ -0,0 +1,154 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_table.h
+//
+// Identification: src/include/buffer/page_table.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+/**
+ * PageTable maps the ids of the pages resident in a buffer pool to the frames holding them.
+ *
+ * The table is split into a power-of-two number of stripes, each with its own latch, so that lookups of different
+ * pages rarely contend. A stripe is a flat array of (page id, frame id) slots using open addressing with linear probing
+ * and backward-shift deletion, so a lookup touches one or two cache lines and no heap nodes. A stripe doubles when it
+ * becomes half full.
+ *
+ * Apply() and RemoveIf() run a callback while the stripe latch of the page is held. The buffer pool uses this to make
+ * pinning a page atomic with respect to removing it from the table, which lets it serve hits without its pool-wide
+ * latch.
+ */
+class PageTable {
+ public:
+  /**
+   * @brief Create a new, empty page table.
+   * @param expected_entries the number of mappings the table is sized for up front, i.e. the pool size
+   * @param num_stripes the number of independently latched stripes, rounded up to a power of two
+   */
+  explicit PageTable(size_t expected_entries, size_t num_stripes = PAGE_TABLE_STRIPES);
+
+  DISALLOW_COPY_AND_MOVE(PageTable);
+
+  ~PageTable() = default;
+
+  /**
+   * @brief Find the frame holding a page.
+   * @param page_id the page to look up
+   * @param[out] frame_id the frame holding the page, if found
+   * @return true if the page is in the table
+   */
+  auto Find(page_id_t page_id, frame_id_t *frame_id) -> bool;
+
+  /**
+   * @brief Map a page to a frame, replacing an existing mapping of the page.
+   * @param page_id the page
+   * @param frame_id the frame holding it
+   */
+  void Insert(page_id_t page_id, frame_id_t frame_id);
+
+  /**
+   * @brief Remove the mapping of a page.
+   * @param page_id the page
+   * @return true if the page was in the table
+   */
+  auto Remove(page_id_t page_id) -> bool {
+    return RemoveIf(page_id, [](frame_id_t /* frame_id */) { return true; });
+  }
+
+  /**
+   * @brief Call f(frame_id) with the stripe latch of page_id held, if the page is in the table.
+   * @param page_id the page to look up
+   * @param f the callback; it must not call back into the page table
+   * @return true if the page is in the table (and f was called)
+   */
+  template <typename F>
+  auto Apply(page_id_t page_id, F &&f) -> bool {
+    Stripe &stripe = GetStripe(page_id);
+    std::scoped_lock<std::mutex> lock(stripe.latch_);
+    size_t slot = FindSlot(stripe, page_id);
+    if (slot == NOT_FOUND) {
+      return false;
+    }
+    f(stripe.slots_[slot].frame_id_);
+    return true;
+  }
+
+  /**
+   * @brief Remove the mapping of a page if pred(frame_id), evaluated with the stripe latch of page_id held, is true.
+   * @param page_id the page to remove
+   * @param pred the condition; it must not call back into the page table
+   * @return true if the mapping was removed
+   */
+  template <typename Pred>
+  auto RemoveIf(page_id_t page_id, Pred &&pred) -> bool {
+    Stripe &stripe = GetStripe(page_id);
+    std::scoped_lock<std::mutex> lock(stripe.latch_);
+    size_t slot = FindSlot(stripe, page_id);
+    if (slot == NOT_FOUND || !pred(stripe.slots_[slot].frame_id_)) {
+      return false;
+    }
+    EraseSlot(stripe, slot);
+    return true;
+  }
+
+ private:
+  struct Slot {
+    page_id_t page_id_{INVALID_PAGE_ID};
+    frame_id_t frame_id_{-1};
+  };
+
+  /** A stripe sits on its own cache lines, so that latching one does not slow down its neighbours. */
+  struct alignas(64) Stripe {
+    std::mutex latch_;
+    std::vector<Slot> slots_;
+    /** slots_.size() == 1 << capacity_bits_ */
+    size_t capacity_bits_{0};
+    size_t size_{0};
+  };
+
+  static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+  /** @brief Fibonacci hashing; page ids are dense and often strided, so the high bits of the product are used. */
+  static auto Hash(page_id_t page_id) -> uint64_t {
+    return static_cast<uint64_t>(static_cast<uint32_t>(page_id)) * 0x9E3779B97F4A7C15ULL;
+  }
+
+  auto GetStripe(page_id_t page_id) -> Stripe & {
+    return stripes_[stripe_bits_ == 0 ? 0 : Hash(page_id) >> (64 - stripe_bits_)];
+  }
+
+  /** @brief Return the slot a page would occupy in a stripe without collisions. */
+  auto HomeSlot(const Stripe &stripe, page_id_t page_id) const -> size_t {
+    return (Hash(page_id) << stripe_bits_) >> (64 - stripe.capacity_bits_);
+  }
+
+  /** @brief Return the slot holding page_id in a stripe, or NOT_FOUND. Caller must hold the stripe latch. */
+  auto FindSlot(const Stripe &stripe, page_id_t page_id) const -> size_t;
+
+  /** @brief Empty a slot and shift the following entries of its probe sequence back. Caller must hold the latch. */
+  void EraseSlot(Stripe &stripe, size_t slot);
+
+  /** @brief Double the capacity of a stripe and rehash its entries. Caller must hold the stripe latch. */
+  void Grow(Stripe &stripe);
+
+  /** log2 of the number of stripes. */
+  size_t stripe_bits_{0};
+  std::vector<Stripe> stripes_;
+};
+
+}  // namespace bustub
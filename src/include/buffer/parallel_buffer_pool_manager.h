@@ -0,0 +1,166 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/config.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_scheduler.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager splits the buffer pool into several independent BufferPoolManagerInstance shards, each
+ * with its own latch, page table and replacer. A page always lives in shard `page_id % num_instances`, and new pages
+ * are handed out round-robin across the shards so that concurrent threads rarely contend on the same latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * @brief Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to create
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager shared by all instances
+   * @param replacer_k the lookback constant k for the LRU-K replacer of each instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr);
+
+  /**
+   * @brief Destroy an existing ParallelBufferPoolManager and all of its instances.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @brief Return the total size (number of frames) of all the buffer pool instances. */
+  auto GetPoolSize() -> size_t override { return num_instances_ * pool_size_; }
+
+  /** @brief Return the number of buffer pool instances. */
+  auto GetNumInstances() -> size_t { return num_instances_; }
+
+  /**
+   * @brief Return the buffer pool instance responsible for the given page id.
+   * @param page_id id of the page
+   * @return the instance that owns page_id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /** @brief Start a page cleaner on every instance. */
+  void StartPageCleaner();
+
+  /** @brief Stop the page cleaners of all instances. */
+  void StopPageCleaner();
+
+  /** @brief Return the number of dirty victims written back on the eviction path, summed over all instances. */
+  auto GetForegroundWrites() const -> size_t;
+
+  /** @brief Return the number of pages written back by the page cleaners, summed over all instances. */
+  auto GetBackgroundWrites() const -> size_t;
+
+  /** @brief Return the number of fetches that found their page resident, summed over all instances. */
+  auto GetFetchHits() const -> size_t;
+
+  /** @brief Return the number of fetches that read their page from disk, summed over all instances. */
+  auto GetFetchMisses() const -> size_t;
+
+ protected:
+  /**
+   * @brief Create a new page. Instances are tried round-robin, starting from the one after the instance used by the
+   * previous call, until one of them has a free or evictable frame.
+   * @param[out] page_id id of created page
+   * @return nullptr if no instance could create a new page, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /**
+   * @brief Fetch the requested page from the instance that owns it.
+   * @param page_id id of page to be fetched
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * @brief Fetch the requested page from the instance that owns it, on behalf of a buffer access strategy. The ring of
+   * the strategy may span several instances.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring of the calling operation, or nullptr for a normal fetch
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief Unpin the target page in the instance that owns it.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page is not in the page table or its pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * @brief Flush the target page in the instance that owns it.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Flush all the pages of every instance to disk.
+   */
+  void FlushAllPgsImp() override;
+
+  /**
+   * @brief Delete the target page from the instance that owns it.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * @brief Delete the target page from the instance that owns it, telling why it could not be deleted.
+   * @param page_id id of page to be deleted
+   * @return whether the page was deleted, and if not, why
+   */
+  auto TryDeletePgImp(page_id_t page_id) -> DeletePageResult override;
+
+  /**
+   * @brief Prefetch the target page into the instance that owns it.
+   * @param page_id id of page to be prefetched
+   */
+  void PrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * @brief Prefetch the target page into the instance that owns it, on behalf of a buffer access strategy.
+   * @param page_id id of page to be prefetched
+   * @param strategy the ring of the calling operation, or nullptr for a normal prefetch
+   */
+  void PrefetchPgImp(page_id_t page_id, BufferAccessStrategy *strategy) override;
+
+ private:
+  /** Number of buffer pool instances. */
+  const size_t num_instances_;
+  /** Number of frames in each instance. */
+  const size_t pool_size_;
+  /** One disk scheduler for all instances, so the number of I/O threads does not grow with the shard count. */
+  DiskScheduler *disk_scheduler_;
+  /** The buffer pool instances, indexed by instance_index. */
+  std::vector<BufferPoolManagerInstance *> instances_;
+  /** The instance NewPgImp starts searching from. */
+  std::atomic<size_t> next_instance_{0};
+};
+}  // namespace bustub
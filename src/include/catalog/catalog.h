@@ -24,6 +24,7 @@
 #include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
+#include "storage/index/key_normalizer.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -136,7 +137,7 @@ class Catalog {
     // When create_table_heap == false, it means that we're running binder tests (where no txn will be provided) or
     // we are running shell without buffer pool. We don't need to create TableHeap in this case.
     if (create_table_heap) {
-      table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn);
+      table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn, &schema);
     }
 
     // Fetch the table OID for the new table
@@ -217,6 +218,13 @@ class Catalog {
       return NULL_INDEX_INFO;
     }
 
+    // Reject a key type too small for every key of the schema and its RID. Varchar keys are checked per key instead,
+    // as their declared length is only an upper bound.
+    if (key_schema.IsInlined() &&
+        KeyNormalizer::GetNormalizedSize(key_schema) + KeyNormalizer::RID_SIZE > sizeof(KeyType)) {
+      return NULL_INDEX_INFO;
+    }
+
     // Construct index metdata
     auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
 
@@ -228,12 +236,22 @@ class Catalog {
     // TODO(chi): support both hash index and btree index
     auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
 
-    // Populate the index with all tuples in table heap
+    // Populate the index with all tuples in table heap. Build it bottom-up from the sorted keys rather than inserting
+    // them one by one, which would descend the tree and split pages for every tuple.
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
+    std::vector<std::pair<KeyType, RID>> entries;
     for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+      auto key = tuple->KeyFromTuple(schema, key_schema, key_attrs);
+      // Reject the index if the key of an existing tuple is too long for it
+      if (!index->KeyFits(key)) {
+        return NULL_INDEX_INFO;
+      }
+      KeyType index_key;
+      index_key.SetFromKey(key, key_schema, tuple->GetRid());
+      entries.emplace_back(index_key, tuple->GetRid());
     }
+    index->BulkLoad(&entries);
 
     // Get the next OID for the new index
     const auto index_oid = next_index_oid_.fetch_add(1);
@@ -250,6 +268,32 @@ class Catalog {
     return tmp;
   }
 
+  /**
+   * Create a new B+ tree index whose keys are the smallest GenericKey that holds the normalized key followed by the
+   * RID, see KeyNormalizer. Keys with varchars that do not fit in 64 bytes this way fail to insert.
+   * @param txn The transaction in which the table is being created
+   * @param index_name The name of the new index
+   * @param table_name The name of the table
+   * @param schema The schema of the table
+   * @param key_schema The schema of the key
+   * @param key_attrs Key attributes
+   * @return A (non-owning) pointer to the metadata of the new table
+   */
+  auto CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name, const Schema &schema,
+                   const Schema &key_schema, const std::vector<uint32_t> &key_attrs) -> IndexInfo * {
+    auto key_size = KeyNormalizer::GetNormalizedSize(key_schema) + KeyNormalizer::RID_SIZE;
+    if (key_size <= 16) {
+      return CreateIndex<GenericKey<16>, RID, GenericComparator<16>>(txn, index_name, table_name, schema, key_schema,
+                                                                     key_attrs, 16, HashFunction<GenericKey<16>>{});
+    }
+    if (key_size <= 32) {
+      return CreateIndex<GenericKey<32>, RID, GenericComparator<32>>(txn, index_name, table_name, schema, key_schema,
+                                                                     key_attrs, 32, HashFunction<GenericKey<32>>{});
+    }
+    return CreateIndex<GenericKey<64>, RID, GenericComparator<64>>(txn, index_name, table_name, schema, key_schema,
+                                                                   key_attrs, 64, HashFunction<GenericKey<64>>{});
+  }
+
   /**
    * Get the index `index_name` for table `table_name`.
    * @param index_name The name of the index for which to query
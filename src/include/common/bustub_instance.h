@@ -12,12 +12,15 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
 #include <iostream>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <optional>
 #include <shared_mutex>
 #include <sstream>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -241,6 +244,18 @@ class BustubInstance {
    */
   void GenerateMockTable();
 
+  /**
+   * Vacuum every table, see TableHeap::Vacuum. Used by the `\vacuum` command and the background vacuum.
+   * @return the name of every table and the number of bytes reclaimed from it
+   */
+  auto VacuumTables() -> std::vector<std::pair<std::string, size_t>>;
+
+  /** Start vacuuming all tables every vacuum_interval in a background thread. Started already if enable_vacuum. */
+  void StartVacuum();
+
+  /** Stop the background vacuum, if it is running. */
+  void StopVacuum();
+
   // TODO(chi): change to unique_ptr. Currently they're directly referenced by recovery test, so
   // we cannot do anything on them until someone decides to refactor the recovery test.
 
@@ -270,8 +285,17 @@ class BustubInstance {
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
+  void CmdVacuum(ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
   std::unordered_map<std::string, std::string> session_variables_;
+
+  /** Background vacuum loop: vacuum all tables every vacuum_interval until StopVacuum. */
+  void RunVacuum();
+
+  std::thread vacuum_thread_;
+  std::mutex vacuum_latch_;
+  std::condition_variable vacuum_cv_;
+  bool vacuum_running_{false};
 };
 
 }  // namespace bustub
@@ -27,15 +27,87 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** True if BustubInstance should start a page cleaner thread for its buffer pool. */
+extern std::atomic<bool> enable_page_cleaner;
+
+/** The page cleaner wakes up every PAGE_CLEANER_INTERVAL, or earlier when an eviction had to write a dirty page. */
+extern std::chrono::milliseconds page_cleaner_interval;
+
+/** The page cleaner tries to keep this fraction of the buffer pool's frames clean at the cold end of the replacer. */
+extern double page_cleaner_clean_ratio;
+
+/** True if BustubInstance should start a thread that vacuums all tables in the background. */
+extern std::atomic<bool> enable_vacuum;
+
+/** The background vacuum goes over all tables every VACUUM_INTERVAL. */
+extern std::chrono::milliseconds vacuum_interval;
+
+/** A sequential scan over a table with more pages than this fraction of the buffer pool uses a ring of frames. */
+extern double seq_scan_ring_threshold;
+
+/** Fraction of each page a bulk-loaded B+ tree fills, leaving the rest for later inserts. */
+extern double index_fill_factor;
+
+/** Memory backing the frames of a buffer pool. */
+enum class FrameMemory {
+  /** One heap allocation, aligned to DIRECT_IO_ALIGNMENT. */
+  HEAP,
+  /** One anonymous mmap region with base pages. */
+  MMAP,
+  /** One 2MB-aligned mmap region the kernel is advised to back with transparent huge pages. */
+  TRANSPARENT_HUGE_PAGES,
+  /** One mmap region backed by huge pages reserved through vm.nr_hugepages; falls back to transparent huge pages. */
+  EXPLICIT_HUGE_PAGES,
+};
+
+/** NUMA placement of the frames of a buffer pool. Only applies to the mmap based kinds of FrameMemory. */
+enum class FrameNumaPolicy {
+  /** Leave placement to the kernel (first touch). */
+  DEFAULT,
+  /** Spread the frames page by page across the nodes in frame_numa_nodes. */
+  INTERLEAVE,
+  /** Allocate the frames only on the nodes in frame_numa_nodes. */
+  BIND,
+};
+
+/** How a new buffer pool allocates its frames. */
+extern FrameMemory frame_memory;
+
+/** Where a new buffer pool places its frames on a NUMA machine. */
+extern FrameNumaPolicy frame_numa_policy;
+
+/** Bit mask of the NUMA nodes used by FRAME_NUMA_POLICY; 0 means all nodes the process may allocate on. */
+extern uint64_t frame_numa_nodes;
+
+/**
+ * The page size is a build option (cmake -DBUSTUB_PAGE_SIZE=...). Every page layout derives its capacity from it, so a
+ * db file can only be opened by a build with the same page size. The last PAGE_CHECKSUM_SIZE bytes of a page hold the
+ * checksum the disk manager stamps on it; page layouts keep to the first BUSTUB_PAGE_DATA_SIZE bytes.
+ */
+#ifndef BUSTUB_PAGE_SIZE_CONFIG
+#define BUSTUB_PAGE_SIZE_CONFIG 4096
+#endif
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
 static constexpr int HEADER_PAGE_ID = 0;                                             // the header page id
-static constexpr int BUSTUB_PAGE_SIZE = 4096;                                        // size of a data page in byte
+static constexpr int BUSTUB_PAGE_SIZE = BUSTUB_PAGE_SIZE_CONFIG;                     // size of a data page in byte
+static constexpr int PAGE_CHECKSUM_SIZE = 4;                                         // size of a page checksum in byte
+static constexpr int BUSTUB_PAGE_DATA_SIZE = BUSTUB_PAGE_SIZE - PAGE_CHECKSUM_SIZE;  // bytes of a page layouts use
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
 static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int DISK_SCHEDULER_WORKERS = 16;  // number of I/O threads per disk scheduler
+static constexpr int SEQ_SCAN_RING_SIZE = 4;       // number of frames a large sequential scan cycles through
+static constexpr int PAGE_TABLE_STRIPES = 16;      // number of separately latched stripes of a page table
+static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;  // size of a huge page in byte
+static constexpr size_t DIRECT_IO_ALIGNMENT = 4096;  // alignment of the buffers, offsets and lengths of O_DIRECT I/O
+static constexpr int OVERFLOW_TUPLE_THRESHOLD = BUSTUB_PAGE_SIZE / 4;  // larger tuples keep big varchars out of line
+
+static_assert(BUSTUB_PAGE_SIZE >= 4096 && BUSTUB_PAGE_SIZE <= 65536 && (BUSTUB_PAGE_SIZE & (BUSTUB_PAGE_SIZE - 1)) == 0,
+              "BUSTUB_PAGE_SIZE must be a power of 2 between 4K and 64K");
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
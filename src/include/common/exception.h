@@ -49,6 +49,10 @@ enum class ExceptionType {
   NOT_IMPLEMENTED = 11,
   /** Execution exception. */
   EXECUTION = 12,
+  /** A page on disk could not be read, or failed its checksum. */
+  CORRUPTION = 13,
+  /** A page could not be written to disk. */
+  IO = 14,
 };
 
 class Exception : public std::runtime_error {
@@ -104,6 +108,10 @@ class Exception : public std::runtime_error {
         return "Out of Memory";
       case ExceptionType::NOT_IMPLEMENTED:
         return "Not implemented";
+      case ExceptionType::CORRUPTION:
+        return "Corruption";
+      case ExceptionType::IO:
+        return "I/O";
       default:
         return "Unknown";
     }
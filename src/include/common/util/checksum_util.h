@@ -0,0 +1,38 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// checksum_util.h
+//
+// Identification: src/include/common/util/checksum_util.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * ChecksumUtil computes the checksums that guard pages on disk.
+ */
+class ChecksumUtil {
+ public:
+  /**
+   * Compute the CRC32C (Castagnoli) of a buffer. Uses the CRC32 instruction of SSE4.2 or ARMv8 when the CPU has it,
+   * and a lookup table otherwise.
+   * @param data the buffer
+   * @param len the length of the buffer in bytes
+   * @return the checksum
+   */
+  static auto Crc32c(const char *data, size_t len) -> uint32_t;
+
+  /** @return true if Crc32c uses a CRC32 instruction */
+  static auto IsHardwareAccelerated() -> bool;
+};
+
+}  // namespace bustub
@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compression_util.h
+//
+// Identification: src/include/common/util/compression_util.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bustub {
+
+/**
+ * CompressionUtil compresses pages on their way to disk with a small LZ77 codec in the style of LZ4: a sequence of
+ * literals followed by a back reference of at least 4 bytes into the last 64KB. It favors speed over ratio, and the
+ * long runs of zeroes and the repeated bytes of integer columns in table pages compress very well.
+ *
+ * Compressed format, a list of sequences (size in bytes):
+ *  -------------------------------------------------------------------------------------------------------
+ *  | Token (1) | LiteralLength (0+) | Literals | Offset (2) | MatchLength (0+) | Token (1) | ... | Literals |
+ *  -------------------------------------------------------------------------------------------------------
+ *  The high nibble of the token is the number of literals, the low nibble the match length minus 4. A nibble of 15 is
+ *  continued by bytes that are added to it up to and including the first byte that is not 255. The last sequence has
+ *  literals only.
+ */
+class CompressionUtil {
+ public:
+  /**
+   * Compress a buffer.
+   * @param src the buffer
+   * @param len the length of the buffer in bytes, at most 64KB
+   * @param[out] dst the compressed data
+   * @param capacity the size of dst in bytes
+   * @return the length of the compressed data, or 0 if it does not fit into capacity bytes
+   */
+  static auto Compress(const char *src, size_t len, char *dst, size_t capacity) -> size_t;
+
+  /**
+   * Decompress a buffer that Compress() produced.
+   * @param src the compressed data
+   * @param len the length of the compressed data in bytes
+   * @param[out] dst the decompressed data
+   * @param dst_len the length of the decompressed data in bytes
+   * @return false if the compressed data is malformed or does not decompress into exactly dst_len bytes
+   */
+  static auto Decompress(const char *src, size_t len, char *dst, size_t dst_len) -> bool;
+};
+
+}  // namespace bustub
@@ -46,7 +46,9 @@ class IndexScanExecutor : public AbstractExecutor {
   const IndexScanPlanNode *plan_;
   const IndexInfo *index_info_;
   const TableInfo *table_info_;
-  BPlusTreeIndexForOneIntegerColumn *index_;
-  BPlusTreeIndexIteratorForOneIntegerColumn iter_;
+  /** The RIDs of the entries within the bounds of the plan, in key order */
+  std::vector<RID> rids_;
+  /** The next entry of rids_ to emit */
+  size_t cursor_{0};
 };
 }  // namespace bustub
@@ -48,11 +48,21 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   auto Next(Tuple *tuple, RID *rid) -> bool override;
 
  private:
+  /** @return the current outer tuple joined with rhs, or with NULLs if rhs is nullptr */
+  auto JoinTuples(const Tuple *rhs) const -> Tuple;
+
   /** The nested index join plan node. */
   const NestedIndexJoinPlanNode *plan_;
   std::unique_ptr<AbstractExecutor> child_;
   const IndexInfo *index_info_;
   const TableInfo *table_info_;
-  BPlusTreeIndexForOneIntegerColumn *tree_;
+  /** The current outer tuple */
+  Tuple lhs_;
+  /** The RIDs of the inner tuples whose key matches the current outer tuple */
+  std::vector<RID> rids_;
+  /** The next entry of rids_ to join */
+  size_t cursor_{0};
+  /** Whether the current outer tuple is still to be emitted with NULLs if nothing matches it, for a left join */
+  bool left_pending_{false};
 };
 }  // namespace bustub
@@ -12,8 +12,10 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
+#include "buffer/buffer_access_strategy.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
@@ -50,6 +52,8 @@ class SeqScanExecutor : public AbstractExecutor {
  private:
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
+  /** The ring of frames the scan cycles through if the table is large, so it does not flush the buffer pool. */
+  std::unique_ptr<BufferAccessStrategy> strategy_;
   TableIterator iter_ = {nullptr, RID(), nullptr};
   const TableInfo *table_info_;
 };
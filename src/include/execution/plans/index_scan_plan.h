@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -28,10 +29,21 @@ class IndexScanPlanNode : public AbstractPlanNode {
   /**
    * Creates a new index scan plan node.
    * @param output the output format of this scan plan node
-   * @param table_oid the identifier of table to be scanned
+   * @param index_oid the identifier of the index to be scanned
+   * @param lower_bound the smallest value of the first key column to scan, or nullopt to scan from the first entry
+   * @param lower_inclusive whether entries equal to lower_bound are scanned
+   * @param upper_bound the largest value of the first key column to scan, or nullopt to scan to the last entry
+   * @param upper_inclusive whether entries equal to upper_bound are scanned
    */
-  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid)
-      : AbstractPlanNode(std::move(output), {}), index_oid_(index_oid) {}
+  IndexScanPlanNode(SchemaRef output, index_oid_t index_oid, std::optional<Value> lower_bound = std::nullopt,
+                    bool lower_inclusive = true, std::optional<Value> upper_bound = std::nullopt,
+                    bool upper_inclusive = true)
+      : AbstractPlanNode(std::move(output), {}),
+        index_oid_(index_oid),
+        lower_bound_(std::move(lower_bound)),
+        lower_inclusive_(lower_inclusive),
+        upper_bound_(std::move(upper_bound)),
+        upper_inclusive_(upper_inclusive) {}
 
   auto GetType() const -> PlanType override { return PlanType::IndexScan; }
 
@@ -43,11 +55,23 @@ class IndexScanPlanNode : public AbstractPlanNode {
   /** The table whose tuples should be scanned. */
   index_oid_t index_oid_;
 
-  // Add anything you want here for index lookup
+  /** The bounds on the first key column of the index */
+  std::optional<Value> lower_bound_;
+  bool lower_inclusive_;
+  std::optional<Value> upper_bound_;
+  bool upper_inclusive_;
 
  protected:
   auto PlanNodeToString() const -> std::string override {
-    return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    if (!lower_bound_.has_value() && !upper_bound_.has_value()) {
+      return fmt::format("IndexScan {{ index_oid={} }}", index_oid_);
+    }
+    // A missing bound is open: no entry equals infinity.
+    bool lower_closed = lower_bound_.has_value() && lower_inclusive_;
+    bool upper_closed = upper_bound_.has_value() && upper_inclusive_;
+    return fmt::format("IndexScan {{ index_oid={}, range={}{}, {}{} }}", index_oid_, lower_closed ? '[' : '(',
+                       lower_bound_.has_value() ? lower_bound_->ToString() : "-inf",
+                       upper_bound_.has_value() ? upper_bound_->ToString() : "+inf", upper_closed ? ']' : ')');
   }
 };
 
@@ -55,6 +55,12 @@ class Optimizer {
    */
   auto OptimizeNLJAsIndexJoin(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief optimize a filter over a sequential scan into a filter over an index scan, bounded by the comparisons of
+   * the first index key column with constants.
+   */
+  auto OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /**
    * @brief eliminate always true filter
    */
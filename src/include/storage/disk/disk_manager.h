@@ -15,13 +15,26 @@
 #include <atomic>
 #include <fstream>
 #include <future>  // NOLINT
-#include <mutex>   // NOLINT
+#include <map>
+#include <mutex>  // NOLINT
+#include <set>
 #include <string>
+#include <vector>
 
 #include "common/config.h"
 
 namespace bustub {
 
+/** When a DiskManager makes the pages it writes durable with fdatasync. */
+enum class SyncPolicy {
+  /** Never: the OS writes the pages back whenever it likes, and a crash may lose any of them. */
+  NEVER,
+  /** After every page write, before WritePage() returns. */
+  EVERY_WRITE,
+  /** After every batch of writes, by the write that completes it; SyncPages() syncs an incomplete batch. */
+  BATCH,
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
@@ -37,7 +50,10 @@ class DiskManager {
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  /**
+   * Closes the database file if ShutDown() has not done so already.
+   */
+  virtual ~DiskManager();
 
   /**
    * Shut down the disk manager and close all the file resources.
@@ -45,19 +61,131 @@ class DiskManager {
   void ShutDown();
 
   /**
-   * Write a page to the database file.
+   * Write a page to the database file, with its checksum in the last PAGE_CHECKSUM_SIZE bytes. Blocks until the page
+   * is handed to the OS; safe to call concurrently.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @throws Exception of type IO if the page cannot be written; the page on disk is then left as it was, or torn
    */
   virtual void WritePage(page_id_t page_id, const char *page_data);
 
   /**
-   * Read a page from the database file.
+   * Read a page from the database file, and verify its checksum. Blocks until the data is available; safe to call
+   * concurrently. A page beyond the end of the file reads as zeroes.
    * @param page_id id of the page
    * @param[out] page_data output buffer
+   * @throws Exception of type CORRUPTION if the page cannot be read or does not match its checksum, e.g. because its
+   * last write was torn
    */
   virtual void ReadPage(page_id_t page_id, char *page_data);
 
+  /**
+   * Get the contents of a page without copying them. Only disk managers that keep the db file in memory support this.
+   * @param page_id id of the page
+   * @return a read-only view of the page that stays valid as long as the disk manager, or nullptr if the page must be
+   * read with ReadPage()
+   */
+  virtual auto GetPageView(page_id_t page_id) -> const char * { return nullptr; }
+
+  /** @return true if the db file cannot be written, i.e. WritePage() throws */
+  virtual auto IsReadOnly() -> bool { return false; }
+
+  /**
+   * Hand out a page that was deallocated before, so that its space in the db file is reused instead of the file
+   * growing. The lowest free page id goes first, which keeps the file dense.
+   * @param instance_index only a page with page_id % num_instances == instance_index is handed out, so that every
+   * instance of a parallel buffer pool keeps to its own page ids
+   * @param num_instances the number of buffer pool instances sharing this disk manager
+   * @return the id of the page, or INVALID_PAGE_ID if no suitable page is free
+   */
+  auto AllocateFreePage(uint32_t instance_index = 0, uint32_t num_instances = 1) -> page_id_t;
+
+  /**
+   * Deallocate a page, so that AllocateFreePage hands it out again. Deallocating a free page does nothing.
+   * @param page_id id of the page
+   */
+  void DeallocatePage(page_id_t page_id);
+
+  /** @return true if page_id was deallocated and has not been handed out again */
+  auto IsPageFree(page_id_t page_id) -> bool;
+
+  /**
+   * Turn page checksums on or off. Call before any page is written: a page written without a checksum fails
+   * verification once checksums are on. A disk manager on a db file has them on from the
+   * start; the in-memory disk managers, which cannot tear a write, have them off unless a benchmark measures their
+   * cost.
+   * @param enable true to stamp a checksum on every written page and verify it on every read
+   */
+  void SetChecksums(bool enable) { checksums_enabled_ = enable; }
+
+  /**
+   * Turn page compression on or off. Call before any page is written: a db file keeps the format its pages were
+   * written in, and a disk manager opening a compressed db file turns compression on by itself.
+   *
+   * A compressed page is stored as a variable-size extent of the db file, in units of COMPRESSED_EXTENT_UNIT bytes, and
+   * the extent map next to the db file tells where the extent of each page is. A page that does not compress by at
+   * least one unit is stored as is.
+   * @param enable true to compress every written page and decompress it on every read
+   */
+  void SetCompression(bool enable);
+
+  /**
+   * Turn direct I/O on or off. With direct I/O the db file is opened with O_DIRECT: pages go straight between the
+   * buffer pool frames and the disk, instead of being cached a second time by the OS, which also keeps the memory of
+   * the database process within the size of its buffer pool. Buffers that are not aligned to DIRECT_IO_ALIGNMENT go
+   * through an aligned bounce buffer; the frames of a buffer pool always are. Compressed pages are not supported.
+   * @param enable true to bypass the OS page cache
+   * @return false if the file system or the format of the db file does not support direct I/O; nothing changes then
+   */
+  auto SetDirectIo(bool enable) -> bool;
+
+  /** @return true if the db file is accessed with direct I/O */
+  auto IsDirectIo() const -> bool { return direct_io_enabled_; }
+
+  /**
+   * Choose when the written pages are made durable. Even direct I/O leaves them in the volatile cache of the disk
+   * until they are synced. The default is SyncPolicy::NEVER.
+   * @param policy the policy
+   * @param batch_size number of page writes per sync under SyncPolicy::BATCH
+   */
+  void SetSyncPolicy(SyncPolicy policy, size_t batch_size = 1);
+
+  /**
+   * Make the page writes the sync policy has not synced yet durable, e.g. the incomplete batch at a checkpoint. Does
+   * nothing under SyncPolicy::NEVER.
+   */
+  void SyncPages();
+
+  /** @return the number of times the db file was synced */
+  auto GetNumSyncs() const -> size_t { return num_syncs_; }
+
+  /** @return true if pages are compressed on their way to the db file */
+  auto IsCompressed() const -> bool { return compression_enabled_; }
+
+  /** @return the number of bytes written to the db file by WritePage(); less than a page per write if compressed */
+  auto GetNumBytesWritten() const -> size_t { return num_bytes_written_; }
+
+  /** @return the number of bytes read from the db file by ReadPage(); less than a page per read if compressed */
+  auto GetNumBytesRead() const -> size_t { return num_bytes_read_; }
+
+  /** @return the number of reads that failed their checksum */
+  auto GetNumChecksumFailures() const -> size_t { return num_checksum_failures_; }
+
+  /** @return the number of deallocated pages waiting to be reused */
+  auto GetNumFreePages() -> size_t;
+
+  /** @return the number of pages AllocateFreePage handed out */
+  auto GetNumReusedPages() const -> size_t;
+
+  /** @return the size of the db file in bytes */
+  virtual auto GetDbFileSize() -> size_t;
+
+  /**
+   * @return one past the highest page id the db file holds or has deallocated. A buffer pool on a db file of an
+   * earlier run allocates new pages from here, so that it never hands out a page that is still in use.
+   */
+  virtual auto GetNumPages() -> page_id_t;
+
   /**
    * Flush the entire log buffer into disk.
    * @param log_data raw log data
@@ -94,18 +222,89 @@ class DiskManager {
 
  protected:
   auto GetFileSize(const std::string &file_name) -> int;
+
+  /** Persist the bit of page_id in the free page file, creating the file if needed. Called with free_pages_latch_. */
+  void WriteFreePageBit(page_id_t page_id);
+
+  /** Compress a page into a new extent of the db file, and point the extent map at it. */
+  void WriteCompressedPage(page_id_t page_id, const char *page_data);
+
+  /** Read the extent of a page and decompress it; throws Exception of type CORRUPTION if it does not decompress. */
+  void ReadCompressedPage(page_id_t page_id, char *page_data);
+
+  /** @return the first unit of a free run of the given number of units, taken from free_extents_ or the end of file */
+  auto AllocateExtent(uint32_t units) -> uint32_t;
+
+  /** Return a run of units to free_extents_, merging it with its free neighbours. */
+  void FreeExtent(uint32_t offset, uint32_t units);
+
+  /** Count a completed page write against the sync policy, and sync if the policy says so. */
+  void SyncAfterWrite();
+
+  /** Put the checksum of a page about to be written into its last PAGE_CHECKSUM_SIZE bytes. */
+  void StampChecksum(char *page_data);
+
+  /** Compare a page that was just read against the checksum it carries; throws Exception of type CORRUPTION if off. */
+  void VerifyChecksum(page_id_t page_id, const char *page_data);
+
   // stream to write log file
   std::fstream log_io_;
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;
+  // raw descriptor of the db file; pages are accessed with positioned pread/pwrite, so concurrent I/O on different
+  // pages needs no shared file cursor and no latch
+  int db_fd_{-1};
   std::string file_name_;
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
+  // the free page file next to the db file holds a bitmap in which bit i is set iff page i is deallocated; disk
+  // managers without a db file keep the free pages in memory only
+  std::string free_pages_name_;
+  int free_pages_fd_{-1};
+  std::mutex free_pages_latch_;
+  std::set<page_id_t> free_pages_;
+  std::atomic<size_t> num_reused_pages_{0};
+  // every page carries the CRC32C of the rest of it in its last PAGE_CHECKSUM_SIZE bytes, which no page layout uses;
+  // a page that was never written is all zeroes and the only page that may carry no checksum
+  bool checksums_enabled_{false};
+  std::atomic<size_t> num_checksum_failures_{0};
+
+  /** Granularity of the extents of compressed pages in the db file, in bytes. */
+  static constexpr uint32_t COMPRESSED_EXTENT_UNIT = 512;
+
+  /** Where the compressed image of a page lives in the db file. */
+  struct Extent {
+    /** first unit of the extent */
+    uint32_t offset_{0};
+    /** length of the compressed image in bytes; 0 if the page was never written, a page if stored as is */
+    uint32_t size_{0};
+  };
+
+  // the extent map file next to the db file holds the Extent of page i at offset 8 * i. It is written after the
+  // extent, and the old extent is only reused once a sync has made the new entry durable, so a torn write leaves the
+  // page at its old extent. Between syncs the OS may persist the entry before the extent; a crash then leaves the
+  // entry pointing at a torn image, which fails its checksum, while the old image is still intact.
+  bool compression_enabled_{false};
+  std::string extents_name_;
+  int extents_fd_{-1};
+  std::mutex extents_latch_;
+  std::vector<Extent> extents_;
+  // free runs of units below end_unit_, by first unit
+  std::map<uint32_t, uint32_t> free_extents_;
+  // extents the map no longer points to, as (first unit, units): the entry on disk may still point to them until the
+  // next sync, which frees them
+  std::vector<std::pair<uint32_t, uint32_t>> pending_free_extents_;
+  uint32_t end_unit_{0};
+  std::atomic<size_t> num_bytes_written_{0};
+  std::atomic<size_t> num_bytes_read_{0};
+
+  bool direct_io_enabled_{false};
+  SyncPolicy sync_policy_{SyncPolicy::NEVER};
+  size_t sync_batch_size_{1};
+  // page writes since the last sync under SyncPolicy::BATCH
+  std::atomic<size_t> unsynced_writes_{0};
+  std::atomic<size_t> num_syncs_{0};
 };
 
 }  // namespace bustub
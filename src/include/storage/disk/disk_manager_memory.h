@@ -9,7 +9,10 @@
 // Copyright (c) 2015-2020, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstring>
 #include <fstream>
 #include <future>  // NOLINT
@@ -18,6 +21,7 @@
 #include <optional>
 #include <shared_mutex>
 #include <string>
+#include <thread>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -52,8 +56,16 @@ class DiskManagerMemory : public DiskManager {
    */
   void ReadPage(page_id_t page_id, char *page_data) override;
 
+  /** @return the size of the memory standing in for the db file */
+  auto GetDbFileSize() -> size_t override { return pages_ * BUSTUB_PAGE_SIZE; }
+
+  /** @return one past the highest page written or deallocated; the memory itself is allocated up front */
+  auto GetNumPages() -> page_id_t override;
+
  private:
+  size_t pages_;
   char *memory_;
+  std::atomic<page_id_t> num_written_pages_{0};
 };
 
 /**
@@ -70,6 +82,8 @@ class DiskManagerUnlimitedMemory : public DiskManager {
    * @param page_data raw page data
    */
   void WritePage(page_id_t page_id, const char *page_data) override {
+    ProcessLatency();
+
     std::unique_lock<std::mutex> l(mutex_);
     if (page_id >= static_cast<int>(data_.size())) {
       data_.resize(page_id + 1);
@@ -82,6 +96,7 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     l.unlock();
 
     memcpy(ptr->first.data(), page_data, BUSTUB_PAGE_SIZE);
+    StampChecksum(ptr->first.data());
   }
 
   /**
@@ -90,6 +105,8 @@ class DiskManagerUnlimitedMemory : public DiskManager {
    * @param[out] page_data output buffer
    */
   void ReadPage(page_id_t page_id, char *page_data) override {
+    ProcessLatency();
+
     std::unique_lock<std::mutex> l(mutex_);
     if (page_id >= static_cast<int>(data_.size()) || page_id < 0) {
       LOG_WARN("page not exist");
@@ -104,13 +121,86 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     l.unlock();
 
     memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
+    VerifyChecksum(page_id, page_data);
+  }
+
+  /**
+   * Simulate a slow disk: every subsequent read and write sleeps for the given time before completing.
+   * @param latency_ms latency of a single page I/O in milliseconds, 0 to disable
+   */
+  void SetLatency(size_t latency_ms) { latency_ms_ = latency_ms; }
+
+  /** @return the size of the highest page written, as if the pages were stored in one file */
+  auto GetDbFileSize() -> size_t override {
+    std::scoped_lock<std::mutex> l(mutex_);
+    return data_.size() * BUSTUB_PAGE_SIZE;
+  }
+
+  /** @return one past the highest page written or deallocated */
+  auto GetNumPages() -> page_id_t override {
+    auto num_pages = static_cast<page_id_t>(GetDbFileSize() / BUSTUB_PAGE_SIZE);
+    return std::max(num_pages, DiskManager::GetNumPages());
   }
 
  private:
+  void ProcessLatency() {
+    size_t latency_ms = latency_ms_;
+    if (latency_ms > 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(latency_ms));
+    }
+  }
+
+  std::atomic<size_t> latency_ms_{0};
   std::mutex mutex_;
   using Page = std::array<char, BUSTUB_PAGE_SIZE>;
   using ProtectedPage = std::pair<Page, std::shared_mutex>;
   std::vector<std::shared_ptr<ProtectedPage>> data_;
 };
 
+/**
+ * DiskManagerMmap maps an existing db file into memory, read-only. It is meant for databases that nobody writes to,
+ * e.g. analytics replicas: a buffer pool on top of it serves fetches as views into the mapping instead of copying the
+ * pages into its frames, so the data is cached only once, by the OS. Pages are not verified against their checksums,
+ * since a view is handed out without being read.
+ */
+class DiskManagerMmap : public DiskManager {
+ public:
+  /**
+   * Map the specified database file. The file must exist and must not be compressed; no log file is opened.
+   * @param db_file the file name of the database file to map
+   */
+  explicit DiskManagerMmap(const std::string &db_file);
+
+  ~DiskManagerMmap() override;
+
+  /**
+   * Writing is not supported: always throws.
+   * @param page_id id of the page
+   * @param page_data raw page data
+   */
+  void WritePage(page_id_t page_id, const char *page_data) override;
+
+  /**
+   * Copy a page out of the mapping. Pages beyond the end of the file read as zeroes.
+   * @param page_id id of the page
+   * @param[out] page_data output buffer
+   */
+  void ReadPage(page_id_t page_id, char *page_data) override;
+
+  /**
+   * @param page_id id of the page
+   * @return the page in the mapping, or nullptr if the file does not hold the whole page
+   */
+  auto GetPageView(page_id_t page_id) -> const char * override;
+
+  auto IsReadOnly() -> bool override { return true; }
+
+  /** @return the size of the mapped db file */
+  auto GetDbFileSize() -> size_t override { return size_; }
+
+ private:
+  size_t size_{0};
+  char *memory_{nullptr};
+};
+
 }  // namespace bustub
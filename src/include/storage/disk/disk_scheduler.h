@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.h
+//
+// Identification: src/include/storage/disk/disk_scheduler.h
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <functional>
+#include <future>  // NOLINT
+#include <optional>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/channel.h"
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * @brief Represents a Write or Read request for the DiskManager to execute.
+ */
+struct DiskRequest {
+  /** Flag indicating whether the request is a write or a read. */
+  bool is_write_;
+
+  /**
+   *  Pointer to the start of the memory location where a page is either:
+   *   1. being read into from disk (on a read).
+   *   2. being written out to disk (on a write).
+   */
+  char *data_;
+
+  /** ID of the page being read from / written to disk. */
+  page_id_t page_id_;
+
+  /**
+   * Callback used to signal to the request issuer when the request has been completed: true if it succeeded, false if
+   * the disk manager threw, e.g. because the page failed its checksum.
+   */
+  std::promise<bool> callback_;
+
+  /**
+   * Optional work to run on the worker thread once the I/O is done, before callback_ is fulfilled, with the same
+   * result. Lets a fire-and-forget request (e.g. a prefetch) clean up after itself without anybody waiting on the
+   * future.
+   */
+  std::function<void(bool)> on_complete_{};
+};
+
+/**
+ * @brief The DiskScheduler schedules disk read and write operations.
+ *
+ * A request is scheduled by calling DiskScheduler::Schedule() with an appropriate DiskRequest object. A pool of
+ * background worker threads takes requests off a shared queue and hands them to the disk manager, so that many
+ * requests can be in flight at once. The issuer waits on the future of the request's callback when it needs the
+ * result.
+ */
+class DiskScheduler {
+ public:
+  /**
+   * @brief Creates a new DiskScheduler and starts its worker threads.
+   * @param disk_manager the disk manager that performs the actual I/O
+   * @param num_workers the number of worker threads, i.e. the maximum number of requests in flight
+   */
+  explicit DiskScheduler(DiskManager *disk_manager, size_t num_workers = DISK_SCHEDULER_WORKERS);
+
+  /**
+   * @brief Drains the request queue and joins the worker threads.
+   */
+  ~DiskScheduler();
+
+  /**
+   * @brief Schedules a request for the DiskManager to execute.
+   *
+   * @param r The request to be scheduled.
+   */
+  void Schedule(DiskRequest r);
+
+  /**
+   * @brief Create a Promise object. If you want to implement your own version of promise, you can change this function
+   * so that our test cases can use your promise implementation.
+   *
+   * @return std::promise<bool>
+   */
+  auto CreatePromise() -> std::promise<bool> { return {}; };
+
+ private:
+  /**
+   * @brief Background worker loop: processes scheduled requests until it receives the shutdown marker.
+   */
+  void StartWorkerThread();
+
+  /** Pointer to the disk manager. */
+  DiskManager *disk_manager_;
+  /** A shared queue to concurrently schedule and process requests. std::nullopt tells a worker to exit. */
+  Channel<std::optional<DiskRequest>> request_queue_;
+  /** The background threads responsible for issuing scheduled requests to the disk manager. */
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace bustub
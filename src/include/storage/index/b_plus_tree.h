@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <utility>
@@ -51,6 +52,13 @@ class BPlusTree {
   // Insert a key-value pair into this B+ tree.
   auto Insert(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr) -> bool;
 
+  /*
+   * Build this B+ tree bottom-up from sorted, unique key-value pairs, which are moved out of items. Leaves and then
+   * each internal level are filled left to right up to fill_factor of their capacity. Returns false, and builds
+   * nothing, if the tree is not empty.
+   */
+  auto BulkLoad(std::vector<std::pair<KeyType, ValueType>> *items, double fill_factor = index_fill_factor) -> bool;
+
   // Remove a key and its value from this B+ tree.
   void Remove(const KeyType &key, Transaction *transaction = nullptr);
 
@@ -60,6 +68,9 @@ class BPlusTree {
   // return the page id of the root node
   auto GetRootPageId(bool create = false) -> page_id_t;
 
+  // return the number of merged-away pages that were still pinned when deleted, waiting for a later Remove
+  auto GetNumDeferredPages() -> size_t;
+
   // index iterator
   auto Begin() -> INDEXITERATOR_TYPE;
   auto Begin(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -77,12 +88,32 @@ class BPlusTree {
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
+  /*
+   * Find the leaf that may hold key, with the root latch held on entry. READ descends optimistically (see
+   * FindLeafOptimistic), and returns a null page if the tree became empty meanwhile; INSERT and REMOVE crab latches.
+   */
   auto FindLeaf(const KeyType &key, OPT opt, Transaction *t) -> std::pair<Page *, bool>;
+  auto FindLeafOptimistic(const KeyType &key, Transaction *t, bool &root) -> Page *;
+  auto FindLeafPessimistic(const KeyType &key, OPT opt, Transaction *t) -> std::pair<Page *, bool>;
   auto InsertToParent(BPlusTreePage *raw_page, const KeyType &key, Transaction *t) -> void;
   auto Split(BPlusTreePage *raw_old, Transaction *t) -> std::pair<BPlusTreePage *, KeyType>;
-  auto RedistributeAndMerge(BPlusTreePage *old, Transaction *t) -> bool;
+  /*
+   * Fix an underfull page. A leaf needs its left sibling already latched by TryLatchLeftLeaf(), passed as left_leaf.
+   */
+  auto RedistributeAndMerge(BPlusTreePage *old, Transaction *t, Page *left_leaf = nullptr) -> bool;
+  /*
+   * Write latch the left sibling of a leaf that a remove may make underfull, without blocking: an iterator latches
+   * leaves from left to right, so waiting for the left sibling while holding the leaf could deadlock with it.
+   * @return false if somebody holds the sibling; nothing is latched or pinned for it then
+   */
+  auto TryLatchLeftLeaf(BPlusTreePage *leaf, Transaction *t, Page **left_raw) -> bool;
   auto LockAndSafe(Page *page, OPT opt) -> bool;
   auto UnLockAll(Transaction *t, OPT opt, bool &root) -> void;
+  /*
+   * Delete the pages a remove merged away, once all latches are released. Pages still pinned, e.g. by an iterator,
+   * are kept in deferred_pages_ and deleted again by a later remove.
+   */
+  void DeletePages(Transaction *t);
 
   // private:
   void UpdateRootPageId(int insert_record = 0);
@@ -92,6 +123,9 @@ class BPlusTree {
 
   void ToString(BPlusTreePage *page, BufferPoolManager *bpm) const;
 
+  /** Optimistic descents a read tries before falling back to latch crabbing. */
+  static constexpr int OPTIMISTIC_READ_ATTEMPTS = 4;
+
   // member variable
   std::string index_name_;
   page_id_t root_page_id_;
@@ -100,6 +134,9 @@ class BPlusTree {
   int leaf_max_size_;
   int internal_max_size_;
   ReaderWriterLatch root_latch_;
+  // pages that were still pinned when a remove deleted them
+  std::vector<page_id_t> deferred_pages_;
+  std::mutex deferred_pages_mutex_;
 };
 
 }  // namespace bustub
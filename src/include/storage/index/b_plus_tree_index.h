@@ -13,10 +13,11 @@
 
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
+#include <utility>
 #include <vector>
 
-#include "container/hash/hash_function.h"
 #include "storage/index/b_plus_tree.h"
 #include "storage/index/index.h"
 
@@ -31,10 +32,24 @@ class BPlusTreeIndex : public Index {
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
+  auto KeyFits(const Tuple &key) const -> bool override;
+
   void DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  using Index::Scan;
+
+  auto Scan(const std::optional<Value> &lower_bound, bool lower_inclusive, const std::optional<Value> &upper_bound,
+            bool upper_inclusive, Transaction *transaction) -> std::unique_ptr<IndexScanIterator> override;
+
+  /**
+   * Build the index bottom-up from (key, RID) pairs, which need not be sorted. Keys are set with the RID of their pair,
+   * as in InsertEntry. The pairs are consumed.
+   * @return false if the index is not empty
+   */
+  auto BulkLoad(std::vector<std::pair<KeyType, RID>> *entries) -> bool;
+
   auto GetBeginIterator() -> INDEXITERATOR_TYPE;
 
   auto GetBeginIterator(const KeyType &key) -> INDEXITERATOR_TYPE;
@@ -42,21 +57,13 @@ class BPlusTreeIndex : public Index {
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
  protected:
+  /** Normalize a bound on the first key column into key. @return the size of the bound, or 0 if it does not fit */
+  auto NormalizeBound(const Value &bound, KeyType *key) -> size_t;
+
   // comparator for key
   KeyComparator comparator_;
   // container
   BPlusTree<KeyType, ValueType, KeyComparator> container_;
 };
 
-/** We only support index table with one integer key for now in BusTub. Hardcode everything here. */
-
-constexpr static const auto INTEGER_SIZE = 4;
-using IntegerKeyType = GenericKey<INTEGER_SIZE>;
-using IntegerValueType = RID;
-using IntegerComparatorType = GenericComparator<INTEGER_SIZE>;
-using BPlusTreeIndexForOneIntegerColumn = BPlusTreeIndex<IntegerKeyType, IntegerValueType, IntegerComparatorType>;
-using BPlusTreeIndexIteratorForOneIntegerColumn =
-    IndexIterator<IntegerKeyType, IntegerValueType, IntegerComparatorType>;
-using IntegerHashFunctionType = HashFunction<IntegerKeyType>;
-
 }  // namespace bustub
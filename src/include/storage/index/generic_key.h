@@ -12,8 +12,12 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
+#include <type_traits>
 
+#include "common/exception.h"
+#include "storage/index/key_normalizer.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -35,6 +39,24 @@ class GenericKey {
     memcpy(data_, tuple.GetData(), tuple.GetLength());
   }
 
+  /** Set the key to the normalized encoding of tuple, see KeyNormalizer. */
+  inline void SetFromKey(const Tuple &tuple, const Schema &key_schema) {
+    memset(data_, 0, KeySize);
+    if (KeyNormalizer::Normalize(tuple, key_schema, data_, KeySize) == 0) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "index key is too long");
+    }
+  }
+
+  /** Set the key to the normalized encoding of tuple followed by rid, which tells apart the entries of equal keys. */
+  inline void SetFromKey(const Tuple &tuple, const Schema &key_schema, const RID &rid) {
+    memset(data_, 0, KeySize);
+    size_t size = KeyNormalizer::Normalize(tuple, key_schema, data_, KeySize);
+    if (size == 0 || size + KeyNormalizer::RID_SIZE > KeySize) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "index key is too long");
+    }
+    KeyNormalizer::NormalizeRid(rid, data_ + size);
+  }
+
   // NOTE: for test purpose only
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
@@ -72,11 +94,31 @@ class GenericKey {
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * Keys of a single integer column are compared as raw integers instead of through Values. Normalized keys, see
+ * KeyNormalizer, are compared with memcmp.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline auto operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const -> int {
+    if (normalized_) {
+      int result = memcmp(lhs.data_, rhs.data_, KeySize);
+      return static_cast<int>(result > 0) - static_cast<int>(result < 0);
+    }
+    switch (integer_key_size_) {
+      case sizeof(int8_t):
+        return CompareInteger<int8_t>(lhs, rhs);
+      case sizeof(int16_t):
+        return CompareInteger<int16_t>(lhs, rhs);
+      case sizeof(int32_t):
+        return CompareInteger<int32_t>(lhs, rhs);
+      case sizeof(int64_t):
+        return CompareInteger<int64_t>(lhs, rhs);
+      default:
+        break;
+    }
+
     uint32_t column_count = key_schema_->GetColumnCount();
 
     for (uint32_t i = 0; i < column_count; i++) {
@@ -94,13 +136,126 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  /**
+   * @brief Find the first of n sorted (key, value) pairs whose key is greater than key, like std::upper_bound.
+   * @param first the pairs to search
+   * @param n the number of pairs
+   * @param key the key to look for
+   * @return the index of the first pair greater than key, or n if there is none
+   */
+  template <typename Pair>
+  inline auto UpperBound(const Pair *first, int n, const GenericKey<KeySize> &key) const -> int {
+    // a normalized key of up to two words compares as an unsigned integer once its bytes are swapped
+    if constexpr (KeySize == sizeof(uint32_t) || KeySize == sizeof(uint64_t) || KeySize == sizeof(Uint128)) {
+      if (normalized_) {
+        using Word = std::conditional_t<KeySize == sizeof(uint32_t), uint32_t,
+                                        std::conditional_t<KeySize == sizeof(uint64_t), uint64_t, Uint128>>;
+        return UpperBoundInteger<Word, true>(first, n, key);
+      }
+    }
+    if (normalized_) {
+      return std::upper_bound(first, first + n, key,
+                              [](const auto &key, const auto &pair) {
+                                return memcmp(pair.first.data_, key.data_, KeySize) > 0;
+                              }) -
+             first;
+    }
+    switch (integer_key_size_) {
+      case sizeof(int8_t):
+        return UpperBoundInteger<int8_t>(first, n, key);
+      case sizeof(int16_t):
+        return UpperBoundInteger<int16_t>(first, n, key);
+      case sizeof(int32_t):
+        return UpperBoundInteger<int32_t>(first, n, key);
+      case sizeof(int64_t):
+        return UpperBoundInteger<int64_t>(first, n, key);
+      default:
+        break;
+    }
+    return std::upper_bound(first, first + n, key,
+                            [this](const auto &key, const auto &pair) { return (*this)(pair.first, key) > 0; }) -
+           first;
+  }
 
-  // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, normalized_{other.normalized_}, integer_key_size_{other.integer_key_size_} {}
+
+  /**
+   * @param key_schema the schema of the key
+   * @param normalized whether keys are normalized, that is set with SetFromKey(tuple, key_schema)
+   */
+  explicit GenericComparator(Schema *key_schema, bool normalized = false)
+      : key_schema_(key_schema), normalized_(normalized) {
+    if (normalized_ || key_schema_ == nullptr || key_schema_->GetColumnCount() != 1) {
+      return;
+    }
+    const auto &col = key_schema_->GetColumn(0);
+    switch (col.GetType()) {
+      case TypeId::TINYINT:
+      case TypeId::SMALLINT:
+      case TypeId::INTEGER:
+      case TypeId::BIGINT:
+        if (col.IsInlined() && col.GetOffset() == 0 && col.GetFixedLength() <= KeySize) {
+          integer_key_size_ = col.GetFixedLength();
+        }
+        break;
+      default:
+        break;
+    }
+  }
 
  private:
+  __extension__ using Uint128 = unsigned __int128;
+
+  template <typename T, bool BigEndian = false>
+  static inline auto LoadInteger(const GenericKey<KeySize> &key) -> T {
+    T value;
+    if constexpr (BigEndian && sizeof(T) == sizeof(Uint128)) {
+      // a single integer column followed by a RID: the two words swapped one by one, most significant first
+      uint64_t words[2];
+      memcpy(words, key.data_, sizeof(words));
+      value = static_cast<Uint128>(__builtin_bswap64(words[0])) << 64 | __builtin_bswap64(words[1]);
+    } else {
+      memcpy(&value, key.data_, sizeof(T));
+      if constexpr (BigEndian && sizeof(T) == sizeof(uint32_t)) {
+        value = __builtin_bswap32(value);
+      } else if constexpr (BigEndian) {
+        value = __builtin_bswap64(value);
+      }
+    }
+    return value;
+  }
+
+  /** NULL is the smallest integer of its type, so it sorts before every other key rather than equal to all of them. */
+  template <typename T>
+  static inline auto CompareInteger(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) -> int {
+    T lhs_value = LoadInteger<T>(lhs);
+    T rhs_value = LoadInteger<T>(rhs);
+    return static_cast<int>(lhs_value > rhs_value) - static_cast<int>(lhs_value < rhs_value);
+  }
+
+  template <typename T, bool BigEndian = false, typename Pair>
+  static inline auto UpperBoundInteger(const Pair *first, int n, const GenericKey<KeySize> &key) -> int {
+    if (n <= 0) {
+      return 0;
+    }
+    T target = LoadInteger<T, BigEndian>(key);
+    // Halve the range by moving its base with a conditional move instead of a branch: which half a probe picks is a
+    // coin flip that the branch predictor cannot learn, and every miss costs a pipeline flush.
+    const Pair *base = first;
+    while (n > 1) {
+      int half = n / 2;
+      base = LoadInteger<T, BigEndian>(base[half].first) <= target ? base + half : base;
+      n -= half;
+    }
+    return static_cast<int>(base - first) + static_cast<int>(LoadInteger<T, BigEndian>(base->first) <= target);
+  }
+
   Schema *key_schema_;
+  /** Whether keys are normalized and compare with memcmp */
+  bool normalized_;
+  /** Width of the only column of the key if it is an integer, or 0 if keys are compared as Values */
+  uint32_t integer_key_size_{0};
 };
 
 }  // namespace bustub
@@ -13,11 +13,13 @@
 #pragma once
 
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/exception.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -100,6 +102,23 @@ class IndexMetadata {
 // Index class definition
 /////////////////////////////////////////////////////////////////////
 
+/**
+ * IndexScanIterator walks the entries of an ordered index in key order.
+ */
+class IndexScanIterator {
+ public:
+  virtual ~IndexScanIterator() = default;
+
+  /** @return true if the iterator is past the last entry */
+  virtual auto IsEnd() -> bool = 0;
+
+  /** @return The RID of the current entry */
+  virtual auto GetRid() -> RID = 0;
+
+  /** Move to the next entry */
+  virtual void Next() = 0;
+};
+
 /**
  * class Index - Base class for derived indices of different types
  *
@@ -159,6 +178,13 @@ class Index {
    */
   virtual void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) = 0;
 
+  /**
+   * Check whether a key can be inserted, i.e. whether InsertEntry() would not throw because the key is too long.
+   * @param key The index key
+   * @return true if the key fits into the index
+   */
+  virtual auto KeyFits(__attribute__((unused)) const Tuple &key) const -> bool { return true; }
+
   /**
    * Delete an index entry by key.
    * @param key The index key
@@ -175,6 +201,31 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Scan all entries of the index in key order.
+   * @param transaction The transaction context
+   * @return An iterator positioned at the first entry
+   */
+  auto Scan(Transaction *transaction) -> std::unique_ptr<IndexScanIterator> {
+    return Scan(std::nullopt, true, std::nullopt, true, transaction);
+  }
+
+  /**
+   * Scan the entries of the index in key order whose first key column lies within bounds. The bounds must have the
+   * type of the column.
+   * @param lower_bound The smallest value of the first key column to scan, or nullopt to start at the first entry
+   * @param lower_inclusive Whether entries equal to lower_bound are scanned
+   * @param upper_bound The largest value of the first key column to scan, or nullopt to scan to the last entry
+   * @param upper_inclusive Whether entries equal to upper_bound are scanned
+   * @param transaction The transaction context
+   * @return An iterator positioned at the first entry within bounds
+   */
+  virtual auto Scan(const std::optional<Value> &lower_bound, bool lower_inclusive,
+                    const std::optional<Value> &upper_bound, bool upper_inclusive, Transaction *transaction)
+      -> std::unique_ptr<IndexScanIterator> {
+    throw NotImplementedException("index does not support ordered scans");
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
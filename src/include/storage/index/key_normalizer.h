@@ -0,0 +1,67 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_normalizer.h
+//
+// Identification: src/include/storage/index/key_normalizer.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "catalog/schema.h"
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * KeyNormalizer encodes index keys so that comparing the encodings with memcmp orders them like their values, column
+ * by column. Keys of any number and type of columns then compare with a single memcmp.
+ *
+ * Encoding of each column, one after the other:
+ *  - integers, booleans and timestamps: big-endian, with the sign bit flipped for signed types
+ *  - decimals: the bits of the double big-endian, with the sign bit flipped if positive and all bits if negative
+ *  - varchars: 0x01, the characters and a terminating 0x00, or a single 0x00 if NULL
+ *
+ * The NULL of a fixed-size type is the smallest value of the type (the largest for timestamps) and sorts like it. A
+ * varchar ends at its first 0x00 character, which SQL strings do not have.
+ *
+ * The encoding of a whole key is never a prefix of the encoding of another key, so a key followed by a RID still sorts
+ * by key first, and the keys equal to a key are the ones that start with its encoding.
+ */
+class KeyNormalizer {
+ public:
+  /** Size of the encoding of a RID */
+  static constexpr size_t RID_SIZE = sizeof(page_id_t) + sizeof(uint32_t);
+
+  /**
+   * @param key_schema the schema of the key
+   * @return the size of the longest encoding of a key, counting varchars at their declared length
+   */
+  static auto GetNormalizedSize(const Schema &key_schema) -> size_t;
+
+  /**
+   * Encode a key.
+   * @param key the key tuple
+   * @param key_schema the schema of the key
+   * @param[out] dst the encoded key
+   * @param capacity the size of dst in bytes
+   * @return the size of the encoding, or 0 if it does not fit in dst
+   */
+  static auto Normalize(const Tuple &key, const Schema &key_schema, char *dst, size_t capacity) -> size_t;
+
+  /**
+   * Encode a RID big-endian, page id first.
+   * @param rid the RID
+   * @param[out] dst the encoded RID, at least RID_SIZE bytes
+   */
+  static void NormalizeRid(const RID &rid, char *dst);
+};
+
+}  // namespace bustub
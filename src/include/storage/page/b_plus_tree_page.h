@@ -57,6 +57,16 @@ class BPlusTreePage {
   void SetPageId(const page_id_t &page_id);
   void SetLSN(const lsn_t &lsn = INVALID_LSN);
 
+  /**
+   * Fetch a page of a tree, or create one. When every frame is pinned, the pool is usually full only until the other
+   * operations on the tree unpin their paths, so these retry for up to FULL_POOL_WAIT_MS instead of failing at once.
+   * @throw Exception OUT_OF_MEMORY if the pool stays full
+   */
+  static auto FetchTreePage(BufferPoolManager *bpm, page_id_t page_id) -> Page *;
+  static auto NewTreePage(BufferPoolManager *bpm, page_id_t *page_id) -> Page *;
+
+  static constexpr int FULL_POOL_WAIT_MS = 1000;
+
  private:
   // member variable, attributes that both internal and leaf page share
   IndexPageType page_type_;
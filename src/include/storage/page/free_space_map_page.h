@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map_page.h
+//
+// Identification: src/include/storage/page/free_space_map_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * A page of the free space map of a table heap. It records, for each of its table pages, a category that is a lower
+ * bound of the free bytes of that page: category c means at least c * FSM_CATEGORY_SIZE bytes are free.
+ *
+ * Free space map page format (size in bytes):
+ *  -------------------------------------------------------------------------------------------------------
+ *  | NextPageId (4) | EntryCount (4) | PageId_1 (4) | ... | PageId_n (4) | Category_1 (1) | ... | Category_n (1) |
+ *  -------------------------------------------------------------------------------------------------------
+ *  where n = FSM_PAGE_CAPACITY.
+ */
+class FreeSpaceMapPage : public Page {
+ public:
+  /** Number of table pages one free space map page tracks. */
+  static constexpr uint32_t FSM_PAGE_CAPACITY = (BUSTUB_PAGE_DATA_SIZE - 8) / (sizeof(page_id_t) + sizeof(uint8_t));
+  /** Free bytes represented by one step of a category. */
+  static constexpr uint32_t FSM_CATEGORY_SIZE = BUSTUB_PAGE_SIZE / 256;
+
+  /** Initialize an empty free space map page. Entries that were never set track INVALID_PAGE_ID. */
+  void Init() {
+    memset(GetData(), 0, BUSTUB_PAGE_SIZE);
+    SetNextPageId(INVALID_PAGE_ID);
+    for (uint32_t slot = 0; slot < FSM_PAGE_CAPACITY; ++slot) {
+      SetEntry(slot, INVALID_PAGE_ID, 0);
+    }
+  }
+
+  /** @return the page ID of the next free space map page */
+  auto GetNextPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** Set the page id of the next free space map page. */
+  void SetNextPageId(page_id_t next_page_id) { memcpy(GetData(), &next_page_id, sizeof(page_id_t)); }
+
+  /** @return the number of entries in use */
+  auto GetEntryCount() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_ENTRY_COUNT); }
+
+  /** Set the number of entries in use. */
+  void SetEntryCount(uint32_t count) { memcpy(GetData() + OFFSET_ENTRY_COUNT, &count, sizeof(uint32_t)); }
+
+  /** @return the table page tracked by entry slot */
+  auto GetTablePageId(uint32_t slot) -> page_id_t {
+    return *reinterpret_cast<page_id_t *>(GetData() + OFFSET_PAGE_IDS + slot * sizeof(page_id_t));
+  }
+
+  /** @return the free space category of the table page tracked by entry slot */
+  auto GetCategory(uint32_t slot) -> uint8_t {
+    return *reinterpret_cast<uint8_t *>(GetData() + OFFSET_CATEGORIES + slot);
+  }
+
+  /** Set the table page tracked by entry slot and its free space category. */
+  void SetEntry(uint32_t slot, page_id_t table_page_id, uint8_t category) {
+    memcpy(GetData() + OFFSET_PAGE_IDS + slot * sizeof(page_id_t), &table_page_id, sizeof(page_id_t));
+    SetCategory(slot, category);
+  }
+
+  /** Set the free space category of the table page tracked by entry slot. */
+  void SetCategory(uint32_t slot, uint8_t category) {
+    *reinterpret_cast<uint8_t *>(GetData() + OFFSET_CATEGORIES + slot) = category;
+  }
+
+  /** @return the largest category whose pages surely have free_space bytes */
+  static auto ToCategory(uint32_t free_space) -> uint8_t {
+    return static_cast<uint8_t>(std::min<uint32_t>(free_space / FSM_CATEGORY_SIZE, UINT8_MAX));
+  }
+
+  /** @return the smallest category whose pages surely have free_space bytes */
+  static auto ToRequiredCategory(uint32_t free_space) -> uint8_t {
+    auto category = (free_space + FSM_CATEGORY_SIZE - 1) / FSM_CATEGORY_SIZE;
+    return static_cast<uint8_t>(std::min<uint32_t>(category, UINT8_MAX));
+  }
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+
+  static constexpr size_t OFFSET_ENTRY_COUNT = 4;
+  static constexpr size_t OFFSET_PAGE_IDS = 8;
+  static constexpr size_t OFFSET_CATEGORIES = OFFSET_PAGE_IDS + FSM_PAGE_CAPACITY * sizeof(page_id_t);
+};
+
+}  // namespace bustub
@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// overflow_page.h
+//
+// Identification: src/include/storage/page/overflow_page.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstring>
+
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * An overflow page holds a piece of a varchar value that was moved out of its tuple, because the tuple would have
+ * taken too much of a table page. The pages of one value form a chain in value order.
+ *
+ * Overflow page format (size in bytes):
+ *  ----------------------------------------------------------
+ *  | NextPageId (4) | DataSize (4) | Data (DataSize) | ... |
+ *  ----------------------------------------------------------
+ */
+class OverflowPage : public Page {
+ public:
+  /** Number of value bytes one overflow page holds. */
+  static constexpr uint32_t OVERFLOW_PAGE_CAPACITY = BUSTUB_PAGE_DATA_SIZE - 8;
+
+  /** Initialize an overflow page that ends the chain and holds no data yet. */
+  void Init() {
+    SetNextPageId(INVALID_PAGE_ID);
+    SetDataSize(0);
+  }
+
+  /** @return the page ID of the next page of the chain */
+  auto GetNextPageId() -> page_id_t { return *reinterpret_cast<page_id_t *>(GetData()); }
+
+  /** Set the page id of the next page of the chain. */
+  void SetNextPageId(page_id_t next_page_id) { memcpy(GetData(), &next_page_id, sizeof(page_id_t)); }
+
+  /** @return the number of value bytes on this page */
+  auto GetDataSize() -> uint32_t { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_DATA_SIZE); }
+
+  /** Set the number of value bytes on this page. */
+  void SetDataSize(uint32_t size) { memcpy(GetData() + OFFSET_DATA_SIZE, &size, sizeof(uint32_t)); }
+
+  /** @return the value bytes on this page */
+  auto GetPayload() -> char * { return GetData() + OFFSET_PAYLOAD; }
+
+ private:
+  static_assert(sizeof(page_id_t) == 4);
+
+  static constexpr size_t OFFSET_DATA_SIZE = 4;
+  static constexpr size_t OFFSET_PAYLOAD = 8;
+};
+
+}  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <cstring>
 #include <iostream>
 
@@ -30,8 +31,8 @@ class Page {
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. The page has no data until the buffer pool assigns it a frame of its FrameArena. */
+  Page() = default;
 
   /** Default destructor. */
   ~Page() = default;
@@ -48,14 +49,30 @@ class Page {
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline auto IsDirty() -> bool { return is_dirty_; }
 
-  /** Acquire the page write latch. */
+  /** Acquire the page write latch. The page version is odd until WUnlatch(). */
   inline void WLatch() {
     rwlatch_.WLock();
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
     //    std::cout << "wlock " << GetPageId() << '\n';
   }
 
+  /**
+   * Acquire the page write latch if nobody holds it, without blocking.
+   * @return true if the latch was acquired; release it with WUnlatch()
+   */
+  inline auto TryWLatch() -> bool {
+    if (!rwlatch_.TryWLock()) {
+      return false;
+    }
+    version_.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
+
   /** Release the page write latch. */
   inline void WUnlatch() {
+    version_.fetch_add(1, std::memory_order_release);
     rwlatch_.WUnlock();
     //    std::cout << "wunlock " << GetPageId() << '\n';
   }
@@ -72,6 +89,22 @@ class Page {
     //    std::cout << "runlock " << GetPageId() << '\n';
   }
 
+  /**
+   * Start an optimistic read. The caller must keep the page pinned, may read it without any latch, and must call
+   * ValidateVersion() with the returned version before acting on anything it read.
+   * @return a snapshot of the page version; an odd version means a writer holds the latch
+   */
+  inline auto GetVersion() const -> uint64_t { return version_.load(std::memory_order_acquire); }
+
+  /**
+   * @param version a version returned by GetVersion()
+   * @return true if no writer latched the page since GetVersion() returned version, i.e. the optimistic read is valid
+   */
+  inline auto ValidateVersion(uint64_t version) const -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 && version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -90,8 +123,11 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[BUSTUB_PAGE_SIZE]{};
+  /**
+   * The actual data that is stored within a page: BUSTUB_PAGE_SIZE bytes owned by the buffer pool's FrameArena, or a
+   * read-only view of the disk manager's memory.
+   */
+  char *data_{nullptr};
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
@@ -100,6 +136,8 @@ class Page {
   bool is_dirty_ = false;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Incremented when the write latch is taken and again when it is released, for optimistic readers. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
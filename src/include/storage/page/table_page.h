@@ -107,12 +107,25 @@ class TablePage : public Page {
   auto UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID &rid, Transaction *txn,
                    LockManager *lock_manager, LogManager *log_manager) -> bool;
 
-  /** To be called on commit or abort. Actually perform the delete or rollback an insert. */
-  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
+  /**
+   * To be called on commit or abort. Actually perform the delete or rollback an insert.
+   * @param rid rid of the tuple to delete
+   * @param txn transaction performing the delete
+   * @param log_manager the log manager
+   * @param[out] deleted_tuple if not nullptr, set to the deleted tuple
+   */
+  void ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager, Tuple *deleted_tuple = nullptr);
 
   /** To be called on abort. Rollback a delete, i.e. this reverses a MarkDelete. */
   void RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager);
 
+  /**
+   * Compact the page: drop the empty slots at the end of the slot array and pack the tuple data, including tuples
+   * marked as deleted, against the end of the page.
+   * @return the number of bytes reclaimed
+   */
+  auto Compact() -> uint32_t;
+
   /**
    * Read a tuple from a table.
    * @param rid rid of the tuple to read
@@ -138,11 +151,21 @@ class TablePage : public Page {
    */
   auto GetNextTupleRid(const RID &cur_rid, RID *next_rid) -> bool;
 
+  /** @return the number of slots in this page, some of which may be empty */
+  auto GetSlotCount() -> uint32_t { return GetTupleCount(); }
+
+  /** @return the number of bytes left for new tuples, including their slots */
+  auto GetFreeSpaceRemaining() -> uint32_t {
+    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
+  }
+
+  /** Bytes of the slot array taken by every tuple, on top of the tuple data. */
+  static constexpr size_t SIZE_TUPLE = 8;
+
  private:
   static_assert(sizeof(page_id_t) == 4);
 
   static constexpr size_t SIZE_TABLE_PAGE_HEADER = 24;
-  static constexpr size_t SIZE_TUPLE = 8;
   static constexpr size_t OFFSET_PREV_PAGE_ID = 8;
   static constexpr size_t OFFSET_NEXT_PAGE_ID = 12;
   static constexpr size_t OFFSET_FREE_SPACE = 16;
@@ -167,10 +190,6 @@ class TablePage : public Page {
   /** Set the number of tuples in this page. */
   void SetTupleCount(uint32_t tuple_count) { memcpy(GetData() + OFFSET_TUPLE_COUNT, &tuple_count, sizeof(uint32_t)); }
 
-  auto GetFreeSpaceRemaining() -> uint32_t {
-    return GetFreeSpacePointer() - SIZE_TABLE_PAGE_HEADER - SIZE_TUPLE * GetTupleCount();
-  }
-
   /** @return tuple offset at slot slot_num */
   auto GetTupleOffsetAtSlot(uint32_t slot_num) -> uint32_t {
     return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_TUPLE_OFFSET + SIZE_TUPLE * slot_num);
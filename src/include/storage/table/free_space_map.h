@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.h
+//
+// Identification: src/include/storage/table/free_space_map.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/page/free_space_map_page.h"
+
+namespace bustub {
+
+/**
+ * FreeSpaceMap records approximately how many bytes are free on each page of a table heap, so that an insert can go
+ * straight to a page with room instead of walking the page list.
+ *
+ * The map itself lives in a chain of FreeSpaceMapPages in the buffer pool, so it is persisted with the table. In
+ * memory it keeps where each table page is tracked and, for every map page, an upper bound of the categories on it,
+ * so that lookups skip map pages without a page that has enough room.
+ *
+ * The recorded free space is a hint: it may be stale, and callers must cope with a page that turns out to be full.
+ */
+class FreeSpaceMap {
+ public:
+  /**
+   * Create an empty free space map. (create table)
+   * @param buffer_pool_manager the buffer pool manager
+   */
+  explicit FreeSpaceMap(BufferPoolManager *buffer_pool_manager);
+
+  /**
+   * Open an existing free space map. (open table)
+   * @param buffer_pool_manager the buffer pool manager
+   * @param first_page_id the id of the first free space map page
+   */
+  FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id);
+
+  /** @return the id of the first page of the free space map */
+  auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
+
+  /**
+   * @brief Find a table page that has, according to the map, at least size free bytes.
+   * @param size the number of bytes needed
+   * @param skip_page_id a page not to return, e.g. one the caller has already found to be full
+   * @return the id of the table page, or INVALID_PAGE_ID if the map knows of no such page
+   */
+  auto FindPage(uint32_t size, page_id_t skip_page_id = INVALID_PAGE_ID) -> page_id_t;
+
+  /**
+   * @brief Record the free space of a table page, and start tracking the page if it is not tracked yet.
+   * @param table_page_id the id of the table page
+   * @param free_space the number of free bytes on the page
+   * @return false if the map could not grow to track a new page
+   */
+  auto Update(page_id_t table_page_id, uint32_t free_space) -> bool;
+
+  /**
+   * @brief Stop tracking a table page, e.g. because it was removed from the table. Its entry is reused later.
+   * @param table_page_id the id of the table page
+   */
+  void Remove(page_id_t table_page_id);
+
+ private:
+  /** Where a table page is tracked. */
+  struct Location {
+    size_t map_page_index_;
+    uint32_t slot_;
+  };
+
+  /**
+   * @brief Reserve an entry for a new table page: a removed page's entry, or a new one at the end, appending a map page
+   * if the last one is full. Called with latch_.
+   * @param table_page_id the id of the table page
+   * @param[out] location the reserved entry
+   * @param[out] link_page_id the map page whose next page id must be set to a newly appended map page, if any
+   * @return false if a new map page could not be created
+   */
+  auto Reserve(page_id_t table_page_id, Location *location, page_id_t *link_page_id) -> bool;
+
+  BufferPoolManager *buffer_pool_manager_;
+  page_id_t first_page_id_;
+  /** Protects the in-memory state below; taken after, never before, the latch of a map page. */
+  std::mutex latch_;
+  /** Ids of the map pages, in chain order. */
+  std::vector<page_id_t> map_page_ids_;
+  /** For every map page, an upper bound of the categories of its entries. */
+  std::vector<uint8_t> max_categories_;
+  /** Number of entries reserved on the last map page. */
+  uint32_t last_page_entries_{0};
+  std::unordered_map<page_id_t, Location> locations_;
+  /** Entries below last_page_entries_ on their map page that track no table page. */
+  std::vector<Location> free_locations_;
+};
+
+}  // namespace bustub
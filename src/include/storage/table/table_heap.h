@@ -12,9 +12,18 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "common/rwlatch.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
+#include "storage/table/free_space_map.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
 
@@ -22,7 +31,12 @@ namespace bustub {
 
 /**
  * TableHeap represents a physical table on disk.
- * This is just a doubly-linked list of pages.
+ * This is just a doubly-linked list of pages, plus a free space map that tells inserts which pages have room.
+ *
+ * A table heap that knows the schema of its tuples stores a tuple larger than OVERFLOW_TUPLE_THRESHOLD with its
+ * largest varchar values out of line, each in a chain of overflow pages of its own. The tuple keeps a stub in place of
+ * the value, and reads the value from the chain only when its column is asked for. The chain of a value is deleted
+ * with the last version of the tuple that refers to it, or later if a tuple read before then may still read it.
  */
 class TableHeap {
   friend class TableIterator;
@@ -36,9 +50,12 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param first_page_id the id of the first page
+   * @param free_space_map_page_id the id of the first page of the free space map, or INVALID_PAGE_ID to rebuild it
+   * @param schema the schema of the tuples, or nullptr to store every tuple in line
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            page_id_t first_page_id);
+            page_id_t first_page_id, page_id_t free_space_map_page_id = INVALID_PAGE_ID,
+            const Schema *schema = nullptr);
 
   /**
    * Create a table heap with a transaction. (create table)
@@ -46,12 +63,14 @@ class TableHeap {
    * @param lock_manager the lock manager
    * @param log_manager the log manager
    * @param txn the creating transaction
+   * @param schema the schema of the tuples, or nullptr to store every tuple in line
    */
   TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-            Transaction *txn);
+            Transaction *txn, const Schema *schema = nullptr);
 
   /**
-   * Insert a tuple into the table. If the tuple is too large (>= page_size), return false.
+   * Insert a tuple into the table. If the tuple is too large (>= page_size) even with its large values out of line,
+   * return false.
    * @param tuple tuple to insert
    * @param[out] rid the rid of the inserted tuple
    * @param txn the transaction performing the insert
@@ -59,6 +78,17 @@ class TableHeap {
    */
   auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
 
+  /**
+   * Insert a batch of tuples into fresh pages. The pages are packed while no one else can reach them, then attached
+   * to the end of the page list at once, so that a bulk load neither consults the free space map nor latches a page
+   * per tuple.
+   * @param tuples tuples to insert
+   * @param[out] rids the rids of the inserted tuples are appended to it, in order
+   * @param txn the transaction performing the insert
+   * @return true iff the insert is successful; otherwise no tuple is inserted
+   */
+  auto BulkInsertTuples(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn) -> bool;
+
   /**
    * Mark the tuple as deleted. The actual delete will occur when ApplyDelete is called.
    * @param rid resource id of the tuple of delete
@@ -69,6 +99,9 @@ class TableHeap {
 
   /**
    * if the new tuple is too large to fit in the old page, return false (will delete and insert)
+   *
+   * The old version keeps its values out of line until ApplyUpdate, since an abort puts it back; an update that rolls
+   * back another deletes the values of the version it replaces.
    * @param tuple new tuple
    * @param rid rid of the old tuple
    * @param txn transaction performing the update
@@ -83,6 +116,13 @@ class TableHeap {
    */
   void ApplyDelete(const RID &rid, Transaction *txn);
 
+  /**
+   * Called on commit of an update, once the old version of the tuple cannot come back: deletes the overflow pages of
+   * its values.
+   * @param old_tuple the old version of the tuple, as saved in the write set
+   */
+  void ApplyUpdate(const Tuple &old_tuple);
+
   /**
    * Called on abort to rollback a delete.
    * @param rid rid of the deleted tuple.
@@ -95,12 +135,32 @@ class TableHeap {
    * @param rid rid of the tuple to read
    * @param tuple output variable for the tuple
    * @param txn transaction performing the read
+   * @param acquire_read_lock whether to latch the page while reading
+   * @param strategy the buffer access strategy of the scan performing the read, or nullptr
    * @return true if the read was successful (i.e. the tuple exists)
    */
-  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true) -> bool;
+  auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true,
+                BufferAccessStrategy *strategy = nullptr) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * Vacuum the table: compact every page, and give the pages left empty back to the buffer pool manager, which
+   * deallocates them on the disk manager. Pages are latched one at a time, so readers and writers of other pages go
+   * on meanwhile; inserts wait only while an empty page is being unlinked. The first and the last page are kept.
+   *
+   * A scan must not rest on an empty page while it is reclaimed, which the tuple locks of any isolation level but
+   * READ_UNCOMMITTED guarantee: a scan's current tuple cannot be deleted under it.
+   *
+   * A page unlinked while something still pinned it is deleted by a later vacuum; see FreePage.
+   * @return the number of bytes reclaimed, counting a page given back as a whole page
+   */
+  auto Vacuum() -> size_t;
+
+  /**
+   * @param txn the transaction performing the scan
+   * @param strategy the buffer access strategy the iterator fetches pages with, or nullptr for normal fetches
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
@@ -108,11 +168,136 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** @return the number of pages in this table */
+  inline auto GetNumPages() const -> size_t { return num_pages_; }
+
+  /** @return the number of pages that were still pinned when they were freed, waiting for a later Vacuum */
+  auto GetNumDeferredPages() -> size_t {
+    std::scoped_lock lock(deferred_pages_mutex_);
+    return deferred_pages_.size();
+  }
+
+  /** @return the id of the first page of the free space map of this table */
+  inline auto GetFreeSpaceMapPageId() const -> page_id_t { return free_space_map_->GetFirstPageId(); }
+
  private:
+  /** Number of insert page hints; threads are spread over them by their id. */
+  static constexpr size_t INSERT_HINTS = 16;
+
+  /**
+   * @brief Try to insert a tuple into an existing page, and record the free space left on it.
+   * @return true iff the page had room for the tuple
+   */
+  auto InsertIntoPage(page_id_t page_id, const Tuple &tuple, RID *rid, Transaction *txn) -> bool;
+
+  /**
+   * @brief Append a new page to the end of the page list and insert a tuple into it.
+   * @return the id of the new page, or INVALID_PAGE_ID if no page could be created
+   */
+  auto InsertIntoNewPage(const Tuple &tuple, RID *rid, Transaction *txn) -> page_id_t;
+
+  /**
+   * @brief Fetch and write latch the last page of the page list, latch coupling forward from last_page_id_ past pages
+   * that other appenders linked meanwhile.
+   * @return the last page, or nullptr if it could not be fetched
+   */
+  auto LatchLastPage() -> TablePage *;
+
+  /**
+   * @brief Unlink an empty page from the page list and delete it. Called by Vacuum.
+   * @param prev_page_id the page before it
+   * @param page_id the page to remove
+   * @return false if the page is not removable after all, e.g. because a tuple was inserted into it meanwhile
+   */
+  auto RemovePage(page_id_t prev_page_id, page_id_t page_id) -> bool;
+
+  /**
+   * @brief Build the tuple to store for a tuple that is larger than OVERFLOW_TUPLE_THRESHOLD or refers to values
+   * out of line of another tuple: its values are read in full, and the largest varchars moved into new overflow pages
+   * until the tuple is small enough.
+   * @param tuple the tuple to insert
+   * @param[out] stored_tuple set to the tuple to store; left empty if the tuple can be stored as it is
+   * @return false if an overflow page could not be created
+   */
+  auto MoveValuesOutOfLine(const Tuple &tuple, Tuple *stored_tuple) -> bool;
+
+  /**
+   * @brief Write a value into a new chain of overflow pages.
+   * @return the id of the first page of the chain, or INVALID_PAGE_ID if a page could not be created
+   */
+  auto WriteOverflowPages(const char *data, uint32_t len) -> page_id_t;
+
+  /** @return true iff the tuple stores a value out of line */
+  auto HasOutOfLineValues(const Tuple &tuple) const -> bool;
+
+  /** @brief Retire the overflow pages of every value a tuple of this table stores out of line. */
+  void DeleteOutOfLineValues(const Tuple &tuple);
+
+  /**
+   * @brief Delete a chain of overflow pages that tuples read earlier may still refer to. If any tuple holds a read
+   * epoch, the chain waits in retired_chains_ for the current epoch to end, and a new epoch begins.
+   */
+  void RetireOverflowPages(page_id_t page_id);
+
+  /** @brief Delete the retired chains whose epoch has ended. Called by Vacuum. */
+  void DeleteRetiredChains();
+
+  /** @return the retired chains whose epoch has ended, taken out of retired_chains_. Called with read_epoch_mutex_. */
+  auto TakeExpiredChains() -> std::vector<page_id_t>;
+
+  /** @brief Delete a chain of overflow pages, starting at its first page. */
+  void DeleteOverflowPages(page_id_t page_id);
+
+  /**
+   * @brief Delete a page nothing links to anymore. If it is still pinned, e.g. by a scan that followed a link to it
+   * before the link was changed, it is left in deferred_pages_ instead of waiting for the pin to go. A page that is
+   * not allocated, e.g. because it was deleted already, is dropped with a warning.
+   */
+  void FreePage(page_id_t page_id);
+
+  /** @brief Try again to delete the pages FreePage deferred. Called by Vacuum. */
+  void FreeDeferredPages();
+
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
+  /** The schema of the tuples, needed to move values out of line; nullptr if the table stores every tuple in line. */
+  std::unique_ptr<Schema> schema_;
   page_id_t first_page_id_{};
+  /** Number of pages in the page list, maintained so that scans can tell a large table from a small one. */
+  std::atomic<size_t> num_pages_{0};
+  /** The last page of the page list as far as appenders know; the true last page may be a few pages further. */
+  std::atomic<page_id_t> last_page_id_{INVALID_PAGE_ID};
+  std::unique_ptr<FreeSpaceMap> free_space_map_;
+  /**
+   * The page each group of threads last inserted into. Appenders keep filling their own page rather than all racing
+   * for the first page with room in the free space map.
+   */
+  std::array<std::atomic<page_id_t>, INSERT_HINTS> insert_hints_;
+  /**
+   * Taken shared by every operation that may point the free space map, an insert hint or last_page_id_ at a page, and
+   * exclusively while Vacuum unlinks a page, so that no insert can reach a page once it is removed.
+   */
+  ReaderWriterLatch vacuum_latch_;
+  /** Allows one Vacuum at a time, so that a vacuum can walk the page list without latch coupling. */
+  std::mutex vacuum_mutex_;
+  /** Pages that were still pinned when they were freed; the next Vacuum tries to delete them again. */
+  std::vector<page_id_t> deferred_pages_;
+  std::mutex deferred_pages_mutex_;
+
+  /**
+   * An epoch of tuples read with values out of line: GetTuple gives such a tuple the current epoch as its guard. Each
+   * epoch keeps the next one alive, so an epoch has ended only once every tuple read in it or before it is gone.
+   */
+  struct ReadEpoch {
+    ~ReadEpoch();
+    std::shared_ptr<ReadEpoch> next_;
+  };
+  /** The epoch tuples read now join. No tuple holds any epoch iff this is the only reference to it. */
+  std::shared_ptr<ReadEpoch> read_epoch_{std::make_shared<ReadEpoch>()};
+  /** Chains of overflow pages deleted while tuples held epochs, with the epoch each waits for, oldest first. */
+  std::vector<std::pair<std::weak_ptr<ReadEpoch>, page_id_t>> retired_chains_;
+  std::mutex read_epoch_mutex_;
 };
 
 }  // namespace bustub
@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -21,11 +22,21 @@
 
 namespace bustub {
 
+class BufferPoolManager;
+
 /**
  * Tuple format:
- * ---------------------------------------------------------------------
+ * -------------------------------------------------------------------
  * | FIXED-SIZE or VARIED-SIZED OFFSET | PAYLOAD OF VARIED-SIZED FIELD |
- * ---------------------------------------------------------------------
+ * -------------------------------------------------------------------
+ *
+ * The payload of a varied-sized field is its length followed by its data. A table heap moves the large values of a
+ * large tuple out of line into a chain of overflow pages; the payload then holds a stub instead:
+ * ------------------------------------------------------------------
+ * | LENGTH WITH OVERFLOW_FLAG SET (4) | FIRST OVERFLOW PAGE ID (4) |
+ * ------------------------------------------------------------------
+ * The value is read from the overflow pages only when GetValue asks for its column. A tuple read from a table heap,
+ * and every copy of it, holds a guard that keeps the table heap from freeing those pages before the tuple is gone.
  */
 class Tuple {
   friend class TablePage;
@@ -77,23 +88,35 @@ class Tuple {
   // Generates a key tuple given schemas and attributes
   auto KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) -> Tuple;
 
-  // Is the column value null ?
-  inline auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool {
-    Value value = GetValue(schema, column_idx);
-    return value.IsNull();
-  }
+  // Is the column value null ? Does not read a value stored out of line.
+  auto IsNull(const Schema *schema, uint32_t column_idx) const -> bool;
+
+  // Is the column value stored out of line, in overflow pages ?
+  auto IsOutOfLine(const Schema *schema, uint32_t column_idx) const -> bool;
   inline auto IsAllocated() -> bool { return allocated_; }
 
   auto ToString(const Schema *schema) const -> std::string;
 
  private:
+  /** Set in the length of a varied-sized payload that is a stub for a value stored out of line. */
+  static constexpr uint32_t OVERFLOW_FLAG = 1U << 31;
+  /** Size of the stub of a value stored out of line. */
+  static constexpr uint32_t OVERFLOW_STUB_SIZE = sizeof(uint32_t) + sizeof(page_id_t);
+
   // Get the starting storage address of specific column
   auto GetDataPtr(const Schema *schema, uint32_t column_idx) const -> const char *;
 
+  // Read a value stored out of line from its chain of overflow pages
+  auto GetOutOfLineValue(TypeId type, const char *stub) const -> Value;
+
   bool allocated_{false};  // is allocated?
   RID rid_{};              // if pointing to the table heap, the rid is valid
   uint32_t size_{0};
   char *data_{nullptr};
+  // the buffer pool of the table heap the tuple was read from, for values stored out of line
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  // keeps the overflow pages of the values stored out of line from being freed while the tuple is alive
+  std::shared_ptr<const void> overflow_guard_;
 };
 
 }  // namespace bustub
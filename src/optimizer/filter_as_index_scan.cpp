@@ -0,0 +1,173 @@
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/expressions/logic_expression.h"
+#include "execution/plans/filter_plan.h"
+#include "execution/plans/index_scan_plan.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+namespace {
+
+/** Bounds on a column implied by a predicate */
+struct ColumnBounds {
+  std::optional<Value> lower_;
+  bool lower_inclusive_{true};
+  std::optional<Value> upper_;
+  bool upper_inclusive_{true};
+};
+
+/** Collect the terms of a predicate that are ANDed together. */
+void CollectConjuncts(const AbstractExpression *expr, std::vector<const AbstractExpression *> *conjuncts) {
+  const auto *logic_expr = dynamic_cast<const LogicExpression *>(expr);
+  if (logic_expr != nullptr && logic_expr->logic_type_ == LogicType::And) {
+    CollectConjuncts(logic_expr->GetChildAt(0).get(), conjuncts);
+    CollectConjuncts(logic_expr->GetChildAt(1).get(), conjuncts);
+    return;
+  }
+  conjuncts->push_back(expr);
+}
+
+/** @return the comparison that holds with the operands swapped */
+auto Mirror(ComparisonType comp_type) -> ComparisonType {
+  switch (comp_type) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return comp_type;
+  }
+}
+
+void TightenLower(ColumnBounds *bounds, const Value &value, bool inclusive) {
+  if (!bounds->lower_.has_value() || value.CompareGreaterThan(*bounds->lower_) == CmpBool::CmpTrue ||
+      (value.CompareEquals(*bounds->lower_) == CmpBool::CmpTrue && !inclusive)) {
+    bounds->lower_ = value;
+    bounds->lower_inclusive_ = inclusive;
+  }
+}
+
+void TightenUpper(ColumnBounds *bounds, const Value &value, bool inclusive) {
+  if (!bounds->upper_.has_value() || value.CompareLessThan(*bounds->upper_) == CmpBool::CmpTrue ||
+      (value.CompareEquals(*bounds->upper_) == CmpBool::CmpTrue && !inclusive)) {
+    bounds->upper_ = value;
+    bounds->upper_inclusive_ = inclusive;
+  }
+}
+
+/** Narrow bounds on column col_idx by the terms that compare it with a constant of its type. */
+auto MatchBounds(const std::vector<const AbstractExpression *> &conjuncts, uint32_t col_idx, TypeId col_type)
+    -> ColumnBounds {
+  ColumnBounds bounds;
+  for (const auto *conjunct : conjuncts) {
+    const auto *comp_expr = dynamic_cast<const ComparisonExpression *>(conjunct);
+    if (comp_expr == nullptr) {
+      continue;
+    }
+    auto comp_type = comp_expr->comp_type_;
+    const auto *column_expr = dynamic_cast<const ColumnValueExpression *>(comp_expr->GetChildAt(0).get());
+    const auto *constant_expr = dynamic_cast<const ConstantValueExpression *>(comp_expr->GetChildAt(1).get());
+    if (column_expr == nullptr || constant_expr == nullptr) {
+      column_expr = dynamic_cast<const ColumnValueExpression *>(comp_expr->GetChildAt(1).get());
+      constant_expr = dynamic_cast<const ConstantValueExpression *>(comp_expr->GetChildAt(0).get());
+      comp_type = Mirror(comp_type);
+    }
+    if (column_expr == nullptr || constant_expr == nullptr || column_expr->GetTupleIdx() != 0 ||
+        column_expr->GetColIdx() != col_idx) {
+      continue;
+    }
+    // The index compares encoded keys, so the constant must encode like the column.
+    const auto &value = constant_expr->val_;
+    if (value.GetTypeId() != col_type || value.IsNull()) {
+      continue;
+    }
+    switch (comp_type) {
+      case ComparisonType::Equal:
+        TightenLower(&bounds, value, true);
+        TightenUpper(&bounds, value, true);
+        break;
+      case ComparisonType::GreaterThan:
+        TightenLower(&bounds, value, false);
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        TightenLower(&bounds, value, true);
+        break;
+      case ComparisonType::LessThan:
+        TightenUpper(&bounds, value, false);
+        break;
+      case ComparisonType::LessThanOrEqual:
+        TightenUpper(&bounds, value, true);
+        break;
+      default:
+        break;
+    }
+  }
+  return bounds;
+}
+
+}  // namespace
+
+auto Optimizer::OptimizeFilterAsIndexScan(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeFilterAsIndexScan(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  if (optimized_plan->GetType() != PlanType::Filter) {
+    return optimized_plan;
+  }
+  const auto &filter_plan = dynamic_cast<const FilterPlanNode &>(*optimized_plan);
+  BUSTUB_ENSURE(optimized_plan->children_.size() == 1, "Filter with multiple children?? Impossible!");
+  const auto &child_plan = optimized_plan->children_[0];
+  if (child_plan->GetType() != PlanType::SeqScan) {
+    return optimized_plan;
+  }
+  const auto &seq_scan = dynamic_cast<const SeqScanPlanNode &>(*child_plan);
+  if (seq_scan.filter_predicate_ != nullptr) {
+    return optimized_plan;
+  }
+
+  std::vector<const AbstractExpression *> conjuncts;
+  CollectConjuncts(filter_plan.GetPredicate().get(), &conjuncts);
+
+  // Pick the index whose first key column is bounded on the most sides.
+  const auto *table_info = catalog_.GetTable(seq_scan.GetTableOid());
+  const IndexInfo *best_index = nullptr;
+  ColumnBounds best_bounds;
+  int best_sides = 0;
+  for (const auto *index : catalog_.GetTableIndexes(table_info->name_)) {
+    auto col_idx = index->index_->GetKeyAttrs()[0];
+    auto bounds = MatchBounds(conjuncts, col_idx, table_info->schema_.GetColumn(col_idx).GetType());
+    int sides = static_cast<int>(bounds.lower_.has_value()) + static_cast<int>(bounds.upper_.has_value());
+    if (sides > best_sides) {
+      best_index = index;
+      best_bounds = bounds;
+      best_sides = sides;
+    }
+  }
+  if (best_index == nullptr) {
+    return optimized_plan;
+  }
+
+  // The filter stays on top: the bounds only narrow the scan to the rows that can pass it.
+  auto index_scan = std::make_shared<IndexScanPlanNode>(
+      seq_scan.output_schema_, best_index->index_oid_, std::move(best_bounds.lower_), best_bounds.lower_inclusive_,
+      std::move(best_bounds.upper_), best_bounds.upper_inclusive_);
+  return std::make_shared<FilterPlanNode>(filter_plan.output_schema_, filter_plan.GetPredicate(),
+                                          std::move(index_scan));
+}
+
+}  // namespace bustub
@@ -32,25 +32,19 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
     const auto &sort_plan = dynamic_cast<const SortPlanNode &>(*optimized_plan);
     const auto &order_bys = sort_plan.GetOrderBy();
 
-    // Has exactly one order by column
-    if (order_bys.size() != 1) {
-      return optimized_plan;
-    }
-
-    // Order type is asc or default
-    const auto &[order_type, expr] = order_bys[0];
-    if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT)) {
-      return optimized_plan;
-    }
-
-    // Order expression is a column value expression
-    const auto *column_value_expr = dynamic_cast<ColumnValueExpression *>(expr.get());
-    if (column_value_expr == nullptr) {
-      return optimized_plan;
+    // Every order by is ascending on a column
+    std::vector<uint32_t> order_by_column_ids;
+    for (const auto &[order_type, expr] : order_bys) {
+      if (!(order_type == OrderByType::ASC || order_type == OrderByType::DEFAULT)) {
+        return optimized_plan;
+      }
+      const auto *column_value_expr = dynamic_cast<ColumnValueExpression *>(expr.get());
+      if (column_value_expr == nullptr) {
+        return optimized_plan;
+      }
+      order_by_column_ids.push_back(column_value_expr->GetColIdx());
     }
 
-    auto order_by_column_id = column_value_expr->GetColIdx();
-
     // Has exactly one child
     BUSTUB_ENSURE(optimized_plan->children_.size() == 1, "Sort with multiple children?? Impossible!");
     const auto &child_plan = optimized_plan->children_[0];
@@ -61,9 +55,10 @@ auto Optimizer::OptimizeOrderByAsIndexScan(const AbstractPlanNodeRef &plan) -> A
       const auto indices = catalog_.GetTableIndexes(table_info->name_);
 
       for (const auto *index : indices) {
-        const auto &columns = index->key_schema_.GetColumns();
-        if (columns.size() == 1 &&
-            columns[0].GetName() == table_info->schema_.GetColumn(order_by_column_id).GetName()) {
+        // An index is sorted by every prefix of its key columns
+        const auto &key_attrs = index->index_->GetKeyAttrs();
+        if (key_attrs.size() >= order_by_column_ids.size() &&
+            std::equal(order_by_column_ids.begin(), order_by_column_ids.end(), key_attrs.begin())) {
           // Index matched, return index scan instead
           return std::make_shared<IndexScanPlanNode>(optimized_plan->output_schema_, index->index_oid_);
         }
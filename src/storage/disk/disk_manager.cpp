@@ -10,22 +10,92 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstring>
 #include <iostream>
+#include <iterator>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
+#include "common/util/checksum_util.h"
+#include "common/util/compression_util.h"
+#include "fmt/format.h"
 #include "storage/disk/disk_manager.h"
 
 namespace bustub {
 
 static char *buffer_used;
 
+/** @return a page buffer aligned for direct I/O, private to the calling thread */
+static auto DirectIoBuffer() -> char * {
+  struct alignas(DIRECT_IO_ALIGNMENT) AlignedPage {
+    char data_[BUSTUB_PAGE_SIZE];
+  };
+  static thread_local auto buffer = std::make_unique<AlignedPage>();
+  return buffer->data_;
+}
+
+/** @return a page buffer for compressed images, private to the calling thread */
+static auto CompressionBuffer() -> char * {
+  static thread_local auto buffer = std::make_unique<char[]>(BUSTUB_PAGE_SIZE);
+  return buffer.get();
+}
+
+static auto IsAligned(const char *data) -> bool {
+  return reinterpret_cast<uintptr_t>(data) % DIRECT_IO_ALIGNMENT == 0;
+}
+
+/** Write all of data at offset. @return false on an I/O error */
+static auto PwriteFully(int fd, const char *data, size_t size, off_t offset) -> bool {
+  size_t written = 0;
+  while (written < size) {
+    ssize_t ret = pwrite(fd, data + written, size - written, offset + written);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      return false;
+    }
+    written += ret;
+  }
+  return true;
+}
+
+/** Read up to size bytes at offset. @return the number of bytes read, less than size at the end of file, or -1 */
+static auto PreadFully(int fd, char *data, size_t size, off_t offset) -> ssize_t {
+  size_t read_count = 0;
+  while (read_count < size) {
+    ssize_t ret = pread(fd, data + read_count, size - read_count, offset + read_count);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret < 0) {
+      return -1;
+    }
+    // end of file
+    if (ret == 0) {
+      break;
+    }
+    read_count += ret;
+  }
+  return read_count;
+}
+
+/** @return the checksum of the data of a page, never 0, which marks a page without one */
+static auto PageChecksum(const char *page_data) -> uint32_t {
+  auto checksum = ChecksumUtil::Crc32c(page_data, BUSTUB_PAGE_DATA_SIZE);
+  return checksum == 0 ? 1 : checksum;
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
@@ -37,6 +107,9 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  free_pages_name_ = file_name_.substr(0, n) + ".free";
+  extents_name_ = file_name_.substr(0, n) + ".ext";
+  checksums_enabled_ = true;
 
   log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
   // directory or file does not exist
@@ -49,27 +122,77 @@ DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
     }
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
-    }
+  // open the db file, creating it if it does not exist
+  db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
   }
   buffer_used = nullptr;
+
+  // Load the pages deallocated in an earlier run and, if the pages are compressed, where they are. A free page file or
+  // extent map next to an empty db file is left over from a removed database.
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) == 0 && stat_buf.st_size > 0) {
+    std::ifstream free_pages_in(free_pages_name_, std::ios::binary);
+    char byte;
+    page_id_t page_id = 0;
+    while (free_pages_in.get(byte)) {
+      for (int bit = 0; bit < 8; ++bit, ++page_id) {
+        if ((static_cast<uint8_t>(byte) & (1U << bit)) != 0) {
+          free_pages_.insert(page_id);
+        }
+      }
+    }
+    std::ifstream extents_in(extents_name_, std::ios::binary);
+    Extent extent;
+    while (extents_in.read(reinterpret_cast<char *>(&extent), sizeof(Extent))) {
+      extents_.push_back(extent);
+      compression_enabled_ = true;
+    }
+    // Every unit no extent covers is free, including the extents of writes whose extent map entry was lost.
+    std::vector<Extent> used;
+    std::copy_if(extents_.begin(), extents_.end(), std::back_inserter(used), [](auto &e) { return e.size_ > 0; });
+    std::sort(used.begin(), used.end(), [](auto &a, auto &b) { return a.offset_ < b.offset_; });
+    for (const auto &e : used) {
+      if (e.offset_ > end_unit_) {
+        free_extents_[end_unit_] = e.offset_ - end_unit_;
+      }
+      end_unit_ = std::max(end_unit_, e.offset_ + (e.size_ + COMPRESSED_EXTENT_UNIT - 1) / COMPRESSED_EXTENT_UNIT);
+    }
+  } else {
+    unlink(free_pages_name_.c_str());
+    unlink(extents_name_.c_str());
+  }
+}
+
+DiskManager::~DiskManager() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  if (free_pages_fd_ >= 0) {
+    close(free_pages_fd_);
+  }
+  if (extents_fd_ >= 0) {
+    close(extents_fd_);
+  }
 }
 
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  SyncPages();
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (free_pages_fd_ >= 0) {
+    close(free_pages_fd_);
+    free_pages_fd_ = -1;
+  }
+  if (extents_fd_ >= 0) {
+    close(extents_fd_);
+    extents_fd_ = -1;
   }
   log_io_.close();
 }
@@ -78,48 +201,399 @@ void DiskManager::ShutDown() {
  * Write the contents of the specified page into disk file
  */
 void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
-  // set write cursor to offset
   num_writes_ += 1;
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);
-  // check for I/O error
-  if (db_io_.bad()) {
-    LOG_DEBUG("I/O error while writing");
+  if (compression_enabled_) {
+    WriteCompressedPage(page_id, page_data);
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();
+  const char *data = page_data;
+  if (checksums_enabled_ || (direct_io_enabled_ && !IsAligned(page_data))) {
+    // Write a copy, so that the checksum covers exactly the bytes written even if the frame changes meanwhile.
+    char *buffer = DirectIoBuffer();
+    memcpy(buffer, page_data, BUSTUB_PAGE_SIZE);
+    StampChecksum(buffer);
+    data = buffer;
+  }
+  // pwrite does not move a shared cursor, so writers of different pages never wait on each other. The checksum goes
+  // in the same write as the data, so a crash leaves either the old page or the new one, each with its checksum, or
+  // a torn page that fails it.
+  auto offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+  if (!PwriteFully(db_fd_, data, BUSTUB_PAGE_SIZE, offset)) {
+    throw Exception(ExceptionType::IO, fmt::format("I/O error while writing page {}", page_id));
+  }
+  num_bytes_written_ += BUSTUB_PAGE_SIZE;
+  SyncAfterWrite();
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
 void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);
-    if (db_io_.bad()) {
-      LOG_DEBUG("I/O error while reading");
+  if (compression_enabled_) {
+    ReadCompressedPage(page_id, page_data);
+    return;
+  }
+  char *data = direct_io_enabled_ && !IsAligned(page_data) ? DirectIoBuffer() : page_data;
+  auto offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+  ssize_t read_count = PreadFully(db_fd_, data, BUSTUB_PAGE_SIZE, offset);
+  if (read_count < 0) {
+    throw Exception(ExceptionType::CORRUPTION, fmt::format("I/O error while reading page {}", page_id));
+  }
+  if (data != page_data) {
+    memcpy(page_data, data, read_count);
+  }
+  num_bytes_read_ += read_count;
+  // if file ends before reading BUSTUB_PAGE_SIZE
+  if (read_count < BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+    // A page beyond the end of the file was never written; one the end of the file cuts through has lost its tail.
+    if (checksums_enabled_ && read_count > 0) {
+      ++num_checksum_failures_;
+      throw Exception(ExceptionType::CORRUPTION, fmt::format("page {} is cut short by the end of file", page_id));
+    }
+  }
+  VerifyChecksum(page_id, page_data);
+}
+
+void DiskManager::SetCompression(bool enable) {
+  if (enable == compression_enabled_) {
+    return;
+  }
+  if (db_fd_ < 0 || GetDbFileSize() > 0) {
+    LOG_WARN("only an empty db file can change whether its pages are compressed");
+    return;
+  }
+  if (direct_io_enabled_) {
+    LOG_WARN("direct I/O does not support compressed pages");
+    return;
+  }
+  compression_enabled_ = enable;
+}
+
+auto DiskManager::SetDirectIo(bool enable) -> bool {
+  if (enable == direct_io_enabled_) {
+    return true;
+  }
+  if (db_fd_ < 0) {
+    return false;
+  }
+  // the extents of compressed pages are neither aligned nor whole blocks
+  if (enable && compression_enabled_) {
+    LOG_WARN("direct I/O does not support compressed pages");
+    return false;
+  }
+  int flags = fcntl(db_fd_, F_GETFL);
+  if (flags < 0 || fcntl(db_fd_, F_SETFL, enable ? flags | O_DIRECT : flags & ~O_DIRECT) != 0) {
+    LOG_WARN("cannot turn direct I/O %s: %s", enable ? "on" : "off", strerror(errno));
+    return false;
+  }
+  direct_io_enabled_ = enable;
+  return true;
+}
+
+void DiskManager::SetSyncPolicy(SyncPolicy policy, size_t batch_size) {
+  // the writes of the old policy are settled by its rules
+  SyncPages();
+  sync_policy_ = policy;
+  sync_batch_size_ = std::max<size_t>(batch_size, 1);
+}
+
+void DiskManager::SyncPages() {
+  if (sync_policy_ == SyncPolicy::NEVER || db_fd_ < 0) {
+    return;
+  }
+  // Writes that complete after the counter is reset are counted towards the next batch; the ones before are synced.
+  if (sync_policy_ == SyncPolicy::BATCH && unsynced_writes_.exchange(0) == 0) {
+    return;
+  }
+  // The extents the map stopped pointing to before the sync can be reused once it is done.
+  int extents_fd;
+  std::vector<std::pair<uint32_t, uint32_t>> pending_extents;
+  {
+    std::scoped_lock lock(extents_latch_);
+    extents_fd = extents_fd_;
+    pending_extents.swap(pending_free_extents_);
+  }
+  bool synced = true;
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing db file");
+    synced = false;
+  }
+  // The extent map tells where the pages are, so it has to be as durable.
+  if (extents_fd >= 0 && fdatasync(extents_fd) != 0) {
+    LOG_DEBUG("I/O error while syncing db file");
+    synced = false;
+  }
+  if (!pending_extents.empty()) {
+    std::scoped_lock lock(extents_latch_);
+    for (auto [offset, units] : pending_extents) {
+      if (synced) {
+        FreeExtent(offset, units);
+      } else {
+        pending_free_extents_.emplace_back(offset, units);
+      }
+    }
+  }
+  ++num_syncs_;
+}
+
+void DiskManager::SyncAfterWrite() {
+  if (sync_policy_ == SyncPolicy::EVERY_WRITE ||
+      (sync_policy_ == SyncPolicy::BATCH && ++unsynced_writes_ >= sync_batch_size_)) {
+    SyncPages();
+  }
+}
+
+void DiskManager::WriteCompressedPage(page_id_t page_id, const char *page_data) {
+  // The checksum is compressed along with the page. Compressed pages never take the direct I/O path, so its buffer is
+  // free here.
+  char *stamped = DirectIoBuffer();
+  if (checksums_enabled_) {
+    memcpy(stamped, page_data, BUSTUB_PAGE_SIZE);
+    StampChecksum(stamped);
+    page_data = stamped;
+  }
+  char *buffer = CompressionBuffer();
+  // An image that does not save a unit is not worth decompressing: store the page as is.
+  size_t size =
+      CompressionUtil::Compress(page_data, BUSTUB_PAGE_SIZE, buffer, BUSTUB_PAGE_SIZE - COMPRESSED_EXTENT_UNIT);
+  const char *image = buffer;
+  if (size == 0) {
+    size = BUSTUB_PAGE_SIZE;
+    image = page_data;
+  }
+  auto units = static_cast<uint32_t>((size + COMPRESSED_EXTENT_UNIT - 1) / COMPRESSED_EXTENT_UNIT);
+  uint32_t offset;
+  {
+    std::scoped_lock lock(extents_latch_);
+    offset = AllocateExtent(units);
+  }
+  // The image goes to a new extent, never over the old one, so that a torn write leaves the old image intact.
+  if (!PwriteFully(db_fd_, image, size, static_cast<off_t>(offset) * COMPRESSED_EXTENT_UNIT)) {
+    {
+      std::scoped_lock lock(extents_latch_);
+      FreeExtent(offset, units);
+    }
+    throw Exception(ExceptionType::IO, fmt::format("I/O error while writing page {}", page_id));
+  }
+  num_bytes_written_ += size;
+
+  {
+    std::scoped_lock lock(extents_latch_);
+    if (static_cast<size_t>(page_id) >= extents_.size()) {
+      extents_.resize(page_id + 1);
+    }
+    Extent old_extent = extents_[page_id];
+    Extent &extent = extents_[page_id];
+    extent.offset_ = offset;
+    extent.size_ = static_cast<uint32_t>(size);
+    if (old_extent.size_ > 0) {
+      auto old_units = (old_extent.size_ + COMPRESSED_EXTENT_UNIT - 1) / COMPRESSED_EXTENT_UNIT;
+      // Without syncs nothing is durable anyway; otherwise the old image must survive until the new entry is.
+      if (sync_policy_ == SyncPolicy::NEVER) {
+        FreeExtent(old_extent.offset_, old_units);
+      } else {
+        pending_free_extents_.emplace_back(old_extent.offset_, old_units);
+      }
+    }
+    if (extents_fd_ < 0) {
+      extents_fd_ = open(extents_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+    if (extents_fd_ < 0 ||
+        !PwriteFully(extents_fd_, reinterpret_cast<const char *>(&extent), sizeof(Extent),
+                     static_cast<off_t>(page_id) * sizeof(Extent))) {
+      LOG_DEBUG("I/O error while writing extent map");
+    }
+  }
+  SyncAfterWrite();
+}
+
+void DiskManager::ReadCompressedPage(page_id_t page_id, char *page_data) {
+  Extent extent;
+  {
+    std::scoped_lock lock(extents_latch_);
+    if (static_cast<size_t>(page_id) < extents_.size()) {
+      extent = extents_[page_id];
+    }
+  }
+  // a page that was never written reads as zeroes
+  if (extent.size_ == 0) {
+    memset(page_data, 0, BUSTUB_PAGE_SIZE);
+    return;
+  }
+  char *buffer = CompressionBuffer();
+  char *image = extent.size_ == BUSTUB_PAGE_SIZE ? page_data : buffer;
+  ssize_t read_count =
+      PreadFully(db_fd_, image, extent.size_, static_cast<off_t>(extent.offset_) * COMPRESSED_EXTENT_UNIT);
+  if (read_count < 0) {
+    throw Exception(ExceptionType::CORRUPTION, fmt::format("I/O error while reading page {}", page_id));
+  }
+  num_bytes_read_ += read_count;
+  if (static_cast<size_t>(read_count) < extent.size_) {
+    LOG_DEBUG("Read less than a page");
+    memset(image + read_count, 0, extent.size_ - read_count);
+  }
+  if (image == buffer && !CompressionUtil::Decompress(buffer, extent.size_, page_data, BUSTUB_PAGE_SIZE)) {
+    throw Exception(ExceptionType::CORRUPTION, fmt::format("page {} does not decompress", page_id));
+  }
+  VerifyChecksum(page_id, page_data);
+}
+
+auto DiskManager::AllocateExtent(uint32_t units) -> uint32_t {
+  // first fit keeps the extents packed towards the start of the file
+  for (auto it = free_extents_.begin(); it != free_extents_.end(); ++it) {
+    auto [offset, free_units] = *it;
+    if (free_units >= units) {
+      free_extents_.erase(it);
+      if (free_units > units) {
+        free_extents_[offset + units] = free_units - units;
+      }
+      return offset;
+    }
+  }
+  uint32_t offset = end_unit_;
+  end_unit_ += units;
+  return offset;
+}
+
+void DiskManager::FreeExtent(uint32_t offset, uint32_t units) {
+  auto next = free_extents_.find(offset + units);
+  if (next != free_extents_.end()) {
+    units += next->second;
+    free_extents_.erase(next);
+  }
+  auto prev = free_extents_.lower_bound(offset);
+  if (prev != free_extents_.begin() && std::prev(prev)->first + std::prev(prev)->second == offset) {
+    --prev;
+    offset = prev->first;
+    units += prev->second;
+    free_extents_.erase(prev);
+  }
+  // a free run at the end of the file is handed out as part of the end instead
+  if (offset + units == end_unit_) {
+    end_unit_ = offset;
+    return;
+  }
+  free_extents_[offset] = units;
+}
+
+/**
+ * Hand out the lowest deallocated page that belongs to the given buffer pool instance
+ */
+auto DiskManager::AllocateFreePage(uint32_t instance_index, uint32_t num_instances) -> page_id_t {
+  std::scoped_lock lock(free_pages_latch_);
+  for (auto it = free_pages_.begin(); it != free_pages_.end(); ++it) {
+    if (static_cast<uint32_t>(*it) % num_instances == instance_index) {
+      auto page_id = *it;
+      free_pages_.erase(it);
+      WriteFreePageBit(page_id);
+      ++num_reused_pages_;
+      return page_id;
+    }
+  }
+  return INVALID_PAGE_ID;
+}
+
+/**
+ * Record a page as free, in memory and in the free page file
+ */
+void DiskManager::DeallocatePage(page_id_t page_id) {
+  std::scoped_lock lock(free_pages_latch_);
+  if (free_pages_.insert(page_id).second) {
+    WriteFreePageBit(page_id);
+  }
+}
+
+auto DiskManager::IsPageFree(page_id_t page_id) -> bool {
+  std::scoped_lock lock(free_pages_latch_);
+  return free_pages_.count(page_id) > 0;
+}
+
+void DiskManager::WriteFreePageBit(page_id_t page_id) {
+  if (free_pages_name_.empty()) {
+    return;
+  }
+  if (free_pages_fd_ < 0) {
+    free_pages_fd_ = open(free_pages_name_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (free_pages_fd_ < 0) {
+      LOG_DEBUG("can't open free page file");
       return;
     }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+  // The byte also holds the bits of 7 neighbouring pages: rebuild it from free_pages_.
+  page_id_t first_page_id = page_id / 8 * 8;
+  uint8_t byte = 0;
+  for (int bit = 0; bit < 8; ++bit) {
+    if (free_pages_.count(first_page_id + bit) > 0) {
+      byte |= 1U << bit;
     }
   }
+  ssize_t ret;
+  do {
+    ret = pwrite(free_pages_fd_, &byte, 1, page_id / 8);
+  } while (ret < 0 && errno == EINTR);
+  if (ret != 1) {
+    LOG_DEBUG("I/O error while writing free page file");
+  }
+}
+
+void DiskManager::StampChecksum(char *page_data) {
+  if (!checksums_enabled_) {
+    return;
+  }
+  auto checksum = PageChecksum(page_data);
+  memcpy(page_data + BUSTUB_PAGE_DATA_SIZE, &checksum, PAGE_CHECKSUM_SIZE);
+}
+
+void DiskManager::VerifyChecksum(page_id_t page_id, const char *page_data) {
+  if (!checksums_enabled_) {
+    return;
+  }
+  uint32_t expected;
+  memcpy(&expected, page_data + BUSTUB_PAGE_DATA_SIZE, PAGE_CHECKSUM_SIZE);
+  auto checksum = PageChecksum(page_data);
+  if (checksum == expected) {
+    return;
+  }
+  // A page that was never written is all zeroes, and the only page without a checksum.
+  if (expected == 0 && std::all_of(page_data, page_data + BUSTUB_PAGE_SIZE, [](char c) { return c == 0; })) {
+    return;
+  }
+  ++num_checksum_failures_;
+  throw Exception(ExceptionType::CORRUPTION, fmt::format("page {} failed its checksum: expected {:08x}, found {:08x}",
+                                                         page_id, expected, checksum));
+}
+
+auto DiskManager::GetNumFreePages() -> size_t {
+  std::scoped_lock lock(free_pages_latch_);
+  return free_pages_.size();
+}
+
+auto DiskManager::GetNumReusedPages() const -> size_t { return num_reused_pages_; }
+
+auto DiskManager::GetDbFileSize() -> size_t {
+  struct stat stat_buf;
+  if (db_fd_ < 0 || fstat(db_fd_, &stat_buf) != 0) {
+    return 0;
+  }
+  return stat_buf.st_size;
+}
+
+auto DiskManager::GetNumPages() -> page_id_t {
+  page_id_t num_pages;
+  if (compression_enabled_) {
+    std::scoped_lock lock(extents_latch_);
+    num_pages = static_cast<page_id_t>(extents_.size());
+  } else {
+    num_pages = static_cast<page_id_t>((DiskManager::GetDbFileSize() + BUSTUB_PAGE_SIZE - 1) / BUSTUB_PAGE_SIZE);
+  }
+  // A page may be deallocated before it was ever written.
+  std::scoped_lock lock(free_pages_latch_);
+  if (!free_pages_.empty()) {
+    num_pages = std::max(num_pages, *free_pages_.rbegin() + 1);
+  }
+  return num_pages;
 }
 
 /**
@@ -12,6 +12,11 @@
 
 #include "storage/disk/disk_manager_memory.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstring>
@@ -27,7 +32,7 @@ namespace bustub {
 /**
  * Constructor: used for memory based manager
  */
-DiskManagerMemory::DiskManagerMemory(size_t pages) { memory_ = new char[pages * BUSTUB_PAGE_SIZE]; }
+DiskManagerMemory::DiskManagerMemory(size_t pages) : pages_(pages) { memory_ = new char[pages * BUSTUB_PAGE_SIZE]; }
 
 /**
  * Write the contents of the specified page into disk file
@@ -37,6 +42,10 @@ void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
   // set write cursor to offset
   num_writes_ += 1;
   memcpy(memory_ + offset, page_data, BUSTUB_PAGE_SIZE);
+  StampChecksum(memory_ + offset);
+  auto num_pages = num_written_pages_.load();
+  while (page_id >= num_pages && !num_written_pages_.compare_exchange_weak(num_pages, page_id + 1)) {
+  }
 }
 
 /**
@@ -45,6 +54,83 @@ void DiskManagerMemory::WritePage(page_id_t page_id, const char *page_data) {
 void DiskManagerMemory::ReadPage(page_id_t page_id, char *page_data) {
   int64_t offset = static_cast<int64_t>(page_id) * BUSTUB_PAGE_SIZE;
   memcpy(page_data, memory_ + offset, BUSTUB_PAGE_SIZE);
+  VerifyChecksum(page_id, page_data);
+}
+
+auto DiskManagerMemory::GetNumPages() -> page_id_t {
+  return std::max(num_written_pages_.load(), DiskManager::GetNumPages());
+}
+
+/**
+ * Constructor: map an existing database file read-only
+ */
+DiskManagerMmap::DiskManagerMmap(const std::string &db_file) {
+  file_name_ = db_file;
+  db_fd_ = open(db_file.c_str(), O_RDONLY);
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
+  }
+  struct stat stat_buf;
+  if (fstat(db_fd_, &stat_buf) != 0) {
+    throw Exception("can't stat db file");
+  }
+  size_ = stat_buf.st_size;
+  // the pages of a compressed db file are not where a view would look for them
+  std::string::size_type n = file_name_.rfind('.');
+  if (size_ > 0 && n != std::string::npos && access((file_name_.substr(0, n) + ".ext").c_str(), F_OK) == 0) {
+    close(db_fd_);
+    db_fd_ = -1;
+    throw Exception("can't map a compressed db file");
+  }
+  // mmap refuses empty mappings; an empty file simply has no pages
+  if (size_ > 0) {
+    void *memory = mmap(nullptr, size_, PROT_READ, MAP_SHARED, db_fd_, 0);
+    if (memory == MAP_FAILED) {
+      throw Exception("can't map db file");
+    }
+    memory_ = static_cast<char *>(memory);
+  }
+}
+
+DiskManagerMmap::~DiskManagerMmap() {
+  if (memory_ != nullptr) {
+    munmap(memory_, size_);
+  }
+}
+
+/**
+ * The mapping is read-only
+ */
+void DiskManagerMmap::WritePage(page_id_t page_id, const char *page_data) {
+  throw Exception(ExceptionType::INVALID, "can't write to a memory-mapped db file");
+}
+
+/**
+ * Copy the specified page out of the mapping into the given memory area
+ */
+void DiskManagerMmap::ReadPage(page_id_t page_id, char *page_data) {
+  auto offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+  size_t read_count = 0;
+  if (page_id >= 0 && offset < size_) {
+    read_count = std::min<size_t>(BUSTUB_PAGE_SIZE, size_ - offset);
+    memcpy(page_data, memory_ + offset, read_count);
+  }
+  // if file ends before reading BUSTUB_PAGE_SIZE
+  if (read_count < BUSTUB_PAGE_SIZE) {
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+}
+
+/**
+ * Hand out the specified page in place, if the file holds all of it
+ */
+auto DiskManagerMmap::GetPageView(page_id_t page_id) -> const char * {
+  auto offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;
+  if (page_id < 0 || offset + BUSTUB_PAGE_SIZE > size_) {
+    return nullptr;
+  }
+  return memory_ + offset;
 }
 
 }  // namespace bustub
@@ -0,0 +1,60 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler.cpp
+//
+// Identification: src/storage/disk/disk_scheduler.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/disk_scheduler.h"
+
+#include "common/exception.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+DiskScheduler::DiskScheduler(DiskManager *disk_manager, size_t num_workers) : disk_manager_(disk_manager) {
+  BUSTUB_ASSERT(num_workers > 0, "a disk scheduler needs at least one worker");
+  workers_.reserve(num_workers);
+  for (size_t i = 0; i < num_workers; ++i) {
+    workers_.emplace_back([this] { StartWorkerThread(); });
+  }
+}
+
+DiskScheduler::~DiskScheduler() {
+  // Put one shutdown marker per worker; every request queued before them is still processed.
+  for (size_t i = 0; i < workers_.size(); ++i) {
+    request_queue_.Put(std::nullopt);
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+}
+
+void DiskScheduler::Schedule(DiskRequest r) { request_queue_.Put(std::make_optional(std::move(r))); }
+
+void DiskScheduler::StartWorkerThread() {
+  while (auto request = request_queue_.Get()) {
+    bool success = true;
+    try {
+      if (request->is_write_) {
+        disk_manager_->WritePage(request->page_id_, request->data_);
+      } else {
+        disk_manager_->ReadPage(request->page_id_, request->data_);
+      }
+    } catch (const Exception &e) {
+      // Nobody may be waiting on the request; the issuer learns about the failure from the result.
+      success = false;
+    }
+    if (request->on_complete_) {
+      request->on_complete_(success);
+    }
+    request->callback_.set_value(success);
+  }
+}
+
+}  // namespace bustub
@@ -1,4 +1,7 @@
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <thread>  // NOLINT
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -40,6 +43,9 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   }
   if (transaction != nullptr) {
     auto [node, root_locked] = FindLeaf(key, OPT::READ, transaction);
+    if (node == nullptr) {
+      return false;
+    }
     auto page = reinterpret_cast<LeafPage *>(node->GetData());
     auto x = page->UpperBound(key, comparator_) - 1;
     if (comparator_(page->KeyAt(x), key) == 0) {
@@ -50,6 +56,10 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
   } else {
     auto *t = new Transaction(1);
     auto [node, root_locked] = FindLeaf(key, OPT::READ, t);
+    if (node == nullptr) {
+      delete t;
+      return false;
+    }
     auto page = reinterpret_cast<LeafPage *>(node->GetData());
     auto x = page->UpperBound(key, comparator_) - 1;
     if (comparator_(page->KeyAt(x), key) == 0) {
@@ -77,10 +87,7 @@ auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
   bool result = false;
   root_latch_.WLock();
   if (root_page_id_ == INVALID_PAGE_ID) {
-    auto raw = buffer_pool_manager_->NewPage(&root_page_id_);
-    if (raw == nullptr) {
-      throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
-    }
+    auto raw = BPlusTreePage::NewTreePage(buffer_pool_manager_, &root_page_id_);
     auto page = reinterpret_cast<LeafPage *>(raw->GetData());
     page->Init(root_page_id_, INVALID_PAGE_ID, leaf_max_size_);
     page->SetNextPageId(INVALID_PAGE_ID);
@@ -121,10 +128,7 @@ INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Split(BPlusTreePage *raw_old, Transaction *t) -> std::pair<BPlusTreePage *, KeyType> {
   page_id_t rhs_id = INVALID_PAGE_ID;
   KeyType key;
-  auto raw = buffer_pool_manager_->NewPage(&rhs_id);
-  if (raw == nullptr) {
-    throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
-  }
+  auto raw = BPlusTreePage::NewTreePage(buffer_pool_manager_, &rhs_id);
   raw->WLatch();
   t->AddIntoPageSet(raw);
   if (raw_old->IsLeafPage()) {
@@ -154,18 +158,17 @@ INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::InsertToParent(BPlusTreePage *raw_page, const KeyType &key, Transaction *t) -> void {
   if (raw_page->GetParentPageId() == INVALID_PAGE_ID) {
     auto old_root = root_page_id_;
-    auto par_raw = buffer_pool_manager_->NewPage(&root_page_id_);
-    if (par_raw == nullptr) {
-      throw Exception(ExceptionType::OUT_OF_MEMORY, "Cannot allocate new page");
-    }
+    auto par_raw = BPlusTreePage::NewTreePage(buffer_pool_manager_, &root_page_id_);
     par_raw->WLatch();
     t->AddIntoPageSet(par_raw);
     auto par = reinterpret_cast<InternalPage *>(par_raw->GetData());
     par->Init(root_page_id_, INVALID_PAGE_ID, internal_max_size_);
     par->Generate(old_root, key, raw_page->GetPageId(), buffer_pool_manager_);
+    UpdateRootPageId();
     return;
   }
-  auto par = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(raw_page->GetParentPageId())->GetData());
+  auto par = reinterpret_cast<InternalPage *>(
+      BPlusTreePage::FetchTreePage(buffer_pool_manager_, raw_page->GetParentPageId())->GetData());
   if (par->GetSize() == par->GetMaxSize()) {
     auto [rhs, u] = Split(par, t);
     InsertToParent(rhs, u, t);
@@ -183,13 +186,192 @@ auto BPLUSTREE_TYPE::InsertToParent(BPlusTreePage *raw_page, const KeyType &key,
   }
 }
 
+/*****************************************************************************
+ * BULK LOAD
+ *****************************************************************************/
+namespace {
+/*
+ * Spread count entries over the pages of one level of a bulk-loaded tree. Each page gets about fill_factor of its
+ * capacity; the entries are spread evenly, so that the last page is not left below min_size unless the level has
+ * too few entries for that.
+ */
+auto BulkLoadPageSizes(size_t count, int capacity, int min_size, double fill_factor) -> std::vector<int> {
+  auto target = std::clamp(static_cast<int>(capacity * fill_factor), std::clamp(min_size, 1, capacity), capacity);
+  size_t pages = (count + target - 1) / target;
+  while (pages > 1 && count / pages < static_cast<size_t>(min_size) &&
+         (count + pages - 2) / (pages - 1) <= static_cast<size_t>(capacity)) {
+    --pages;
+  }
+  std::vector<int> sizes(pages, static_cast<int>(count / pages));
+  for (size_t i = 0; i < count % pages; ++i) {
+    ++sizes[i];
+  }
+  return sizes;
+}
+}  // namespace
+
+/*
+ * A page splits as soon as it reaches its max size, so a bulk-loaded page holds at most max size - 1 entries.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::BulkLoad(std::vector<std::pair<KeyType, ValueType>> *items, double fill_factor) -> bool {
+  root_latch_.WLock();
+  if (!IsEmpty()) {
+    root_latch_.WUnlock();
+    return false;
+  }
+  if (items->empty()) {
+    root_latch_.WUnlock();
+    return true;
+  }
+
+  // Fill the leaves left to right; each one is linked to its successor before it is unpinned.
+  std::vector<std::pair<KeyType, page_id_t>> level;
+  LeafPage *prev_leaf = nullptr;
+  auto *item = items->data();
+  for (auto size : BulkLoadPageSizes(items->size(), leaf_max_size_ - 1, leaf_max_size_ >> 1, fill_factor)) {
+    page_id_t page_id;
+    auto raw = BPlusTreePage::NewTreePage(buffer_pool_manager_, &page_id);
+    auto leaf = reinterpret_cast<LeafPage *>(raw->GetData());
+    leaf->Init(page_id, INVALID_PAGE_ID, leaf_max_size_);
+    leaf->SetNextPageId(INVALID_PAGE_ID);
+    leaf->MoveDataFrom(item, size, true);
+    item += size;
+    level.emplace_back(leaf->KeyAt(0), page_id);
+    if (prev_leaf != nullptr) {
+      prev_leaf->SetNextPageId(page_id);
+      buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), true);
+    }
+    prev_leaf = leaf;
+  }
+  buffer_pool_manager_->UnpinPage(prev_leaf->GetPageId(), true);
+
+  // Build each internal level from the first keys of the level below, until a single root remains. As after a split,
+  // the first key of an internal page is the smallest key of its subtree.
+  while (level.size() > 1) {
+    std::vector<std::pair<KeyType, page_id_t>> parents;
+    auto *child = level.data();
+    for (auto size :
+         BulkLoadPageSizes(level.size(), internal_max_size_ - 1, (internal_max_size_ + 1) >> 1, fill_factor)) {
+      page_id_t page_id;
+      auto raw = BPlusTreePage::NewTreePage(buffer_pool_manager_, &page_id);
+      auto page = reinterpret_cast<InternalPage *>(raw->GetData());
+      page->Init(page_id, INVALID_PAGE_ID, internal_max_size_);
+      // This also points the children at their new parent.
+      page->MoveDataFrom(child, size, true, buffer_pool_manager_, comparator_);
+      child += size;
+      parents.emplace_back(page->KeyAt(0), page_id);
+      buffer_pool_manager_->UnpinPage(page_id, true);
+    }
+    level = std::move(parents);
+  }
+
+  root_page_id_ = level[0].second;
+  UpdateRootPageId(true);
+  root_latch_.WUnlock();
+  return true;
+}
+
 /*
  * the leaf hasn't unpin
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, OPT opt, Transaction *t) -> std::pair<Page *, bool> {
+  bool root_locked = true;
+  if (opt == OPT::READ) {
+    for (int attempt = 0; attempt < OPTIMISTIC_READ_ATTEMPTS; ++attempt) {
+      if (!root_locked) {
+        root_latch_.RLock();
+        root_locked = true;
+        if (IsEmpty()) {
+          root_latch_.RUnlock();
+          return {nullptr, false};
+        }
+      }
+      auto leaf = FindLeafOptimistic(key, t, root_locked);
+      if (leaf != nullptr) {
+        return {leaf, root_locked};
+      }
+    }
+    // Writers keep invalidating the path: fall back to latch crabbing, which always makes progress.
+    if (!root_locked) {
+      root_latch_.RLock();
+      if (IsEmpty()) {
+        root_latch_.RUnlock();
+        return {nullptr, false};
+      }
+    }
+  }
+  return FindLeafPessimistic(key, opt, t);
+}
+
+/*
+ * Optimistic lock coupling: inner pages are pinned but never latched. The version of each inner page is validated
+ * after its child has been pinned and the child's version read, so a split or merge that changes the path makes the
+ * descent restart. Only the leaf is read latched.
+ * @return the read latched leaf, or nullptr if a concurrent writer invalidated the descent or a page could not be
+ * fetched, e.g. because every frame is pinned; everything acquired on the way is released in that case, including the
+ * root latch
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafOptimistic(const KeyType &key, Transaction *t, bool &root) -> Page * {
+  auto raw = buffer_pool_manager_->FetchPage(root_page_id_);
+  if (raw == nullptr) {
+    root_latch_.RUnlock();
+    root = false;
+    return nullptr;
+  }
+  auto version = raw->GetVersion();
+  root_latch_.RUnlock();
+  root = false;
+  while (true) {
+    auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
+    bool is_leaf = node->IsLeafPage();
+    if (!raw->ValidateVersion(version)) {
+      buffer_pool_manager_->UnpinPage(raw->GetPageId(), false);
+      return nullptr;
+    }
+    if (is_leaf) {
+      raw->RLatch();
+      if (!raw->ValidateVersion(version)) {
+        raw->RUnlatch();
+        buffer_pool_manager_->UnpinPage(raw->GetPageId(), false);
+        return nullptr;
+      }
+      t->AddIntoPageSet(raw);
+      return raw;
+    }
+    auto page = reinterpret_cast<InternalPage *>(node);
+    auto cur = page->ValueAt(page->UpperBound(key, comparator_) - 1);
+    // The child id may be garbage if a writer got in: check before following it.
+    if (!raw->ValidateVersion(version)) {
+      buffer_pool_manager_->UnpinPage(raw->GetPageId(), false);
+      return nullptr;
+    }
+    auto son_raw = buffer_pool_manager_->FetchPage(cur);
+    if (son_raw == nullptr) {
+      buffer_pool_manager_->UnpinPage(raw->GetPageId(), false);
+      return nullptr;
+    }
+    auto son_version = son_raw->GetVersion();
+    bool valid = raw->ValidateVersion(version);
+    buffer_pool_manager_->UnpinPage(raw->GetPageId(), false);
+    if (!valid) {
+      buffer_pool_manager_->UnpinPage(son_raw->GetPageId(), false);
+      return nullptr;
+    }
+    raw = son_raw;
+    version = son_version;
+  }
+}
+
+/*
+ * the leaf hasn't unpin
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::FindLeafPessimistic(const KeyType &key, OPT opt, Transaction *t) -> std::pair<Page *, bool> {
   auto cur = root_page_id_;
-  auto raw = buffer_pool_manager_->FetchPage(cur);
+  auto raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, cur);
   bool root_locked = true;
   if (LockAndSafe(raw, opt)) {
     UnLockAll(t, opt, root_locked);
@@ -200,7 +382,7 @@ auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, OPT opt, Transaction *t) -> st
     auto page = reinterpret_cast<InternalPage *>(node);
     int x = page->UpperBound(key, comparator_) - 1;
     cur = page->ValueAt(x);
-    auto son_raw = buffer_pool_manager_->FetchPage(cur);
+    auto son_raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, cur);
     if (LockAndSafe(son_raw, opt)) {
       UnLockAll(t, opt, root_locked);
     }
@@ -215,39 +397,53 @@ auto BPLUSTREE_TYPE::FindLeaf(const KeyType &key, OPT opt, Transaction *t) -> st
  * old hasn't unpin
  */
 INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t) -> bool {
+auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t, Page *left_leaf) -> bool {
   if (old->GetParentPageId() == INVALID_PAGE_ID) {
     if (old->IsLeafPage()) {
       root_page_id_ = INVALID_PAGE_ID;
+      t->AddIntoDeletedPageSet(old->GetPageId());
+      UpdateRootPageId();
     }
     return false;
   }
   bool result = false;
-  page_id_t bro_id = INVALID_PAGE_ID;
-  auto par = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(old->GetParentPageId())->GetData());
+  auto par = reinterpret_cast<InternalPage *>(
+      BPlusTreePage::FetchTreePage(buffer_pool_manager_, old->GetParentPageId())->GetData());
+  // The siblings are write latched like every page changed here, so that their versions tell optimistic readers to
+  // restart. They stay in the page set for the merge, which tries the same siblings.
+  Page *left_raw = nullptr;
+  Page *right_raw = nullptr;
+  int pos = par->UpperBound(old->IsLeafPage() ? reinterpret_cast<LeafPage *>(old)->KeyAt(0)
+                                              : reinterpret_cast<InternalPage *>(old)->KeyAt(0),
+                            comparator_) -
+            1;
+  if (pos > 0 && old->IsLeafPage()) {
+    BUSTUB_ASSERT(left_leaf != nullptr, "the left sibling of a leaf must be latched before the leaf changes");
+    left_raw = left_leaf;
+  } else if (pos > 0) {
+    left_raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, par->ValueAt(pos - 1));
+    left_raw->WLatch();
+    t->AddIntoPageSet(left_raw);
+  }
+  if (pos < par->GetSize() - 1) {
+    right_raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, par->ValueAt(pos + 1));
+    right_raw->WLatch();
+    t->AddIntoPageSet(right_raw);
+  }
 
   // Redistribute
   if (old->IsLeafPage()) {
     auto page = reinterpret_cast<LeafPage *>(old);
-    int pos = par->UpperBound(page->KeyAt(0), comparator_) - 1;
-    if (pos > 0) {
-      bro_id = par->ValueAt(pos - 1);
-      auto bro_raw = buffer_pool_manager_->FetchPage(bro_id);
-      bro_raw->WLatch();
-      t->AddIntoPageSet(bro_raw);
-      auto bro = reinterpret_cast<LeafPage *>(bro_raw->GetData());
+    if (left_raw != nullptr) {
+      auto bro = reinterpret_cast<LeafPage *>(left_raw->GetData());
       if (bro->GetSize() + old->GetSize() >= 2 * bro->GetMinSize()) {
         bro->MoveHalfTo(page, 1);
         par->SetKeyAt(pos, page->KeyAt(0));
         result = true;
       }
     }
-    if (!result && pos < par->GetSize() - 1) {
-      bro_id = par->ValueAt(pos + 1);
-      auto bro_raw = buffer_pool_manager_->FetchPage(bro_id);
-      bro_raw->WLatch();
-      t->AddIntoPageSet(bro_raw);
-      auto bro = reinterpret_cast<LeafPage *>(bro_raw->GetData());
+    if (!result && right_raw != nullptr) {
+      auto bro = reinterpret_cast<LeafPage *>(right_raw->GetData());
       if (bro->GetSize() + old->GetSize() >= 2 * bro->GetMinSize()) {
         bro->MoveHalfTo(page, 0);
         par->SetKeyAt(pos + 1, bro->KeyAt(0));
@@ -256,25 +452,16 @@ auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t) ->
     }
   } else {
     auto page = reinterpret_cast<InternalPage *>(old);
-    int pos = par->UpperBound(page->KeyAt(0), comparator_) - 1;
-    if (pos > 0) {
-      bro_id = par->ValueAt(pos - 1);
-      auto bro_raw = buffer_pool_manager_->FetchPage(bro_id);
-      bro_raw->WLatch();
-      t->AddIntoPageSet(bro_raw);
-      auto bro = reinterpret_cast<InternalPage *>(bro_raw->GetData());
+    if (left_raw != nullptr) {
+      auto bro = reinterpret_cast<InternalPage *>(left_raw->GetData());
       if (bro->GetSize() + old->GetSize() >= 2 * bro->GetMinSize()) {
         bro->MoveHalfTo(page, 1, buffer_pool_manager_, comparator_);
         par->SetKeyAt(pos, page->KeyAt(0));
         result = true;
       }
     }
-    if (!result && pos < par->GetSize() - 1) {
-      bro_id = par->ValueAt(pos + 1);
-      auto bro_raw = buffer_pool_manager_->FetchPage(bro_id);
-      bro_raw->WLatch();
-      t->AddIntoPageSet(bro_raw);
-      auto bro = reinterpret_cast<InternalPage *>(bro_raw->GetData());
+    if (!result && right_raw != nullptr) {
+      auto bro = reinterpret_cast<InternalPage *>(right_raw->GetData());
       if (bro->GetSize() + old->GetSize() >= 2 * bro->GetMinSize()) {
         bro->MoveHalfTo(page, 0, buffer_pool_manager_, comparator_);
         par->SetKeyAt(pos + 1, bro->KeyAt(0));
@@ -290,15 +477,15 @@ auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t) ->
   // Merge
   if (old->IsLeafPage()) {
     auto page = reinterpret_cast<LeafPage *>(old);
-    int pos = par->UpperBound(page->KeyAt(0), comparator_) - 1;
-    if (pos > 0) {
-      bro_id = par->ValueAt(pos - 1);
-      auto bro = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(bro_id)->GetData());
+    if (left_raw != nullptr) {
+      auto bro = reinterpret_cast<LeafPage *>(left_raw->GetData());
       if (bro->GetSize() + page->GetSize() <= bro->GetMaxSize()) {
         par->Remove(page->KeyAt(0), buffer_pool_manager_, comparator_);
         page->MoveAllToLeft(bro);
+        t->AddIntoDeletedPageSet(page->GetPageId());
         if (par->GetSize() < par->GetMinSize()) {
           if (!RedistributeAndMerge(reinterpret_cast<BPlusTreePage *>(par), t)) {
+            t->AddIntoDeletedPageSet(par->GetPageId());
             root_page_id_ = bro->GetPageId();
             bro->SetParentPageId(INVALID_PAGE_ID);
             UpdateRootPageId();
@@ -306,16 +493,16 @@ auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t) ->
         }
         result = true;
       }
-      buffer_pool_manager_->UnpinPage(bro_id, result);
     }
-    if (!result && pos < par->GetSize() - 1) {
-      bro_id = par->ValueAt(pos + 1);
-      auto bro = reinterpret_cast<LeafPage *>(buffer_pool_manager_->FetchPage(bro_id)->GetData());
+    if (!result && right_raw != nullptr) {
+      auto bro = reinterpret_cast<LeafPage *>(right_raw->GetData());
       if (bro->GetSize() + page->GetSize() <= bro->GetMaxSize()) {
         par->Remove(bro->KeyAt(0), buffer_pool_manager_, comparator_);
         bro->MoveAllToLeft(page);
+        t->AddIntoDeletedPageSet(bro->GetPageId());
         if (par->GetSize() < par->GetMinSize()) {
           if (!RedistributeAndMerge(reinterpret_cast<BPlusTreePage *>(par), t)) {
+            t->AddIntoDeletedPageSet(par->GetPageId());
             root_page_id_ = page->GetPageId();
             page->SetParentPageId(INVALID_PAGE_ID);
             UpdateRootPageId();
@@ -323,19 +510,18 @@ auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t) ->
         }
         result = true;
       }
-      buffer_pool_manager_->UnpinPage(bro_id, result);
     }
   } else {
     auto page = reinterpret_cast<InternalPage *>(old);
-    int pos = par->UpperBound(page->KeyAt(0), comparator_) - 1;
-    if (pos > 0) {
-      bro_id = par->ValueAt(pos - 1);
-      auto bro = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(bro_id)->GetData());
+    if (left_raw != nullptr) {
+      auto bro = reinterpret_cast<InternalPage *>(left_raw->GetData());
       if (bro->GetSize() + page->GetSize() <= bro->GetMaxSize()) {
         par->Remove(page->KeyAt(0), buffer_pool_manager_, comparator_);
         page->MoveAllToLeft(bro, buffer_pool_manager_, comparator_);
+        t->AddIntoDeletedPageSet(page->GetPageId());
         if (par->GetSize() < par->GetMinSize()) {
           if (!RedistributeAndMerge(reinterpret_cast<BPlusTreePage *>(par), t)) {
+            t->AddIntoDeletedPageSet(par->GetPageId());
             root_page_id_ = bro->GetPageId();
             bro->SetParentPageId(INVALID_PAGE_ID);
             UpdateRootPageId();
@@ -343,16 +529,16 @@ auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t) ->
         }
         result = true;
       }
-      buffer_pool_manager_->UnpinPage(bro_id, result);
     }
-    if (!result && pos < par->GetSize() - 1) {
-      bro_id = par->ValueAt(pos + 1);
-      auto bro = reinterpret_cast<InternalPage *>(buffer_pool_manager_->FetchPage(bro_id)->GetData());
+    if (!result && right_raw != nullptr) {
+      auto bro = reinterpret_cast<InternalPage *>(right_raw->GetData());
       if (bro->GetSize() + page->GetSize() <= bro->GetMaxSize()) {
         par->Remove(bro->KeyAt(0), buffer_pool_manager_, comparator_);
         bro->MoveAllToLeft(page, buffer_pool_manager_, comparator_);
+        t->AddIntoDeletedPageSet(bro->GetPageId());
         if (par->GetSize() < par->GetMinSize()) {
           if (!RedistributeAndMerge(reinterpret_cast<BPlusTreePage *>(par), t)) {
+            t->AddIntoDeletedPageSet(par->GetPageId());
             root_page_id_ = page->GetPageId();
             page->SetParentPageId(INVALID_PAGE_ID);
             UpdateRootPageId();
@@ -360,7 +546,6 @@ auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t) ->
         }
         result = true;
       }
-      buffer_pool_manager_->UnpinPage(bro_id, result);
     }
   }
   buffer_pool_manager_->UnpinPage(par->GetPageId(), result);
@@ -379,32 +564,90 @@ auto BPLUSTREE_TYPE::RedistributeAndMerge(BPlusTreePage *old, Transaction *t) ->
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-  root_latch_.WLock();
-  if (IsEmpty()) {
-    root_latch_.WUnlock();
-    return;
-  }
+  std::unique_ptr<Transaction> own_txn;
   if (transaction == nullptr) {
-    auto *t = new Transaction(1);
-    auto [raw, root_locked] = FindLeaf(key, OPT::REMOVE, t);
-    auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
-    reinterpret_cast<LeafPage *>(node)->Remove(key, comparator_);
-    if (node->GetSize() < node->GetMinSize()) {
-      RedistributeAndMerge(node, t);
+    own_txn = std::make_unique<Transaction>(1);
+    transaction = own_txn.get();
+  }
+  while (true) {
+    root_latch_.WLock();
+    if (IsEmpty()) {
+      root_latch_.WUnlock();
+      return;
     }
-    UnLockAll(t, OPT::REMOVE, root_locked);
-    delete t;
-  } else {
     auto [raw, root_locked] = FindLeaf(key, OPT::REMOVE, transaction);
     auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
+    Page *left_raw = nullptr;
+    if (node->GetSize() <= node->GetMinSize() && !TryLatchLeftLeaf(node, transaction, &left_raw)) {
+      // An iterator holds the left sibling and may wait for this leaf: let it pass and start over.
+      UnLockAll(transaction, OPT::REMOVE, root_locked);
+      std::this_thread::yield();
+      continue;
+    }
     reinterpret_cast<LeafPage *>(node)->Remove(key, comparator_);
     if (node->GetSize() < node->GetMinSize()) {
-      RedistributeAndMerge(node, transaction);
+      RedistributeAndMerge(node, transaction, left_raw);
     }
     UnLockAll(transaction, OPT::REMOVE, root_locked);
+    DeletePages(transaction);
+    return;
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::TryLatchLeftLeaf(BPlusTreePage *leaf, Transaction *t, Page **left_raw) -> bool {
+  *left_raw = nullptr;
+  if (leaf->GetParentPageId() == INVALID_PAGE_ID) {
+    return true;
+  }
+  // The parent is write latched in the page set, since the leaf is not safe for a remove.
+  auto par_raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, leaf->GetParentPageId());
+  auto par = reinterpret_cast<InternalPage *>(par_raw->GetData());
+  int pos = par->UpperBound(reinterpret_cast<LeafPage *>(leaf)->KeyAt(0), comparator_) - 1;
+  auto left_id = pos > 0 ? par->ValueAt(pos - 1) : INVALID_PAGE_ID;
+  buffer_pool_manager_->UnpinPage(par_raw->GetPageId(), false);
+  if (left_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  auto raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, left_id);
+  if (!raw->TryWLatch()) {
+    buffer_pool_manager_->UnpinPage(left_id, false);
+    return false;
+  }
+  t->AddIntoPageSet(raw);
+  *left_raw = raw;
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::DeletePages(Transaction *t) {
+  std::vector<page_id_t> page_ids;
+  {
+    std::scoped_lock lock(deferred_pages_mutex_);
+    page_ids.swap(deferred_pages_);
+  }
+  page_ids.insert(page_ids.end(), t->GetDeletedPageSet()->begin(), t->GetDeletedPageSet()->end());
+  t->GetDeletedPageSet()->clear();
+  std::vector<page_id_t> pinned;
+  for (auto page_id : page_ids) {
+    // A reader that followed a stale pointer may still pin the page; it is then retried later rather than waited for,
+    // since the reader may be an iterator of this very thread.
+    if (buffer_pool_manager_->TryDeletePage(page_id) == BufferPoolManager::DeletePageResult::PINNED) {
+      pinned.push_back(page_id);
+    }
+  }
+  if (!pinned.empty()) {
+    std::scoped_lock lock(deferred_pages_mutex_);
+    deferred_pages_.insert(deferred_pages_.end(), pinned.begin(), pinned.end());
   }
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::GetNumDeferredPages() -> size_t {
+  std::scoped_lock lock(deferred_pages_mutex_);
+  return deferred_pages_.size();
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::LockAndSafe(Page *page, OPT opt) -> bool {
   if (opt == OPT::READ) {
@@ -421,7 +664,6 @@ auto BPLUSTREE_TYPE::LockAndSafe(Page *page, OPT opt) -> bool {
 
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::UnLockAll(Transaction *t, OPT opt, bool &root) -> void {
-  UpdateRootPageId();
   while (!t->GetPageSet()->empty()) {
     auto page = t->GetPageSet()->front();
     t->GetPageSet()->pop_front();
@@ -459,14 +701,14 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
     return INDEXITERATOR_TYPE();
   }
   auto cur = root_page_id_;
-  Page *raw = buffer_pool_manager_->FetchPage(cur);
+  Page *raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, cur);
   raw->RLatch();
   root_latch_.RUnlock();
   auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
   while (!node->IsLeafPage()) {
     auto page = reinterpret_cast<InternalPage *>(node);
     cur = page->ValueAt(0);
-    auto son_raw = buffer_pool_manager_->FetchPage(cur);
+    auto son_raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, cur);
     son_raw->RLatch();
     raw->RUnlatch();
     raw = son_raw;
@@ -478,15 +720,19 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
 }
 
 /*
- * Input parameter is low key, find the leaf page that contains the input key
- * first, then construct index iterator
+ * Input parameter is low key, find the leaf page that contains the first key
+ * not less than the input key, then construct index iterator
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
   root_latch_.RLock();
+  if (IsEmpty()) {
+    root_latch_.RUnlock();
+    return INDEXITERATOR_TYPE();
+  }
   auto cur = root_page_id_;
-  auto raw = buffer_pool_manager_->FetchPage(cur);
+  auto raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, cur);
   raw->RLatch();
   root_latch_.RUnlock();
   auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
@@ -498,7 +744,7 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
       x = 0;
     }
     cur = page->ValueAt(x);
-    auto son_raw = buffer_pool_manager_->FetchPage(cur);
+    auto son_raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, cur);
     son_raw->RLatch();
     raw->RUnlatch();
     raw = son_raw;
@@ -506,12 +752,22 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
     node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
   }
 
-  x = reinterpret_cast<LeafPage *>(node)->UpperBound(key, comparator_) - 1;
-  if (comparator_(reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node)->KeyAt(x), key) != 0) {
-    BUSTUB_ASSERT(0, "Begin key not found");
+  auto leaf = reinterpret_cast<LeafPage *>(node);
+  x = leaf->UpperBound(key, comparator_);
+  if (x > 0 && comparator_(leaf->KeyAt(x - 1), key) == 0) {
+    x--;
+  }
+  if (x == leaf->GetSize() && leaf->GetNextPageId() != INVALID_PAGE_ID) {
+    // every key of this leaf is less than the input key, so the first one that is not starts the next leaf
+    auto next_raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, leaf->GetNextPageId());
+    next_raw->RLatch();
+    raw->RUnlatch();
+    buffer_pool_manager_->UnpinPage(leaf->GetPageId(), false);
+    leaf = reinterpret_cast<LeafPage *>(next_raw->GetData());
+    x = 0;
   }
   // raw->RUnlatch();
-  return IndexIterator(buffer_pool_manager_, reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(node), x);
+  return IndexIterator(buffer_pool_manager_, leaf, x);
 }
 
 /*
@@ -527,14 +783,14 @@ auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE {
     return INDEXITERATOR_TYPE();
   }
   auto cur = root_page_id_;
-  auto raw = buffer_pool_manager_->FetchPage(cur);
+  auto raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, cur);
   raw->RLatch();
   root_latch_.RUnlock();
   auto node = reinterpret_cast<BPlusTreePage *>(raw->GetData());
   while (!node->IsLeafPage()) {
     auto page = reinterpret_cast<InternalPage *>(node);
     cur = page->ValueAt(page->GetSize() - 1);
-    auto son_raw = buffer_pool_manager_->FetchPage(cur);
+    auto son_raw = BPlusTreePage::FetchTreePage(buffer_pool_manager_, cur);
     son_raw->RLatch();
     raw->RUnlatch();
     raw = son_raw;
@@ -559,24 +815,35 @@ auto BPLUSTREE_TYPE::GetRootPageId(bool create) -> page_id_t {
  * UTILITIES AND DEBUG
  *****************************************************************************/
 /*
- * Update/Insert root page id in header page(where page_id = 0, header_page is
- * defined under include/page/header_page.h)
- * Call this method everytime root page id is changed.
- * @parameter: insert_record      defualt value is false. When set to true,
- * insert a record <index_name, root_page_id> into header page instead of
- * updating it.
+ * Persist root_page_id_ in the header page (page_id = 0, header_page is defined under include/page/header_page.h).
+ * Call this method every time root page id is changed, while still holding root_latch_ in write mode, so that the
+ * records of one index are written in the order its root changes. Lookups only read root_page_id_, which is the
+ * cached copy of the record, and never touch the header page.
+ * @parameter: insert_record      default value is false. When set to true, the record <index_name, root_page_id> is
+ * expected not to exist yet; a missing record is inserted either way, e.g. for a tree that grows a root again after
+ * it was emptied. The header page is shared by all indexes, so it is latched while its records are read and written,
+ * and it is only dirtied if the record actually changes.
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
+  auto *page = BPlusTreePage::FetchTreePage(buffer_pool_manager_, HEADER_PAGE_ID);
+  if (page == nullptr) {
+    LOG_WARN("no header page to record the root of %s in", index_name_.c_str());
+    return;
+  }
+  auto *header_page = reinterpret_cast<HeaderPage *>(page);
+  bool dirty = false;
+  header_page->WLatch();
+  page_id_t recorded_root_page_id;
+  if (!header_page->GetRootId(index_name_, &recorded_root_page_id)) {
     // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
+    dirty = root_page_id_ != INVALID_PAGE_ID && header_page->InsertRecord(index_name_, root_page_id_);
+  } else if (recorded_root_page_id != root_page_id_) {
     // update root_page_id in header_page
-    header_page->UpdateRecord(index_name_, root_page_id_);
+    dirty = header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  header_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, dirty);
 }
 
 /*
@@ -11,40 +11,153 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace bustub {
+
+namespace {
+
+/**
+ * Walks the entries of a B+ tree index whose first key column lies within bounds. A bound is the normalized encoding
+ * of a first key column, and since that encoding is prefix-free, comparing it with the same number of leading bytes
+ * of a key compares the first column of the key.
+ */
+template <typename KeyType, typename Iterator, typename Tree>
+class BPlusTreeIndexScanIterator : public IndexScanIterator {
+ public:
+  /**
+   * @param tree the tree to scan
+   * @param lower the lower bound padded with zeroes, that is the smallest key whose first column is the bound
+   * @param lower_size the size of the lower bound, or 0 for no lower bound
+   * @param lower_inclusive whether keys whose first column equals the lower bound are scanned
+   * @param upper the upper bound
+   * @param upper_size the size of the upper bound, or 0 for no upper bound
+   * @param upper_inclusive whether keys whose first column equals the upper bound are scanned
+   */
+  BPlusTreeIndexScanIterator(Tree *tree, const KeyType &lower, size_t lower_size, bool lower_inclusive,
+                             const KeyType &upper, size_t upper_size, bool upper_inclusive)
+      : iter_(Begin(tree, lower, lower_size)),
+        upper_(upper),
+        upper_size_(upper_size),
+        upper_inclusive_(upper_inclusive) {
+    if (lower_size > 0 && !lower_inclusive) {
+      while (!iter_.IsEnd() && memcmp((*iter_).first.data_, lower.data_, lower_size) == 0) {
+        ++iter_;
+      }
+    }
+  }
+
+  auto IsEnd() -> bool override {
+    if (iter_.IsEnd()) {
+      return true;
+    }
+    if (upper_size_ == 0) {
+      return false;
+    }
+    int cmp = memcmp((*iter_).first.data_, upper_.data_, upper_size_);
+    return upper_inclusive_ ? cmp > 0 : cmp >= 0;
+  }
+
+  auto GetRid() -> RID override { return (*iter_).second; }
+
+  void Next() override { ++iter_; }
+
+ private:
+  // The iterator releases its leaf when destroyed, so it is never copied: it is returned straight into iter_.
+  static auto Begin(Tree *tree, const KeyType &lower, size_t lower_size) -> Iterator {
+    if (lower_size == 0) {
+      return tree->Begin();
+    }
+    return tree->Begin(lower);
+  }
+
+  Iterator iter_;
+  KeyType upper_;
+  size_t upper_size_;
+  bool upper_inclusive_;
+};
+
+}  // namespace
+
 /*
  * Constructor
  */
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
     : Index(std::move(metadata)),
-      comparator_(GetMetadata()->GetKeySchema()),
+      comparator_(GetMetadata()->GetKeySchema(), true),
       container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
-  // construct insert index key
+  // construct insert index key, which the RID makes unique
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema(), rid);
   container_.Insert(index_key, rid, transaction);
 }
 
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::KeyFits(const Tuple &key) const -> bool {
+  // same test as SetFromKey: the normalized key and the RID after it
+  KeyType index_key;
+  size_t size = KeyNormalizer::Normalize(key, *GetKeySchema(), index_key.data_, sizeof(index_key.data_));
+  return size != 0 && size + KeyNormalizer::RID_SIZE <= sizeof(index_key.data_);
+}
+
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
-  // construct delete index key
+  // construct delete index key, so that only the entry of this RID is removed
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, *GetKeySchema(), rid);
 
   container_.Remove(index_key, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
-  // construct scan index key
+  // construct scan index key, the smallest entry of the key, and collect the entries that start with it
   KeyType index_key;
-  index_key.SetFromKey(key);
+  memset(index_key.data_, 0, sizeof(index_key.data_));
+  size_t key_size = KeyNormalizer::Normalize(key, *GetKeySchema(), index_key.data_, sizeof(index_key.data_));
+  if (key_size == 0 || key_size + KeyNormalizer::RID_SIZE > sizeof(index_key.data_)) {
+    // too long to have been inserted
+    return;
+  }
+  BPlusTreeIndexScanIterator<KeyType, INDEXITERATOR_TYPE, BPlusTree<KeyType, ValueType, KeyComparator>> iter(
+      &container_, index_key, key_size, true, index_key, key_size, true);
+  for (; !iter.IsEnd(); iter.Next()) {
+    result->push_back(iter.GetRid());
+  }
+}
 
-  container_.GetValue(index_key, result, transaction);
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::Scan(const std::optional<Value> &lower_bound, bool lower_inclusive,
+                                const std::optional<Value> &upper_bound, bool upper_inclusive,
+                                Transaction *transaction) -> std::unique_ptr<IndexScanIterator> {
+  KeyType lower;
+  KeyType upper;
+  // A bound that does not fit in a key is left out. The scan then returns more entries than asked for, which the
+  // filter that the bounds come from removes.
+  size_t lower_size = lower_bound.has_value() ? NormalizeBound(*lower_bound, &lower) : 0;
+  size_t upper_size = upper_bound.has_value() ? NormalizeBound(*upper_bound, &upper) : 0;
+  return std::make_unique<
+      BPlusTreeIndexScanIterator<KeyType, INDEXITERATOR_TYPE, BPlusTree<KeyType, ValueType, KeyComparator>>>(
+      &container_, lower, lower_size, lower_inclusive, upper, upper_size, upper_inclusive);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::NormalizeBound(const Value &bound, KeyType *key) -> size_t {
+  auto bound_schema = Schema::CopySchema(GetKeySchema(), {0});
+  memset(key->data_, 0, sizeof(key->data_));
+  return KeyNormalizer::Normalize(Tuple({bound}, &bound_schema), bound_schema, key->data_, sizeof(key->data_));
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_INDEX_TYPE::BulkLoad(std::vector<std::pair<KeyType, RID>> *entries) -> bool {
+  std::sort(entries->begin(), entries->end(),
+            [this](const auto &lhs, const auto &rhs) { return comparator_(lhs.first, rhs.first) < 0; });
+  return container_.BulkLoad(entries);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
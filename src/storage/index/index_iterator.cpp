@@ -16,7 +16,11 @@ INDEXITERATOR_TYPE::IndexIterator() : page_(nullptr) {}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, B_PLUS_TREE_LEAF_PAGE_TYPE *page, int i)
-    : bpm_(bpm), page_(page), index_(i) {}
+    : bpm_(bpm), page_(page), index_(i) {
+  if (page_ != nullptr) {
+    bpm_->PrefetchPage(page_->GetNextPageId());
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::~IndexIterator() {
@@ -47,16 +51,19 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
     return *this;
   }
   if ((page_->GetSize() == index_ + 1) && (page_->GetNextPageId() != INVALID_PAGE_ID)) {
-    auto nxt_raw = bpm_->FetchPage(page_->GetNextPageId());
+    auto nxt_raw = BPlusTreePage::FetchTreePage(bpm_, page_->GetNextPageId());
     auto nxt = reinterpret_cast<B_PLUS_TREE_LEAF_PAGE_TYPE *>(nxt_raw->GetData());
+    // Fetch the leaf again only to reach its latch; drop that pin and the one the iterator held, and no more, since
+    // another thread may pin the leaf meanwhile.
     auto raw = bpm_->FetchPage(page_->GetPageId());
-    bpm_->UnpinPage(raw->GetPageId(), false);
     nxt_raw->RLatch();
     raw->RUnlatch();
     bpm_->UnpinPage(raw->GetPageId(), false);
-    bpm_->UnpinPage(page_->GetPageId(), false);
+    bpm_->UnpinPage(raw->GetPageId(), false);
     index_ = 0;
     page_ = nxt;
+    // Start reading the following leaf while this one is consumed.
+    bpm_->PrefetchPage(page_->GetNextPageId());
   } else {
     ++index_;
   }
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_normalizer.cpp
+//
+// Identification: src/storage/index/key_normalizer.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/index/key_normalizer.h"
+
+#include <cstring>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+namespace {
+
+/** Store the low `size` bytes of value most significant first. */
+void StoreBigEndian(uint64_t value, size_t size, char *dst) {
+  for (size_t i = 0; i < size; i++) {
+    dst[i] = static_cast<char>(value >> (8 * (size - 1 - i)));
+  }
+}
+
+}  // namespace
+
+auto KeyNormalizer::GetNormalizedSize(const Schema &key_schema) -> size_t {
+  size_t size = 0;
+  for (const auto &col : key_schema.GetColumns()) {
+    // marker, characters and terminator
+    size += col.IsInlined() ? col.GetFixedLength() : 2 + col.GetVariableLength();
+  }
+  return size;
+}
+
+auto KeyNormalizer::Normalize(const Tuple &key, const Schema &key_schema, char *dst, size_t capacity) -> size_t {
+  size_t size = 0;
+  for (uint32_t i = 0; i < key_schema.GetColumnCount(); i++) {
+    const auto &col = key_schema.GetColumn(i);
+    auto value = key.GetValue(&key_schema, i);
+    uint64_t bits;
+    switch (col.GetType()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        bits = static_cast<uint8_t>(value.GetAs<int8_t>()) ^ 0x80U;
+        break;
+      case TypeId::SMALLINT:
+        bits = static_cast<uint16_t>(value.GetAs<int16_t>()) ^ 0x8000U;
+        break;
+      case TypeId::INTEGER:
+        bits = static_cast<uint32_t>(value.GetAs<int32_t>()) ^ 0x80000000U;
+        break;
+      case TypeId::BIGINT:
+        bits = static_cast<uint64_t>(value.GetAs<int64_t>()) ^ (1ULL << 63);
+        break;
+      case TypeId::TIMESTAMP:
+        bits = value.GetAs<uint64_t>();
+        break;
+      case TypeId::DECIMAL: {
+        auto decimal = value.GetAs<double>();
+        memcpy(&bits, &decimal, sizeof(bits));
+        bits = (bits >> 63) != 0 ? ~bits : bits ^ (1ULL << 63);
+        break;
+      }
+      case TypeId::VARCHAR: {
+        if (value.IsNull()) {
+          if (size + 1 > capacity) {
+            return 0;
+          }
+          dst[size++] = 0;
+          continue;
+        }
+        // the length of a varchar value counts its terminator
+        size_t len = strnlen(value.GetData(), value.GetLength() - 1);
+        if (size + len + 2 > capacity) {
+          return 0;
+        }
+        dst[size] = 1;
+        memcpy(dst + size + 1, value.GetData(), len);
+        dst[size + len + 1] = 0;
+        size += len + 2;
+        continue;
+      }
+      default:
+        throw Exception(ExceptionType::MISMATCH_TYPE, "cannot build an index key of this type");
+    }
+    size_t width = col.GetFixedLength();
+    if (size + width > capacity) {
+      return 0;
+    }
+    StoreBigEndian(bits, width, dst + size);
+    size += width;
+  }
+  return size;
+}
+
+void KeyNormalizer::NormalizeRid(const RID &rid, char *dst) {
+  StoreBigEndian(static_cast<uint32_t>(rid.GetPageId()), sizeof(page_id_t), dst);
+  StoreBigEndian(rid.GetSlotNum(), sizeof(uint32_t), dst + sizeof(page_id_t));
+}
+
+}  // namespace bustub
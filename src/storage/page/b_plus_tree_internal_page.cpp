@@ -53,9 +53,8 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetValueAt(const int &index, const ValueTyp
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::UpperBound(const KeyType &key, const KeyComparator &comparator) -> int {
-  return std::upper_bound(array_ + 1, array_ + GetSize(), key,
-                          [&comparator](auto key, const auto &pair1) { return comparator(pair1.first, key) > 0; }) -
-         array_;
+  // the first key is invalid
+  return comparator.UpperBound(array_ + 1, GetSize() - 1, key) + 1;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -76,7 +75,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Insert(const KeyType &key, const ValueType
   }
   std::move_backward(array_ + i, array_ + GetSize(), array_ + GetSize() + 1);
   array_[i] = {key, val};
-  auto page = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(bpm->FetchPage(val)->GetData());
+  auto page = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(FetchTreePage(bpm, val)->GetData());
   page->SetParentPageId(GetPageId());
   bpm->UnpinPage(val, true);
   IncreaseSize(1);
@@ -98,7 +97,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *dst_page,
     dst_page->MoveDataFrom(array_ + new_size, GetSize() - new_size, 0, bpm, comparator);
   } else {
     if (GetParentPageId() != INVALID_PAGE_ID) {
-      auto raw = bpm->FetchPage(GetParentPageId());
+      auto raw = FetchTreePage(bpm, GetParentPageId());
       auto par = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(raw->GetData());
       auto x = par->UpperBound(KeyAt(0), comparator) - 1;
       par->SetKeyAt(x, KeyAt(GetSize() - new_size));
@@ -121,7 +120,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveDataFrom(MappingType *items, int size,
     std::move_backward(array_, array_ + GetSize(), array_ + GetSize() + size);
     std::move(items, items + size, array_);
     if (GetParentPageId() != INVALID_PAGE_ID) {
-      auto raw = bpm->FetchPage(GetParentPageId());
+      auto raw = FetchTreePage(bpm, GetParentPageId());
       auto par = reinterpret_cast<B_PLUS_TREE_INTERNAL_PAGE_TYPE *>(raw->GetData());
       auto x = par->UpperBound(key, comparator) - 1;
       par->SetKeyAt(x, KeyAt(0));
@@ -129,7 +128,7 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveDataFrom(MappingType *items, int size,
     }
   }
   for (int i = 0; i < size; ++i) {
-    auto raw_page = bpm->FetchPage(ValueAt(i + j));
+    auto raw_page = FetchTreePage(bpm, ValueAt(i + j));
     auto page = reinterpret_cast<BPlusTreePage *>(raw_page->GetData());
     page->SetParentPageId(GetPageId());
     bpm->UnpinPage(ValueAt(i + j), true);
@@ -144,10 +143,10 @@ auto B_PLUS_TREE_INTERNAL_PAGE_TYPE::Generate(const ValueType &left, const KeyTy
   SetKeyAt(1, rhs);
   SetValueAt(0, left);
   SetValueAt(1, right);
-  auto lp = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(left)->GetData());
+  auto lp = reinterpret_cast<BPlusTreePage *>(FetchTreePage(bpm, left)->GetData());
   lp->SetParentPageId(GetPageId());
   bpm->UnpinPage(left, true);
-  auto rp = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(right)->GetData());
+  auto rp = reinterpret_cast<BPlusTreePage *>(FetchTreePage(bpm, right)->GetData());
   rp->SetParentPageId(GetPageId());
   bpm->UnpinPage(right, true);
 }
@@ -68,9 +68,7 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &val
 
 INDEX_TEMPLATE_ARGUMENTS
 auto B_PLUS_TREE_LEAF_PAGE_TYPE::UpperBound(const KeyType &key, const KeyComparator &comparator) -> int {
-  return std::upper_bound(array_, array_ + GetSize(), key,
-                          [&comparator](auto key, const auto &pair1) { return comparator(pair1.first, key) > 0; }) -
-         array_;
+  return comparator.UpperBound(array_, GetSize(), key);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -11,6 +11,11 @@
 
 #include "storage/page/b_plus_tree_page.h"
 
+#include <chrono>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "common/exception.h"
+
 namespace bustub {
 
 /*
@@ -69,4 +74,30 @@ void BPlusTreePage::SetPageId(const page_id_t &page_id) { page_id_ = page_id; }
  */
 void BPlusTreePage::SetLSN(const lsn_t &lsn) { lsn_ = lsn; }
 
+/*
+ * Helper methods to get pages while other operations hold most of the pool
+ */
+template <typename F>
+static auto RetryWhilePoolFull(F get_page) -> Page * {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(BPlusTreePage::FULL_POOL_WAIT_MS);
+  while (true) {
+    auto *page = get_page();
+    if (page != nullptr) {
+      return page;
+    }
+    if (std::chrono::steady_clock::now() > deadline) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "all frames of the buffer pool are pinned");
+    }
+    std::this_thread::yield();
+  }
+}
+
+auto BPlusTreePage::FetchTreePage(BufferPoolManager *bpm, page_id_t page_id) -> Page * {
+  return RetryWhilePoolFull([&] { return bpm->FetchPage(page_id); });
+}
+
+auto BPlusTreePage::NewTreePage(BufferPoolManager *bpm, page_id_t *page_id) -> Page * {
+  return RetryWhilePoolFull([&] { return bpm->NewPage(page_id); });
+}
+
 }  // namespace bustub
@@ -12,7 +12,9 @@
 
 #include "storage/page/table_page.h"
 
+#include <algorithm>
 #include <cassert>
+#include <vector>
 
 namespace bustub {
 
@@ -208,7 +210,7 @@ auto TablePage::UpdateTuple(const Tuple &new_tuple, Tuple *old_tuple, const RID
   return true;
 }
 
-void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
+void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_manager, Tuple *deleted_tuple) {
   uint32_t slot_num = rid.GetSlotNum();
   BUSTUB_ASSERT(slot_num < GetTupleCount(), "Cannot have more slots than tuples.");
 
@@ -257,6 +259,9 @@ void TablePage::ApplyDelete(const RID &rid, Transaction *txn, LogManager *log_ma
       SetTupleOffsetAtSlot(i, tuple_offset_i + tuple_size);
     }
   }
+  if (deleted_tuple != nullptr) {
+    *deleted_tuple = delete_tuple;
+  }
 }
 
 void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log_manager) {
@@ -282,6 +287,36 @@ void TablePage::RollbackDelete(const RID &rid, Transaction *txn, LogManager *log
   }
 }
 
+auto TablePage::Compact() -> uint32_t {
+  auto free_space = GetFreeSpaceRemaining();
+  // Drop the empty slots at the end of the slot array. Empty slots in the middle stay, as the tuples after them keep
+  // their rids.
+  auto tuple_count = GetTupleCount();
+  while (tuple_count > 0 && GetTupleSize(tuple_count - 1) == 0) {
+    --tuple_count;
+  }
+  SetTupleCount(tuple_count);
+
+  // Pack the tuple data against the end of the page, moving the tuples in the order of their offsets, back to front.
+  std::vector<uint32_t> slots;
+  for (uint32_t i = 0; i < tuple_count; ++i) {
+    if (GetTupleSize(i) != 0) {
+      slots.push_back(i);
+    }
+  }
+  std::sort(slots.begin(), slots.end(),
+            [this](uint32_t a, uint32_t b) { return GetTupleOffsetAtSlot(a) > GetTupleOffsetAtSlot(b); });
+  uint32_t free_space_pointer = BUSTUB_PAGE_DATA_SIZE;
+  for (auto slot : slots) {
+    uint32_t tuple_size = UnsetDeletedFlag(GetTupleSize(slot));
+    free_space_pointer -= tuple_size;
+    memmove(GetData() + free_space_pointer, GetData() + GetTupleOffsetAtSlot(slot), tuple_size);
+    SetTupleOffsetAtSlot(slot, free_space_pointer);
+  }
+  SetFreeSpacePointer(free_space_pointer);
+  return GetFreeSpaceRemaining() - free_space;
+}
+
 auto TablePage::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager) -> bool {
   // Get the current slot number.
   uint32_t slot_num = rid.GetSlotNum();
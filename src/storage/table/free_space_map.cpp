@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_space_map.cpp
+//
+// Identification: src/storage/table/free_space_map.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/table/free_space_map.h"
+
+#include <algorithm>
+
+namespace bustub {
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager) : buffer_pool_manager_(buffer_pool_manager) {
+  auto page = static_cast<FreeSpaceMapPage *>(buffer_pool_manager_->NewPage(&first_page_id_));
+  BUSTUB_ASSERT(page != nullptr, "Couldn't create a page for the free space map.");
+  page->Init();
+  buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  map_page_ids_.push_back(first_page_id_);
+  max_categories_.push_back(0);
+}
+
+FreeSpaceMap::FreeSpaceMap(BufferPoolManager *buffer_pool_manager, page_id_t first_page_id)
+    : buffer_pool_manager_(buffer_pool_manager), first_page_id_(first_page_id) {
+  auto map_page_id = first_page_id_;
+  while (map_page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(map_page_id));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the free space map.");
+    page->RLatch();
+    uint8_t max_category = 0;
+    last_page_entries_ = page->GetEntryCount();
+    for (uint32_t slot = 0; slot < last_page_entries_; ++slot) {
+      auto table_page_id = page->GetTablePageId(slot);
+      if (table_page_id != INVALID_PAGE_ID) {
+        locations_[table_page_id] = {map_page_ids_.size(), slot};
+        max_category = std::max(max_category, page->GetCategory(slot));
+      } else {
+        free_locations_.push_back({map_page_ids_.size(), slot});
+      }
+    }
+    auto next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(map_page_id, false);
+    map_page_ids_.push_back(map_page_id);
+    max_categories_.push_back(max_category);
+    map_page_id = next_page_id;
+  }
+}
+
+auto FreeSpaceMap::FindPage(uint32_t size, page_id_t skip_page_id) -> page_id_t {
+  auto required = FreeSpaceMapPage::ToRequiredCategory(size);
+  for (size_t index = 0;; ++index) {
+    page_id_t map_page_id;
+    {
+      std::scoped_lock lock(latch_);
+      if (index == map_page_ids_.size()) {
+        return INVALID_PAGE_ID;
+      }
+      if (max_categories_[index] < required) {
+        continue;
+      }
+      map_page_id = map_page_ids_[index];
+    }
+
+    auto page = static_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(map_page_id));
+    if (page == nullptr) {
+      continue;
+    }
+    page->RLatch();
+    auto found_page_id = INVALID_PAGE_ID;
+    uint8_t max_category = 0;
+    for (uint32_t slot = 0; slot < page->GetEntryCount(); ++slot) {
+      auto table_page_id = page->GetTablePageId(slot);
+      auto category = page->GetCategory(slot);
+      if (table_page_id != INVALID_PAGE_ID && table_page_id != skip_page_id && category >= required) {
+        found_page_id = table_page_id;
+        break;
+      }
+      max_category = std::max(max_category, category);
+    }
+    if (found_page_id == INVALID_PAGE_ID) {
+      // The whole map page was scanned. Tighten its bound while holding the page latch, so that a concurrent Update,
+      // which raises the bound under the write latch, cannot be overwritten.
+      std::scoped_lock lock(latch_);
+      max_categories_[index] = max_category;
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(map_page_id, false);
+    if (found_page_id != INVALID_PAGE_ID) {
+      return found_page_id;
+    }
+  }
+}
+
+auto FreeSpaceMap::Update(page_id_t table_page_id, uint32_t free_space) -> bool {
+  auto category = FreeSpaceMapPage::ToCategory(free_space);
+  Location location{};
+  page_id_t link_page_id = INVALID_PAGE_ID;
+  page_id_t map_page_id;
+  {
+    std::scoped_lock lock(latch_);
+    auto it = locations_.find(table_page_id);
+    if (it != locations_.end()) {
+      location = it->second;
+    } else if (!Reserve(table_page_id, &location, &link_page_id)) {
+      return false;
+    }
+    map_page_id = map_page_ids_[location.map_page_index_];
+  }
+
+  // A map page was appended: link it into the chain, now that latch_ is released.
+  if (link_page_id != INVALID_PAGE_ID) {
+    auto link_page = static_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(link_page_id));
+    BUSTUB_ASSERT(link_page != nullptr, "Couldn't fetch a page of the free space map.");
+    link_page->WLatch();
+    link_page->SetNextPageId(map_page_id);
+    link_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(link_page_id, true);
+  }
+
+  auto page = static_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(map_page_id));
+  if (page == nullptr) {
+    return false;
+  }
+  page->WLatch();
+  bool is_dirty =
+      page->GetTablePageId(location.slot_) != table_page_id || page->GetCategory(location.slot_) != category;
+  if (is_dirty) {
+    page->SetEntry(location.slot_, table_page_id, category);
+    page->SetEntryCount(std::max(page->GetEntryCount(), location.slot_ + 1));
+    std::scoped_lock lock(latch_);
+    max_categories_[location.map_page_index_] = std::max(max_categories_[location.map_page_index_], category);
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(map_page_id, is_dirty);
+  return true;
+}
+
+void FreeSpaceMap::Remove(page_id_t table_page_id) {
+  Location location{};
+  page_id_t map_page_id;
+  {
+    std::scoped_lock lock(latch_);
+    auto it = locations_.find(table_page_id);
+    if (it == locations_.end()) {
+      return;
+    }
+    location = it->second;
+    locations_.erase(it);
+    map_page_id = map_page_ids_[location.map_page_index_];
+  }
+
+  auto page = static_cast<FreeSpaceMapPage *>(buffer_pool_manager_->FetchPage(map_page_id));
+  BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the free space map.");
+  page->WLatch();
+  page->SetEntry(location.slot_, INVALID_PAGE_ID, 0);
+  {
+    // Hand out the entry again only once it is cleared, so that the clearing cannot overwrite its next table page.
+    std::scoped_lock lock(latch_);
+    free_locations_.push_back(location);
+  }
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(map_page_id, true);
+}
+
+auto FreeSpaceMap::Reserve(page_id_t table_page_id, Location *location, page_id_t *link_page_id) -> bool {
+  if (!free_locations_.empty()) {
+    *location = free_locations_.back();
+    free_locations_.pop_back();
+    locations_[table_page_id] = *location;
+    return true;
+  }
+  if (last_page_entries_ == FreeSpaceMapPage::FSM_PAGE_CAPACITY) {
+    page_id_t map_page_id;
+    auto page = static_cast<FreeSpaceMapPage *>(buffer_pool_manager_->NewPage(&map_page_id));
+    if (page == nullptr) {
+      return false;
+    }
+    page->Init();
+    buffer_pool_manager_->UnpinPage(map_page_id, true);
+    *link_page_id = map_page_ids_.back();
+    map_page_ids_.push_back(map_page_id);
+    max_categories_.push_back(0);
+    last_page_entries_ = 0;
+  }
+  *location = {map_page_ids_.size() - 1, last_page_entries_++};
+  locations_[table_page_id] = *location;
+  return true;
+}
+
+}  // namespace bustub
@@ -10,84 +10,278 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <functional>
+#include <thread>  // NOLINT
 
 #include "common/logger.h"
 #include "fmt/format.h"
+#include "storage/page/overflow_page.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     page_id_t first_page_id)
+                     page_id_t first_page_id, page_id_t free_space_map_page_id, const Schema *schema)
     : buffer_pool_manager_(buffer_pool_manager),
       lock_manager_(lock_manager),
       log_manager_(log_manager),
-      first_page_id_(first_page_id) {}
+      schema_(schema == nullptr ? nullptr : std::make_unique<Schema>(*schema)),
+      first_page_id_(first_page_id) {
+  for (auto &hint : insert_hints_) {
+    hint = INVALID_PAGE_ID;
+  }
+  bool rebuild_free_space_map = free_space_map_page_id == INVALID_PAGE_ID;
+  if (rebuild_free_space_map) {
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_);
+  } else {
+    free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_, free_space_map_page_id);
+  }
+
+  // Count the pages of the existing table. Use a ring, so that opening a large table does not flush the buffer pool.
+  BufferAccessStrategy strategy(SEQ_SCAN_RING_SIZE);
+  auto page_id = first_page_id_;
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, &strategy));
+    BUSTUB_ASSERT(page != nullptr, "Couldn't fetch a page of the table heap.");
+    page->RLatch();
+    auto next_page_id = page->GetNextPageId();
+    auto free_space = page->GetFreeSpaceRemaining();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (rebuild_free_space_map) {
+      free_space_map_->Update(page_id, free_space);
+    }
+    last_page_id_ = page_id;
+    page_id = next_page_id;
+    ++num_pages_;
+  }
+}
 
 TableHeap::TableHeap(BufferPoolManager *buffer_pool_manager, LockManager *lock_manager, LogManager *log_manager,
-                     Transaction *txn)
-    : buffer_pool_manager_(buffer_pool_manager), lock_manager_(lock_manager), log_manager_(log_manager) {
+                     Transaction *txn, const Schema *schema)
+    : buffer_pool_manager_(buffer_pool_manager),
+      lock_manager_(lock_manager),
+      log_manager_(log_manager),
+      schema_(schema == nullptr ? nullptr : std::make_unique<Schema>(*schema)) {
+  for (auto &hint : insert_hints_) {
+    hint = INVALID_PAGE_ID;
+  }
   // Initialize the first table page.
   auto first_page = reinterpret_cast<TablePage *>(buffer_pool_manager_->NewPage(&first_page_id_));
   BUSTUB_ASSERT(first_page != nullptr,
                 "Couldn't create a page for the table heap. Have you completed the buffer pool manager project?");
-  first_page->Init(first_page_id_, BUSTUB_PAGE_SIZE, INVALID_LSN, log_manager_, txn);
+  first_page->Init(first_page_id_, BUSTUB_PAGE_DATA_SIZE, INVALID_LSN, log_manager_, txn);
+  auto free_space = first_page->GetFreeSpaceRemaining();
   buffer_pool_manager_->UnpinPage(first_page_id_, true);
+  num_pages_ = 1;
+  last_page_id_ = first_page_id_;
+  free_space_map_ = std::make_unique<FreeSpaceMap>(buffer_pool_manager_);
+  free_space_map_->Update(first_page_id_, free_space);
 }
 
 auto TableHeap::InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn) -> bool {
-  if (tuple.size_ + 32 > BUSTUB_PAGE_SIZE) {  // larger than one page size
+  Tuple stored_tuple;
+  if (!MoveValuesOutOfLine(tuple, &stored_tuple)) {
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  const auto &row = stored_tuple.data_ == nullptr ? tuple : stored_tuple;
+  if (row.size_ + 32 > BUSTUB_PAGE_DATA_SIZE) {  // larger than one page size
+    DeleteOutOfLineValues(stored_tuple);
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
 
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_));
-  if (cur_page == nullptr) {
+  // Try the page this thread inserted into last, then the pages the free space map knows to have room. Every failed
+  // attempt corrects the map, so the loop ends.
+  vacuum_latch_.RLock();
+  auto &hint = insert_hints_[std::hash<std::thread::id>{}(std::this_thread::get_id()) % INSERT_HINTS];
+  auto page_id = hint.load();
+  auto size = row.size_ + TablePage::SIZE_TUPLE;
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = free_space_map_->FindPage(size);
+  }
+  while (page_id != INVALID_PAGE_ID && !InsertIntoPage(page_id, row, rid, txn)) {
+    page_id = free_space_map_->FindPage(size, page_id);
+  }
+  // No page has room: append a new one.
+  if (page_id == INVALID_PAGE_ID) {
+    page_id = InsertIntoNewPage(row, rid, txn);
+    if (page_id == INVALID_PAGE_ID) {
+      vacuum_latch_.RUnlock();
+      DeleteOutOfLineValues(stored_tuple);
+      txn->SetState(TransactionState::ABORTED);
+      return false;
+    }
+  }
+  hint = page_id;
+  vacuum_latch_.RUnlock();
+  // Update the transaction's write set.
+  txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+  return true;
+}
+
+auto TableHeap::InsertIntoPage(page_id_t page_id, const Tuple &tuple, RID *rid, Transaction *txn) -> bool {
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    return false;
+  }
+  page->WLatch();
+  bool is_inserted = page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+  auto free_space = page->GetFreeSpaceRemaining();
+  page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(page_id, is_inserted);
+  free_space_map_->Update(page_id, free_space);
+  return is_inserted;
+}
+
+auto TableHeap::InsertIntoNewPage(const Tuple &tuple, RID *rid, Transaction *txn) -> page_id_t {
+  page_id_t new_page_id;
+  auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&new_page_id));
+  if (new_page == nullptr) {
+    return INVALID_PAGE_ID;
+  }
+  new_page->WLatch();
+
+  auto last_page = LatchLastPage();
+  if (last_page == nullptr) {
+    new_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(new_page_id, false);
+    buffer_pool_manager_->DeletePage(new_page_id);
+    return INVALID_PAGE_ID;
+  }
+  auto last_page_id = last_page->GetTablePageId();
+
+  // Link the new page. It stays latched until it holds the tuple, so a scan that follows the link waits for it.
+  last_page->SetNextPageId(new_page_id);
+  new_page->Init(new_page_id, BUSTUB_PAGE_DATA_SIZE, last_page_id, log_manager_, txn);
+  last_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(last_page_id, true);
+  last_page_id_ = new_page_id;
+  ++num_pages_;
+
+  bool is_inserted = new_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_);
+  BUSTUB_ASSERT(is_inserted, "A tuple that fits in a page must fit in an empty one.");
+  auto free_space = new_page->GetFreeSpaceRemaining();
+  new_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(new_page_id, true);
+  free_space_map_->Update(new_page_id, free_space);
+  return new_page_id;
+}
+
+auto TableHeap::LatchLastPage() -> TablePage * {
+  auto last_page_id = last_page_id_.load();
+  auto last_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(last_page_id));
+  if (last_page == nullptr) {
+    return nullptr;
+  }
+  last_page->WLatch();
+  while (last_page->GetNextPageId() != INVALID_PAGE_ID) {
+    auto next_page_id = last_page->GetNextPageId();
+    auto next_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+    BUSTUB_ASSERT(next_page != nullptr, "Couldn't fetch a page of the table heap.");
+    next_page->WLatch();
+    last_page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(last_page_id, false);
+    last_page = next_page;
+    last_page_id = next_page_id;
+  }
+  return last_page;
+}
+
+auto TableHeap::BulkInsertTuples(const std::vector<Tuple> &tuples, std::vector<RID> *rids, Transaction *txn) -> bool {
+  std::vector<Tuple> stored_tuples(tuples.size());
+  auto abort = [&]() {
+    for (const auto &stored_tuple : stored_tuples) {
+      DeleteOutOfLineValues(stored_tuple);
+    }
     txn->SetState(TransactionState::ABORTED);
     return false;
+  };
+  for (size_t i = 0; i < tuples.size(); ++i) {
+    if (!MoveValuesOutOfLine(tuples[i], &stored_tuples[i])) {
+      return abort();
+    }
+    const auto &row = stored_tuples[i].data_ == nullptr ? tuples[i] : stored_tuples[i];
+    if (row.size_ + 32 > BUSTUB_PAGE_DATA_SIZE) {  // larger than one page size
+      return abort();
+    }
+  }
+  if (tuples.empty()) {
+    return true;
   }
 
-  cur_page->WLatch();
-
-  // Insert into the first page with enough space. If no such page exists, create a new page and insert into that.
-  // INVARIANT: cur_page is WLatched if you leave the loop normally.
-  while (!cur_page->InsertTuple(tuple, rid, txn, lock_manager_, log_manager_)) {
-    auto next_page_id = cur_page->GetNextPageId();
-    // If the next page is a valid page,
-    if (next_page_id != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
-      next_page->WLatch();
-      // Unlatch and unpin the current page.
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-    } else {
-      // Otherwise we have run out of valid pages. We need to create a new page.
-      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&next_page_id));
-      // If we could not create a new page,
+  // Pack the tuples into a chain of fresh pages. Nothing else can reach these pages yet, so they need no latches.
+  std::vector<std::pair<page_id_t, uint32_t>> new_pages;  // page id and free space left
+  auto num_rids = rids->size();
+  TablePage *page = nullptr;
+  for (size_t i = 0; i < tuples.size(); ++i) {
+    const auto &tuple = stored_tuples[i].data_ == nullptr ? tuples[i] : stored_tuples[i];
+    RID rid;
+    if (page == nullptr || !page->InsertTuple(tuple, &rid, txn, lock_manager_, log_manager_)) {
+      auto prev_page_id = page == nullptr ? INVALID_PAGE_ID : page->GetTablePageId();
+      page_id_t new_page_id;
+      auto new_page = static_cast<TablePage *>(buffer_pool_manager_->NewPage(&new_page_id));
+      if (page != nullptr) {
+        page->SetNextPageId(new_page == nullptr ? INVALID_PAGE_ID : new_page_id);
+        new_pages.back().second = page->GetFreeSpaceRemaining();
+        buffer_pool_manager_->UnpinPage(prev_page_id, true);
+      }
       if (new_page == nullptr) {
-        // Then life sucks and we abort the transaction.
-        cur_page->WUnlatch();
-        buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), false);
-        txn->SetState(TransactionState::ABORTED);
-        return false;
+        for (const auto &[page_id, free_space] : new_pages) {
+          buffer_pool_manager_->DeletePage(page_id);
+        }
+        rids->resize(num_rids);
+        return abort();
       }
-      // Otherwise we were able to create a new page. We initialize it now.
-      new_page->WLatch();
-      cur_page->SetNextPageId(next_page_id);
-      new_page->Init(next_page_id, BUSTUB_PAGE_SIZE, cur_page->GetTablePageId(), log_manager_, txn);
-      cur_page->WUnlatch();
-      buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
-      cur_page = new_page;
-    }
-  }
-  // This line has caused most of us to double-take and "whoa double unlatch".
-  // We are not, in fact, double unlatching. See the invariant above.
-  cur_page->WUnlatch();
-  buffer_pool_manager_->UnpinPage(cur_page->GetTablePageId(), true);
+      new_page->Init(new_page_id, BUSTUB_PAGE_DATA_SIZE, prev_page_id, log_manager_, txn);
+      new_pages.emplace_back(new_page_id, 0);
+      page = new_page;
+      bool is_inserted = page->InsertTuple(tuple, &rid, txn, lock_manager_, log_manager_);
+      BUSTUB_ASSERT(is_inserted, "A tuple that fits in a page must fit in an empty one.");
+    }
+    rids->push_back(rid);
+  }
+  new_pages.back().second = page->GetFreeSpaceRemaining();
+  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+
+  // Attach the chain to the end of the page list.
+  vacuum_latch_.RLock();
+  auto last_page = LatchLastPage();
+  auto first_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(new_pages.front().first));
+  if (last_page == nullptr || first_page == nullptr) {
+    if (last_page != nullptr) {
+      last_page->WUnlatch();
+      buffer_pool_manager_->UnpinPage(last_page->GetTablePageId(), false);
+    }
+    if (first_page != nullptr) {
+      buffer_pool_manager_->UnpinPage(first_page->GetTablePageId(), false);
+    }
+    vacuum_latch_.RUnlock();
+    for (const auto &[page_id, free_space] : new_pages) {
+      buffer_pool_manager_->DeletePage(page_id);
+    }
+    rids->resize(num_rids);
+    return abort();
+  }
+  first_page->SetPrevPageId(last_page->GetTablePageId());
+  buffer_pool_manager_->UnpinPage(first_page->GetTablePageId(), true);
+  last_page->SetNextPageId(new_pages.front().first);
+  last_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(last_page->GetTablePageId(), true);
+  last_page_id_ = new_pages.back().first;
+  num_pages_ += new_pages.size();
+
+  for (const auto &[page_id, free_space] : new_pages) {
+    free_space_map_->Update(page_id, free_space);
+  }
+  vacuum_latch_.RUnlock();
   // Update the transaction's write set.
-  txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+  for (auto rid = rids->begin() + num_rids; rid != rids->end(); ++rid) {
+    txn->GetWriteSet()->emplace_back(*rid, WType::INSERT, Tuple{}, this);
+  }
   return true;
 }
 
@@ -118,12 +312,33 @@ auto TableHeap::UpdateTuple(const Tuple &tuple, const RID &rid, Transaction *txn
     txn->SetState(TransactionState::ABORTED);
     return false;
   }
+  // A rollback puts back the old version as it was, values out of line included.
+  bool is_rollback = txn->GetState() == TransactionState::ABORTED;
+  Tuple stored_tuple;
+  if (!is_rollback && !MoveValuesOutOfLine(tuple, &stored_tuple)) {
+    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+    txn->SetState(TransactionState::ABORTED);
+    return false;
+  }
+  const auto &row = stored_tuple.data_ == nullptr ? tuple : stored_tuple;
   // Update the tuple; but first save the old value for rollbacks.
   Tuple old_tuple;
+  vacuum_latch_.RLock();
   page->WLatch();
-  bool is_updated = page->UpdateTuple(tuple, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  bool is_updated = page->UpdateTuple(row, &old_tuple, rid, txn, lock_manager_, log_manager_);
+  auto free_space = page->GetFreeSpaceRemaining();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), is_updated);
+  if (is_updated) {
+    free_space_map_->Update(rid.GetPageId(), free_space);
+  }
+  vacuum_latch_.RUnlock();
+  if (!is_updated) {
+    DeleteOutOfLineValues(stored_tuple);
+  } else if (is_rollback) {
+    // The version rolled back is gone for good.
+    DeleteOutOfLineValues(old_tuple);
+  }
   // Update the transaction's write set.
   if (is_updated && txn->GetState() != TransactionState::ABORTED) {
     txn->GetWriteSet()->emplace_back(rid, WType::UPDATE, old_tuple, this);
@@ -136,15 +351,24 @@ void TableHeap::ApplyDelete(const RID &rid, Transaction *txn) {
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
   BUSTUB_ASSERT(page != nullptr, "Couldn't find a page containing that RID.");
   // Delete the tuple from the page.
+  vacuum_latch_.RLock();
   page->WLatch();
-  page->ApplyDelete(rid, txn, log_manager_);
+  Tuple deleted_tuple;
+  page->ApplyDelete(rid, txn, log_manager_, &deleted_tuple);
   /** Commented out to make compatible with p4; This is called only on commit or delete, which consequently unlocks the
    * tuple; so should be fine */
   // lock_manager_->Unlock(txn, rid);
+  auto free_space = page->GetFreeSpaceRemaining();
   page->WUnlatch();
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
+  // The tuple's space is free again, and so are the pages of its values.
+  free_space_map_->Update(rid.GetPageId(), free_space);
+  vacuum_latch_.RUnlock();
+  DeleteOutOfLineValues(deleted_tuple);
 }
 
+void TableHeap::ApplyUpdate(const Tuple &old_tuple) { DeleteOutOfLineValues(old_tuple); }
+
 void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   // Find the page which contains the tuple.
   auto page = reinterpret_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
@@ -156,9 +380,10 @@ void TableHeap::RollbackDelete(const RID &rid, Transaction *txn) {
   buffer_pool_manager_->UnpinPage(page->GetTablePageId(), true);
 }
 
-auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock) -> bool {
+auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock,
+                         BufferAccessStrategy *strategy) -> bool {
   // Find the page which contains the tuple.
-  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId()));
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(rid.GetPageId(), strategy));
   // If the page could not be found, then abort the transaction.
   if (page == nullptr) {
     txn->SetState(TransactionState::ABORTED);
@@ -169,6 +394,14 @@ auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool ac
     page->RLatch();
   }
   bool res = page->GetTuple(rid, tuple, txn, lock_manager_);
+  tuple->buffer_pool_manager_ = buffer_pool_manager_;
+  if (res && HasOutOfLineValues(*tuple)) {
+    // Join the epoch while the row is latched: a delete that retires the chains after this sees the epoch taken.
+    std::scoped_lock lock(read_epoch_mutex_);
+    tuple->overflow_guard_ = read_epoch_;
+  } else {
+    tuple->overflow_guard_.reset();
+  }
   if (acquire_read_lock) {
     page->RUnlatch();
   }
@@ -176,24 +409,334 @@ auto TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool ac
   return res;
 }
 
-auto TableHeap::Begin(Transaction *txn) -> TableIterator {
+auto TableHeap::Begin(Transaction *txn, BufferAccessStrategy *strategy) -> TableIterator {
   // Start an iterator from the first page.
   // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
   RID rid;
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(first_page_id_, strategy));
+  page->RLatch();
+  // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
+  while (!page->GetFirstTupleRid(&rid) && page->GetNextPageId() != INVALID_PAGE_ID) {
+    // Pin the next page before letting go of the link to it, so that a vacuum cannot reclaim it in between.
+    auto next_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page->GetNextPageId(), strategy));
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+    page = next_page;
+    page->RLatch();
+  }
+  // The scan reaches the next page soon; start reading it now.
+  buffer_pool_manager_->PrefetchPage(page->GetNextPageId(), strategy);
+  page->RUnlatch();
+  buffer_pool_manager_->UnpinPage(page->GetTablePageId(), false);
+  return {this, rid, txn, strategy};
+}
+
+auto TableHeap::Vacuum() -> size_t {
+  std::scoped_lock vacuum_lock(vacuum_mutex_);
+  DeleteRetiredChains();
+  FreeDeferredPages();
+  // Use a ring, so that vacuuming a large table does not flush the buffer pool.
+  BufferAccessStrategy strategy(SEQ_SCAN_RING_SIZE);
+  size_t bytes_reclaimed = 0;
+  auto prev_page_id = INVALID_PAGE_ID;
   auto page_id = first_page_id_;
   while (page_id != INVALID_PAGE_ID) {
-    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
-    page->RLatch();
-    // If this fails because there is no tuple, then RID will be the default-constructed value, which means EOF.
-    auto found_tuple = page->GetFirstTupleRid(&rid);
-    page->RUnlatch();
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id, &strategy));
+    if (page == nullptr) {
+      LOG_WARN("Vacuum couldn't fetch page %d, stopping early.", page_id);
+      break;
+    }
+    page->WLatch();
+    auto compacted = page->Compact();
+    bool is_empty = page->GetSlotCount() == 0;
+    auto next_page_id = page->GetNextPageId();
+    auto free_space = page->GetFreeSpaceRemaining();
+    page->WUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, compacted > 0);
+
+    if (is_empty && prev_page_id != INVALID_PAGE_ID && next_page_id != INVALID_PAGE_ID &&
+        RemovePage(prev_page_id, page_id)) {
+      bytes_reclaimed += BUSTUB_PAGE_SIZE;
+    } else {
+      if (compacted > 0) {
+        vacuum_latch_.RLock();
+        free_space_map_->Update(page_id, free_space);
+        vacuum_latch_.RUnlock();
+      }
+      bytes_reclaimed += compacted;
+      prev_page_id = page_id;
+    }
+    page_id = next_page_id;
+  }
+  return bytes_reclaimed;
+}
+
+auto TableHeap::RemovePage(page_id_t prev_page_id, page_id_t page_id) -> bool {
+  vacuum_latch_.WLock();
+  auto prev_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(prev_page_id));
+  if (prev_page == nullptr) {
+    vacuum_latch_.WUnlock();
+    return false;
+  }
+  auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+  if (page == nullptr) {
+    buffer_pool_manager_->UnpinPage(prev_page_id, false);
+    vacuum_latch_.WUnlock();
+    return false;
+  }
+  // Latch left to right, like appenders do. No insert is in flight, so the page stays empty once checked.
+  prev_page->WLatch();
+  page->WLatch();
+  auto next_page_id = page->GetNextPageId();
+  TablePage *next_page = nullptr;
+  if (prev_page->GetNextPageId() == page_id && page->GetSlotCount() == 0 && next_page_id != INVALID_PAGE_ID) {
+    next_page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(next_page_id));
+  }
+  if (next_page == nullptr) {
+    page->WUnlatch();
+    prev_page->WUnlatch();
     buffer_pool_manager_->UnpinPage(page_id, false);
-    if (found_tuple) {
+    buffer_pool_manager_->UnpinPage(prev_page_id, false);
+    vacuum_latch_.WUnlock();
+    return false;
+  }
+  next_page->WLatch();
+  prev_page->SetNextPageId(next_page_id);
+  next_page->SetPrevPageId(prev_page_id);
+  next_page->WUnlatch();
+  page->WUnlatch();
+  prev_page->WUnlatch();
+  buffer_pool_manager_->UnpinPage(next_page_id, true);
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  buffer_pool_manager_->UnpinPage(prev_page_id, true);
+
+  // Forget every way an insert could still find the page.
+  free_space_map_->Remove(page_id);
+  for (auto &hint : insert_hints_) {
+    auto expected = page_id;
+    hint.compare_exchange_strong(expected, INVALID_PAGE_ID);
+  }
+  auto expected = page_id;
+  last_page_id_.compare_exchange_strong(expected, next_page_id);
+  --num_pages_;
+  vacuum_latch_.WUnlock();
+
+  FreePage(page_id);
+  return true;
+}
+
+auto TableHeap::MoveValuesOutOfLine(const Tuple &tuple, Tuple *stored_tuple) -> bool {
+  if (schema_ == nullptr) {
+    return true;
+  }
+  if (tuple.size_ <= OVERFLOW_TUPLE_THRESHOLD && !HasOutOfLineValues(tuple)) {
+    return true;
+  }
+  const auto &unlined_columns = schema_->GetUnlinedColumns();
+
+  // Read every value in full, so that the stored tuple shares no overflow pages with the one it was made from.
+  std::vector<Value> values;
+  values.reserve(schema_->GetColumnCount());
+  for (uint32_t i = 0; i < schema_->GetColumnCount(); ++i) {
+    values.push_back(tuple.GetValue(schema_.get(), i));
+  }
+  Tuple inline_tuple(values, schema_.get());
+
+  // Pick the largest values until the rest fits under the threshold.
+  std::vector<uint32_t> by_length(unlined_columns.begin(), unlined_columns.end());
+  auto length = [&](uint32_t col_idx) { return values[col_idx].IsNull() ? 0 : values[col_idx].GetLength(); };
+  std::sort(by_length.begin(), by_length.end(), [&](uint32_t a, uint32_t b) { return length(a) > length(b); });
+  std::vector<bool> out_of_line(schema_->GetColumnCount(), false);
+  uint32_t size = inline_tuple.size_;
+  for (auto col_idx : by_length) {
+    auto payload_size = sizeof(uint32_t) + length(col_idx);
+    if (size <= OVERFLOW_TUPLE_THRESHOLD || payload_size <= Tuple::OVERFLOW_STUB_SIZE) {
       break;
     }
-    page_id = page->GetNextPageId();
+    out_of_line[col_idx] = true;
+    size -= payload_size - Tuple::OVERFLOW_STUB_SIZE;
+  }
+
+  // Lay out the tuple again, with stubs in place of the values that go out of line.
+  std::vector<char> data(size);
+  std::vector<page_id_t> chains;
+  memcpy(data.data(), inline_tuple.data_, schema_->GetLength());
+  uint32_t offset = schema_->GetLength();
+  for (auto col_idx : unlined_columns) {
+    memcpy(data.data() + schema_->GetColumn(col_idx).GetOffset(), &offset, sizeof(uint32_t));
+    const char *payload = inline_tuple.GetDataPtr(schema_.get(), col_idx);
+    if (!out_of_line[col_idx]) {
+      auto payload_size = sizeof(uint32_t) + length(col_idx);
+      memcpy(data.data() + offset, payload, payload_size);
+      offset += payload_size;
+      continue;
+    }
+    auto len = length(col_idx);
+    auto first_page_id = WriteOverflowPages(payload + sizeof(uint32_t), len);
+    if (first_page_id == INVALID_PAGE_ID) {
+      for (auto chain : chains) {
+        DeleteOverflowPages(chain);
+      }
+      return false;
+    }
+    chains.push_back(first_page_id);
+    auto stub = len | Tuple::OVERFLOW_FLAG;
+    memcpy(data.data() + offset, &stub, sizeof(uint32_t));
+    memcpy(data.data() + offset + sizeof(uint32_t), &first_page_id, sizeof(page_id_t));
+    offset += Tuple::OVERFLOW_STUB_SIZE;
+  }
+
+  stored_tuple->size_ = size;
+  stored_tuple->data_ = new char[size];
+  memcpy(stored_tuple->data_, data.data(), size);
+  stored_tuple->allocated_ = true;
+  stored_tuple->buffer_pool_manager_ = buffer_pool_manager_;
+  return true;
+}
+
+auto TableHeap::WriteOverflowPages(const char *data, uint32_t len) -> page_id_t {
+  // Nothing else can reach the pages of a new chain, so they need no latches.
+  auto first_page_id = INVALID_PAGE_ID;
+  OverflowPage *prev_page = nullptr;
+  for (uint32_t offset = 0; offset < len; offset += OverflowPage::OVERFLOW_PAGE_CAPACITY) {
+    page_id_t page_id;
+    auto page = static_cast<OverflowPage *>(buffer_pool_manager_->NewPage(&page_id));
+    if (prev_page != nullptr) {
+      prev_page->SetNextPageId(page == nullptr ? INVALID_PAGE_ID : page_id);
+      buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), true);
+    }
+    if (page == nullptr) {
+      DeleteOverflowPages(first_page_id);
+      return INVALID_PAGE_ID;
+    }
+    page->Init();
+    auto size = std::min(OverflowPage::OVERFLOW_PAGE_CAPACITY, len - offset);
+    memcpy(page->GetPayload(), data + offset, size);
+    page->SetDataSize(size);
+    if (first_page_id == INVALID_PAGE_ID) {
+      first_page_id = page_id;
+    }
+    prev_page = page;
+  }
+  if (prev_page != nullptr) {
+    buffer_pool_manager_->UnpinPage(prev_page->GetPageId(), true);
+  }
+  return first_page_id;
+}
+
+auto TableHeap::HasOutOfLineValues(const Tuple &tuple) const -> bool {
+  if (schema_ == nullptr || tuple.data_ == nullptr) {
+    return false;
+  }
+  const auto &unlined_columns = schema_->GetUnlinedColumns();
+  return std::any_of(unlined_columns.begin(), unlined_columns.end(),
+                     [&](uint32_t col_idx) { return tuple.IsOutOfLine(schema_.get(), col_idx); });
+}
+
+void TableHeap::DeleteOutOfLineValues(const Tuple &tuple) {
+  if (schema_ == nullptr || tuple.data_ == nullptr) {
+    return;
+  }
+  for (auto col_idx : schema_->GetUnlinedColumns()) {
+    if (tuple.IsOutOfLine(schema_.get(), col_idx)) {
+      const char *stub = tuple.GetDataPtr(schema_.get(), col_idx);
+      RetireOverflowPages(*reinterpret_cast<const page_id_t *>(stub + sizeof(uint32_t)));
+    }
+  }
+}
+
+void TableHeap::RetireOverflowPages(page_id_t page_id) {
+  std::vector<page_id_t> expired;
+  {
+    std::scoped_lock lock(read_epoch_mutex_);
+    if (read_epoch_.use_count() > 1) {
+      // A tuple read before the chain was unlinked from its row may still read it; a tuple read from now on cannot.
+      auto next = std::make_shared<ReadEpoch>();
+      retired_chains_.emplace_back(read_epoch_, page_id);
+      read_epoch_->next_ = next;
+      read_epoch_ = std::move(next);
+      return;
+    }
+    // No tuple holds an epoch, so every chain retired so far is free to go as well.
+    expired = TakeExpiredChains();
+  }
+  for (auto chain : expired) {
+    DeleteOverflowPages(chain);
+  }
+  DeleteOverflowPages(page_id);
+}
+
+void TableHeap::DeleteRetiredChains() {
+  std::vector<page_id_t> expired;
+  {
+    std::scoped_lock lock(read_epoch_mutex_);
+    expired = TakeExpiredChains();
+  }
+  for (auto chain : expired) {
+    DeleteOverflowPages(chain);
+  }
+}
+
+auto TableHeap::TakeExpiredChains() -> std::vector<page_id_t> {
+  // An epoch ends only after the epochs before it, so the chains whose epoch has ended come first.
+  auto end = std::find_if(retired_chains_.begin(), retired_chains_.end(),
+                          [](const auto &retired) { return !retired.first.expired(); });
+  std::vector<page_id_t> expired;
+  expired.reserve(end - retired_chains_.begin());
+  for (auto it = retired_chains_.begin(); it != end; ++it) {
+    expired.push_back(it->second);
+  }
+  retired_chains_.erase(retired_chains_.begin(), end);
+  return expired;
+}
+
+void TableHeap::DeleteOverflowPages(page_id_t page_id) {
+  while (page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<OverflowPage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      LOG_WARN("Couldn't fetch overflow page %d, leaking the rest of its chain.", page_id);
+      return;
+    }
+    page->RLatch();
+    auto next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    FreePage(page_id);
+    page_id = next_page_id;
+  }
+}
+
+void TableHeap::FreePage(page_id_t page_id) {
+  auto result = buffer_pool_manager_->TryDeletePage(page_id);
+  if (result == BufferPoolManager::DeletePageResult::DELETED) {
+    return;
+  }
+  // Only a pinned page can be deleted later; a retry of any other would fail on every vacuum.
+  if (result == BufferPoolManager::DeletePageResult::NOT_ALLOCATED) {
+    LOG_WARN("page %d is not allocated, so it cannot be deleted", page_id);
+    return;
+  }
+  std::scoped_lock lock(deferred_pages_mutex_);
+  deferred_pages_.push_back(page_id);
+}
+
+void TableHeap::FreeDeferredPages() {
+  std::vector<page_id_t> page_ids;
+  {
+    std::scoped_lock lock(deferred_pages_mutex_);
+    page_ids.swap(deferred_pages_);
+  }
+  for (auto page_id : page_ids) {
+    FreePage(page_id);
+  }
+}
+
+TableHeap::ReadEpoch::~ReadEpoch() {
+  // Let go of a long run of epochs no tuple holds one at a time, rather than recursively.
+  auto next = std::move(next_);
+  while (next != nullptr && next.use_count() == 1) {
+    next = std::move(next->next_);
   }
-  return {this, rid, txn};
 }
 
 auto TableHeap::End() -> TableIterator { return {this, RID(INVALID_PAGE_ID, 0), nullptr}; }
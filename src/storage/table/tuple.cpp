@@ -10,12 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "buffer/buffer_pool_manager.h"
+#include "common/exception.h"
+#include "storage/page/overflow_page.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -61,7 +65,12 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
   }
 }
 
-Tuple::Tuple(const Tuple &other) : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_) {
+Tuple::Tuple(const Tuple &other)
+    : allocated_(other.allocated_),
+      rid_(other.rid_),
+      size_(other.size_),
+      buffer_pool_manager_(other.buffer_pool_manager_),
+      overflow_guard_(other.overflow_guard_) {
   if (allocated_) {
     delete[] data_;
   }
@@ -82,6 +91,8 @@ auto Tuple::operator=(const Tuple &other) -> Tuple & {
   allocated_ = other.allocated_;
   rid_ = other.rid_;
   size_ = other.size_;
+  buffer_pool_manager_ = other.buffer_pool_manager_;
+  overflow_guard_ = other.overflow_guard_;
 
   if (allocated_) {
     // Deep copy.
@@ -100,10 +111,55 @@ auto Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const -> V
   assert(data_);
   const TypeId column_type = schema->GetColumn(column_idx).GetType();
   const char *data_ptr = GetDataPtr(schema, column_idx);
+  if (IsOutOfLine(schema, column_idx)) {
+    return GetOutOfLineValue(column_type, data_ptr);
+  }
   // the third parameter "is_inlined" is unused
   return Value::DeserializeFrom(data_ptr, column_type);
 }
 
+auto Tuple::IsNull(const Schema *schema, const uint32_t column_idx) const -> bool {
+  if (IsOutOfLine(schema, column_idx)) {
+    return false;
+  }
+  Value value = GetValue(schema, column_idx);
+  return value.IsNull();
+}
+
+auto Tuple::IsOutOfLine(const Schema *schema, const uint32_t column_idx) const -> bool {
+  if (schema->GetColumn(column_idx).IsInlined()) {
+    return false;
+  }
+  uint32_t len = *reinterpret_cast<const uint32_t *>(GetDataPtr(schema, column_idx));
+  return len != BUSTUB_VALUE_NULL && (len & OVERFLOW_FLAG) != 0;
+}
+
+auto Tuple::GetOutOfLineValue(TypeId type, const char *stub) const -> Value {
+  if (buffer_pool_manager_ == nullptr) {
+    throw Exception(ExceptionType::INVALID, "tuple has a value stored out of line but was not read from a table");
+  }
+  uint32_t len = *reinterpret_cast<const uint32_t *>(stub) & ~OVERFLOW_FLAG;
+  auto page_id = *reinterpret_cast<const page_id_t *>(stub + sizeof(uint32_t));
+  std::vector<char> buffer(len);
+  uint32_t offset = 0;
+  while (offset < len && page_id != INVALID_PAGE_ID) {
+    auto page = static_cast<OverflowPage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "couldn't fetch an overflow page");
+    }
+    page->RLatch();
+    auto size = std::min(page->GetDataSize(), len - offset);
+    memcpy(buffer.data() + offset, page->GetPayload(), size);
+    auto next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    offset += size;
+    page_id = next_page_id;
+  }
+  BUSTUB_ENSURE(offset == len, "The overflow page chain of a value is shorter than the value.");
+  return {type, buffer.data(), len, true};
+}
+
 auto Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs)
     -> Tuple {
   std::vector<Value> values;
@@ -12,12 +12,18 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <fstream>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "fmt/format.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 
 namespace bustub {
 
@@ -50,7 +56,7 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
 
   // Insert terminal characters both in the middle and at end
   random_binary_data[BUSTUB_PAGE_SIZE / 2] = '\0';
-  random_binary_data[BUSTUB_PAGE_SIZE - 1] = '\0';
+  random_binary_data[BUSTUB_PAGE_DATA_SIZE - 1] = '\0';
 
   // Scenario: Once we have a page, we should be able to read and write content.
   std::memcpy(page0->GetData(), random_binary_data, BUSTUB_PAGE_SIZE);
@@ -77,7 +83,7 @@ TEST(BufferPoolManagerInstanceTest, BinaryDataTest) {
   }
   // Scenario: We should be able to fetch the data we wrote a while ago.
   page0 = bpm->FetchPage(0);
-  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, BUSTUB_PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, BUSTUB_PAGE_DATA_SIZE));
   EXPECT_EQ(true, bpm->UnpinPage(0, true));
 
   // Shutdown the disk manager and remove the temporary file we created.
@@ -237,4 +243,653 @@ TEST(BufferPoolManagerTest, SampleTest2) {
   disk_manager->ShutDown();
   delete disk_manager;
 }
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, IoOutsideLatchTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  // Create more pages than frames so that the first ones only live on disk.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+  page_id_t resident = page_ids.back();
+  page_id_t on_disk = page_ids.front();
+  disk_manager->SetLatency(500);
+
+  // Scenario: several threads miss on the same page at once. They must all end up on one frame with the right data.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 3; ++i) {
+    threads.emplace_back([&] {
+      auto *page = bpm->FetchPage(on_disk);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(on_disk).c_str()));
+      EXPECT_TRUE(bpm->UnpinPage(on_disk, false));
+    });
+  }
+
+  // Scenario: while the miss is waiting on the disk, a hit on another page does not wait for it.
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  auto start = std::chrono::steady_clock::now();
+  auto *page = bpm->FetchPage(resident);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(resident).c_str()));
+  EXPECT_TRUE(bpm->UnpinPage(resident, false));
+  EXPECT_LT(elapsed, std::chrono::milliseconds(250));
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  disk_manager->SetLatency(0);
+
+  // Scenario: evicted pages, including ones written back while the latch was released, read back intact.
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PageCleanerTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    page_ids.push_back(page_id_temp);
+  }
+  // Scenario: the cleaner leaves pinned pages alone, and only looks at the cold end of the replacer.
+  EXPECT_EQ(0, bpm->CleanColdFrames());
+  for (auto page_id : page_ids) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  auto cold_frames = static_cast<size_t>(buffer_pool_size * page_cleaner_clean_ratio);
+  ASSERT_GT(cold_frames, 0);
+  EXPECT_EQ(cold_frames, bpm->CleanColdFrames());
+  EXPECT_EQ(0, bpm->CleanColdFrames());
+  EXPECT_EQ(cold_frames, bpm->GetBackgroundWrites());
+
+  // Scenario: evictions of the cleaned frames do not write in the foreground.
+  for (size_t i = 0; i < cold_frames; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundWrites());
+
+  // Scenario: the background thread keeps cleaning while pages are churned, and nothing is lost.
+  bpm->StartPageCleaner();
+  for (int round = 0; round < 4; ++round) {
+    for (size_t i = 0; i < buffer_pool_size; ++i) {
+      page_id_t page_id_temp;
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+      page_ids.push_back(page_id_temp);
+    }
+    std::this_thread::sleep_for(page_cleaner_interval * 5);
+  }
+  bpm->StopPageCleaner();
+  EXPECT_GT(bpm->GetBackgroundWrites(), cold_frames);
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * 2; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+  // Make every frame clean; a prefetch never writes a dirty victim.
+  bpm->FlushAllPages();
+
+  // Scenario: prefetching does not wait for the disk, and a fetch right after it sees the loaded page.
+  disk_manager->SetLatency(200);
+  auto start = std::chrono::steady_clock::now();
+  bpm->PrefetchRange(page_ids[0], 2);
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(150));
+  EXPECT_EQ(2, bpm->GetPrefetchReads());
+  for (int i = 0; i < 2; ++i) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_ids[i]).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  disk_manager->SetLatency(0);
+
+  // Scenario: resident and not-yet-allocated pages are not prefetched.
+  bpm->PrefetchPage(page_ids[0]);
+  bpm->PrefetchPage(page_ids.back() + 1);
+  EXPECT_EQ(2, bpm->GetPrefetchReads());
+
+  // Scenario: with every frame pinned, a prefetch is dropped instead of failing.
+  std::vector<page_id_t> pinned;
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    pinned.push_back(page_id_temp);
+  }
+  bpm->PrefetchPage(page_ids[2]);
+  EXPECT_EQ(2, bpm->GetPrefetchReads());
+  for (auto page_id : pinned) {
+    EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BufferAccessStrategyTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t k = 2;
+  const size_t working_set = 5;
+  const size_t num_pages = 30;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+
+  // Access the working set k times, so that LRU-K considers it hot.
+  auto touch_working_set = [&] {
+    for (size_t i = 0; i < working_set; ++i) {
+      for (size_t j = 0; j < k; ++j) {
+        ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i]));
+        EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+      }
+    }
+  };
+  // Like TableIterator, fetch every page of the scan twice.
+  auto scan = [&](BufferAccessStrategy *strategy) {
+    for (size_t i = working_set; i < num_pages; ++i) {
+      for (int j = 0; j < 2; ++j) {
+        auto *page = bpm->FetchPage(page_ids[i], strategy);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_ids[i]).c_str()));
+        EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+      }
+    }
+  };
+
+  // Scenario: a plain scan over more pages than the pool pushes out the working set.
+  touch_working_set();
+  scan(nullptr);
+  auto misses = bpm->GetFetchMisses();
+  touch_working_set();
+  EXPECT_EQ(misses + working_set, bpm->GetFetchMisses());
+
+  // Scenario: a scan through a ring only reuses its own frames, and the working set stays resident.
+  BufferAccessStrategy strategy(2);
+  scan(&strategy);
+  EXPECT_EQ(2 * (num_pages - working_set), strategy.GetHits() + strategy.GetMisses());
+  EXPECT_LE(num_pages - working_set - buffer_pool_size, strategy.GetMisses());
+  misses = bpm->GetFetchMisses();
+  touch_working_set();
+  EXPECT_EQ(misses, bpm->GetFetchMisses());
+
+  // Scenario: a ring page that somebody else accessed meanwhile is not released.
+  BufferAccessStrategy small_ring(1);
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[10], &small_ring));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[10], false));
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[10]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[10], false));
+  for (size_t i = 11; i < 14; ++i) {
+    ASSERT_NE(nullptr, bpm->FetchPage(page_ids[i], &small_ring));
+    EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  misses = bpm->GetFetchMisses();
+  ASSERT_NE(nullptr, bpm->FetchPage(page_ids[10]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[10], false));
+  EXPECT_EQ(misses, bpm->GetFetchMisses());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentHitEvictTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t k = 2;
+  const int num_pages = 64;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+    EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    page_ids.push_back(page_id_temp);
+  }
+
+  // Scenario: hits, which do not take the pool latch, race with misses that evict the very frames being hit. Every
+  // fetch must see the page it asked for, and no frame may leak from the replacer.
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < 4; ++tid) {
+    threads.emplace_back([&, tid] {
+      std::mt19937 gen(tid);
+      // Half of the threads stay on a few hot pages, the others sweep over all pages.
+      std::uniform_int_distribution<int> dist(0, tid % 2 == 0 ? 3 : num_pages - 1);
+      for (int i = 0; i < 2000; ++i) {
+        page_id_t page_id = page_ids[dist(gen)];
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        ASSERT_EQ(page_id, page->GetPageId());
+        ASSERT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+        ASSERT_TRUE(bpm->UnpinPage(page_id, i % 3 == 0));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // All frames are unpinned again, so the whole pool can be filled with new pages.
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    page_id_t page_id_temp;
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DeletePageReuseTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t k = 2;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, k);
+
+  // Scenario: pages are created, written back and deleted over and over. Deleted pages are reused, resident or not,
+  // so the page ids and the file stay within the largest number of pages alive at once.
+  const size_t live_pages = 32;
+  std::vector<page_id_t> page_ids;
+  for (int round = 0; round < 20; ++round) {
+    while (page_ids.size() < live_pages) {
+      page_id_t page_id_temp;
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      ASSERT_LT(page_id_temp, static_cast<page_id_t>(live_pages));
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d.%d", round, page_id_temp);
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+      page_ids.push_back(page_id_temp);
+    }
+    for (size_t i = 0; i < page_ids.size(); ++i) {
+      auto *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("{}.{}", round, page_ids[i]).c_str()));
+      EXPECT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+    // Delete every other page; every other round, the other half.
+    std::vector<page_id_t> kept;
+    for (size_t i = 0; i < page_ids.size(); ++i) {
+      if (i % 2 == static_cast<size_t>(round % 2)) {
+        EXPECT_TRUE(bpm->DeletePage(page_ids[i]));
+      } else {
+        kept.push_back(page_ids[i]);
+      }
+    }
+    page_ids = kept;
+    for (auto page_id : page_ids) {
+      auto *page = bpm->FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d.%d", round + 1, page_id);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+  }
+  EXPECT_LE(disk_manager->GetDbFileSize(), live_pages * BUSTUB_PAGE_SIZE);
+  EXPECT_GT(disk_manager->GetNumReusedPages(), 0);
+
+  // Scenario: a pinned page cannot be deleted. A page is deallocated only once: deleting it again fails.
+  page_id_t page_id_temp;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_FALSE(bpm->DeletePage(page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  auto num_free_pages = disk_manager->GetNumFreePages();
+  EXPECT_TRUE(bpm->DeletePage(page_id_temp));
+  EXPECT_FALSE(bpm->DeletePage(page_id_temp));
+  EXPECT_EQ(num_free_pages + 1, disk_manager->GetNumFreePages());
+
+  // Scenario: a page that was never allocated cannot be deleted, so it is never handed out by a later NewPage.
+  page_id_t unallocated_page_id = 1000;
+  EXPECT_FALSE(bpm->DeletePage(unallocated_page_id));
+  EXPECT_FALSE(bpm->DeletePage(-5));
+  EXPECT_EQ(num_free_pages + 1, disk_manager->GetNumFreePages());
+  EXPECT_FALSE(disk_manager->IsPageFree(unallocated_page_id));
+
+  // Scenario: a stale reader fetches a deleted page. Its copy must not shadow the page once reused.
+  ASSERT_NE(nullptr, bpm->FetchPage(page_id_temp));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  page_id_t reused_page_id = INVALID_PAGE_ID;
+  while (reused_page_id != page_id_temp) {
+    auto *page = bpm->NewPage(&reused_page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "new");
+    EXPECT_TRUE(bpm->UnpinPage(reused_page_id, true));
+  }
+  auto *page = bpm->FetchPage(page_id_temp);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), "new"));
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+
+  // Scenario: an instance of a parallel buffer pool only deletes its own pages.
+  auto *shared_disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm0 = new BufferPoolManagerInstance(buffer_pool_size, 2, 0, shared_disk_manager, k);
+  auto *bpm1 = new BufferPoolManagerInstance(buffer_pool_size, 2, 1, shared_disk_manager, k);
+  page_id_t page_id0;
+  page_id_t page_id1;
+  ASSERT_NE(nullptr, bpm0->NewPage(&page_id0));
+  ASSERT_NE(nullptr, bpm1->NewPage(&page_id1));
+  EXPECT_TRUE(bpm0->UnpinPage(page_id0, false));
+  EXPECT_TRUE(bpm1->UnpinPage(page_id1, false));
+  EXPECT_FALSE(bpm0->DeletePage(page_id1));
+  EXPECT_FALSE(bpm1->DeletePage(page_id0));
+  EXPECT_EQ(0, shared_disk_manager->GetNumFreePages());
+  EXPECT_TRUE(bpm1->DeletePage(page_id1));
+  EXPECT_TRUE(shared_disk_manager->IsPageFree(page_id1));
+
+  delete bpm0;
+  delete bpm1;
+  delete shared_disk_manager;
+  delete bpm;
+  delete disk_manager;
+
+  // Scenario: a reopened db file hands out its free pages once, and new pages after all the pages of the earlier run,
+  // which can still be deleted.
+  const std::string db_name = "test_reuse.db";
+  remove(db_name.c_str());
+  remove("test_reuse.free");
+  auto *file_disk_manager = new DiskManager(db_name);
+  auto *file_bpm = new BufferPoolManagerInstance(buffer_pool_size, file_disk_manager, k);
+  for (page_id_t i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, file_bpm->NewPage(&page_id_temp));
+    ASSERT_EQ(i, page_id_temp);
+    EXPECT_TRUE(file_bpm->UnpinPage(page_id_temp, true));
+  }
+  file_bpm->FlushAllPages();
+  EXPECT_TRUE(file_bpm->DeletePage(2));
+  delete file_bpm;
+  file_disk_manager->ShutDown();
+  delete file_disk_manager;
+
+  file_disk_manager = new DiskManager(db_name);
+  file_bpm = new BufferPoolManagerInstance(buffer_pool_size, file_disk_manager, k);
+  std::vector<page_id_t> new_page_ids;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_NE(nullptr, file_bpm->NewPage(&page_id_temp));
+    EXPECT_TRUE(file_bpm->UnpinPage(page_id_temp, false));
+    new_page_ids.push_back(page_id_temp);
+  }
+  EXPECT_EQ((std::vector<page_id_t>{2, 4, 5, 6}), new_page_ids);
+  EXPECT_TRUE(file_bpm->DeletePage(3));
+  EXPECT_TRUE(file_disk_manager->IsPageFree(3));
+  delete file_bpm;
+  file_disk_manager->ShutDown();
+  delete file_disk_manager;
+  remove(db_name.c_str());
+  remove("test_reuse.log");
+  remove("test_reuse.free");
+}
+
+TEST(BufferPoolManagerInstanceTest, ZeroCopyMmapTest) {
+  const std::string db_name = "test_mmap.db";
+  const size_t buffer_pool_size = 4;
+  const int num_pages = 10;
+
+  // Write a db file the usual way, then map it read-only.
+  auto *writer = new DiskManager(db_name);
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  for (int i = 0; i < num_pages; ++i) {
+    snprintf(data, BUSTUB_PAGE_SIZE, "page %d", i);
+    writer->WritePage(i, data);
+  }
+  writer->ShutDown();
+  delete writer;
+  auto *disk_manager = new DiskManagerMmap(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  EXPECT_TRUE(bpm->IsReadOnly());
+  EXPECT_EQ(num_pages * BUSTUB_PAGE_SIZE, disk_manager->GetDbFileSize());
+  EXPECT_THROW(disk_manager->WritePage(0, data), Exception);
+
+  // Scenario: fetches are served as views of the mapping, also after their frame was evicted and reused.
+  for (int round = 0; round < 2; ++round) {
+    for (int i = 0; i < num_pages; ++i) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(disk_manager->GetPageView(i), page->GetData());
+      EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", i).c_str()));
+      // Nothing is written back for a view, even if the caller claims to have modified it.
+      EXPECT_TRUE(bpm->UnpinPage(i, true));
+      EXPECT_FALSE(page->IsDirty());
+      EXPECT_TRUE(bpm->FlushPage(i));
+    }
+  }
+  EXPECT_EQ(2 * num_pages, bpm->GetViewFetches());
+
+  // Scenario: a page beyond the end of the file has no view; it is read into a frame that served views before.
+  auto *page = bpm->FetchPage(num_pages);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(nullptr, disk_manager->GetPageView(num_pages));
+  EXPECT_EQ(0, page->GetData()[0]);
+  EXPECT_TRUE(bpm->UnpinPage(num_pages, false));
+
+  // Scenario: the pool is read-only.
+  page_id_t page_id_temp;
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_FALSE(bpm->DeletePage(0));
+
+  delete bpm;
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove("test_mmap.log");
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ChecksumFailureTest) {
+  const std::string db_name = "test_crc.db";
+  const size_t buffer_pool_size = 2;
+  const int num_pages = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Page 1 has been evicted. Damage it behind the disk manager's back, like a torn write or a bad sector would.
+  bpm->FlushAllPages();
+  {
+    std::fstream file(db_name, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(BUSTUB_PAGE_SIZE + 100);
+    file.put('x');
+  }
+
+  // Scenario: the fetch reports the damage, and the page does not stay in the pool, so every fetch does.
+  EXPECT_THROW(bpm->FetchPage(1), Exception);
+  EXPECT_THROW(bpm->FetchPage(1), Exception);
+  EXPECT_EQ(2, disk_manager->GetNumChecksumFailures());
+
+  // Scenario: a prefetch of the page fails quietly, and the fetch that waited for it reads the page again.
+  bpm->PrefetchPage(1);
+  EXPECT_THROW(bpm->FetchPage(1), Exception);
+  EXPECT_EQ(4, disk_manager->GetNumChecksumFailures());
+
+  // Scenario: the failed reads gave their frames back, so the whole pool can be pinned.
+  for (int i : {0, 2}) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", i).c_str()));
+  }
+  EXPECT_TRUE(bpm->UnpinPage(0, false));
+  EXPECT_TRUE(bpm->UnpinPage(2, false));
+
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  remove(db_name.c_str());
+  remove("test_crc.log");
+}
+
+/** A disk manager whose writes fail while fail_writes_ is set, like a full or failing disk. */
+class FailingWriteDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  void WritePage(page_id_t page_id, const char *page_data) override {
+    if (fail_writes_) {
+      throw Exception(ExceptionType::IO, fmt::format("I/O error while writing page {}", page_id));
+    }
+    DiskManagerUnlimitedMemory::WritePage(page_id, page_data);
+  }
+
+  std::atomic<bool> fail_writes_{false};
+};
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WriteBackFailureTest) {
+  const size_t buffer_pool_size = 2;
+  const int num_pages = 3;
+
+  auto *disk_manager = new FailingWriteDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  for (int i = 0; i < num_pages; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Page 0 is on disk only; pages 1 and 2 are resident and dirty.
+  disk_manager->fail_writes_ = true;
+
+  // Scenario: a victim that cannot be written back is kept, dirty, and the operation that needed its frame fails.
+  page_id_t new_page_id;
+  EXPECT_THROW(bpm->NewPage(&new_page_id), Exception);
+  EXPECT_THROW(bpm->FetchPage(0), Exception);
+  EXPECT_THROW(bpm->FetchPage(0), Exception);
+  EXPECT_THROW(bpm->FlushPage(1), Exception);
+
+  // Scenario: once the disk recovers, nothing was lost, and the pages are written back after all.
+  disk_manager->fail_writes_ = false;
+  for (int i = 0; i < num_pages; ++i) {
+    auto *page = bpm->FetchPage(i);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", i).c_str()));
+    EXPECT_TRUE(bpm->UnpinPage(i, false));
+  }
+  bpm->FlushAllPages();
+  for (int i = 0; i < num_pages; ++i) {
+    char data[BUSTUB_PAGE_SIZE];
+    disk_manager->ReadPage(i, data);
+    EXPECT_EQ(0, strcmp(data, fmt::format("page {}", i).c_str()));
+  }
+  ASSERT_NE(nullptr, bpm->NewPage(&new_page_id));
+  EXPECT_TRUE(bpm->UnpinPage(new_page_id, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, DirectIoTest) {
+  const std::string db_name = "test_direct.db";
+  const size_t buffer_pool_size = 4;
+  const int num_pages = 16;
+
+  for (auto memory : {FrameMemory::HEAP, FrameMemory::MMAP}) {
+    auto saved_frame_memory = frame_memory;
+    frame_memory = memory;
+    auto *disk_manager = new DiskManager(db_name);
+    ASSERT_TRUE(disk_manager->SetDirectIo(true));
+    disk_manager->SetSyncPolicy(SyncPolicy::BATCH, 4);
+    auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+    frame_memory = saved_frame_memory;
+
+    // Scenario: the frames are aligned for direct I/O, so pages go between them and the disk without a bounce.
+    for (int i = 0; i < num_pages; ++i) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(page->GetData()) % DIRECT_IO_ALIGNMENT);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+      EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+    for (int i = 0; i < num_pages; ++i) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), fmt::format("page {}", i).c_str()));
+      EXPECT_TRUE(bpm->UnpinPage(i, false));
+    }
+
+    // Scenario: the evictions synced in batches of 4 writes, and flushing the pool syncs the incomplete batch.
+    auto num_writes = static_cast<size_t>(disk_manager->GetNumWrites());
+    EXPECT_EQ(num_writes / 4, disk_manager->GetNumSyncs());
+    bpm->FlushAllPages();
+    EXPECT_EQ((disk_manager->GetNumWrites() + 3) / 4, disk_manager->GetNumSyncs());
+
+    delete bpm;
+    disk_manager->ShutDown();
+    delete disk_manager;
+    remove(db_name.c_str());
+    remove("test_direct.log");
+  }
+}
+
 }  // namespace bustub
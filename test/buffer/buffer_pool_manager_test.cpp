@@ -49,7 +49,7 @@ TEST(BufferPoolManagerTest, DISABLED_BinaryDataTest) {
 
   // Insert terminal characters both in the middle and at end
   random_binary_data[BUSTUB_PAGE_SIZE / 2] = '\0';
-  random_binary_data[BUSTUB_PAGE_SIZE - 1] = '\0';
+  random_binary_data[BUSTUB_PAGE_DATA_SIZE - 1] = '\0';
 
   // Scenario: Once we have a page, we should be able to read and write content.
   std::memcpy(page0->GetData(), random_binary_data, BUSTUB_PAGE_SIZE);
@@ -76,7 +76,7 @@ TEST(BufferPoolManagerTest, DISABLED_BinaryDataTest) {
   }
   // Scenario: We should be able to fetch the data we wrote a while ago.
   page0 = bpm->FetchPage(0);
-  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, BUSTUB_PAGE_SIZE));
+  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, BUSTUB_PAGE_DATA_SIZE));
   EXPECT_EQ(true, bpm->UnpinPage(0, true));
 
   // Shutdown the disk manager and remove the temporary file we created.
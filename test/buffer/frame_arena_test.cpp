@@ -0,0 +1,69 @@
+/**
+ * frame_arena_test.cpp
+ */
+
+#include "buffer/frame_arena.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+TEST(FrameArenaTest, AllocationTest) {
+  const size_t num_frames = 1000;
+  for (auto memory : {FrameMemory::HEAP, FrameMemory::MMAP, FrameMemory::TRANSPARENT_HUGE_PAGES,
+                      FrameMemory::EXPLICIT_HUGE_PAGES}) {
+    FrameArena arena(num_frames, memory, FrameNumaPolicy::INTERLEAVE);
+    if (memory == FrameMemory::TRANSPARENT_HUGE_PAGES && arena.GetMemory() == memory) {
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(arena.GetFrame(0)) % HUGE_PAGE_SIZE);
+    }
+    // Frames are zeroed, contiguous and do not overlap.
+    for (size_t i = 0; i < num_frames; ++i) {
+      char *frame = arena.GetFrame(static_cast<frame_id_t>(i));
+      ASSERT_EQ(arena.GetFrame(0) + i * BUSTUB_PAGE_SIZE, frame);
+      ASSERT_EQ(0, frame[0]);
+      ASSERT_EQ(0, frame[BUSTUB_PAGE_SIZE - 1]);
+      memset(frame, static_cast<int>(i % 128), BUSTUB_PAGE_SIZE);
+    }
+    for (size_t i = 0; i < num_frames; ++i) {
+      char *frame = arena.GetFrame(static_cast<frame_id_t>(i));
+      ASSERT_EQ(static_cast<char>(i % 128), frame[0]);
+      ASSERT_EQ(static_cast<char>(i % 128), frame[BUSTUB_PAGE_SIZE - 1]);
+    }
+  }
+}
+
+TEST(FrameArenaTest, BufferPoolTest) {
+  const size_t buffer_pool_size = 8;
+  frame_memory = FrameMemory::TRANSPARENT_HUGE_PAGES;
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+  frame_memory = FrameMemory::HEAP;
+
+  // Scenario: pages written through a huge page backed pool survive eviction.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * 4; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  for (auto page_id : page_ids) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ("page " + std::to_string(page_id), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
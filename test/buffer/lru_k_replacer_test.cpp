@@ -21,23 +21,23 @@ TEST(LRUKReplacerTest, SampleTest) {
 
   // Scenario: add six elements to the replacer. We have [1,2,3,4,5]. Frame 6 is non-evictable.
   lru_replacer.RecordAccess(1);
-  ASSERT_EQ(1, lru_replacer.siz0_);
-  ASSERT_EQ(0, lru_replacer.siz1_);
+  ASSERT_EQ(1, lru_replacer.history_.size());
+  ASSERT_EQ(0, lru_replacer.cache_.size());
   lru_replacer.RecordAccess(2);
-  ASSERT_EQ(2, lru_replacer.siz0_);
-  ASSERT_EQ(0, lru_replacer.siz1_);
+  ASSERT_EQ(2, lru_replacer.history_.size());
+  ASSERT_EQ(0, lru_replacer.cache_.size());
   lru_replacer.RecordAccess(3);
-  ASSERT_EQ(3, lru_replacer.siz0_);
-  ASSERT_EQ(0, lru_replacer.siz1_);
+  ASSERT_EQ(3, lru_replacer.history_.size());
+  ASSERT_EQ(0, lru_replacer.cache_.size());
   lru_replacer.RecordAccess(4);
-  ASSERT_EQ(4, lru_replacer.siz0_);
-  ASSERT_EQ(0, lru_replacer.siz1_);
+  ASSERT_EQ(4, lru_replacer.history_.size());
+  ASSERT_EQ(0, lru_replacer.cache_.size());
   lru_replacer.RecordAccess(5);
-  ASSERT_EQ(5, lru_replacer.siz0_);
-  ASSERT_EQ(0, lru_replacer.siz1_);
+  ASSERT_EQ(5, lru_replacer.history_.size());
+  ASSERT_EQ(0, lru_replacer.cache_.size());
   lru_replacer.RecordAccess(6);
-  ASSERT_EQ(6, lru_replacer.siz0_);
-  ASSERT_EQ(0, lru_replacer.siz1_);
+  ASSERT_EQ(6, lru_replacer.history_.size());
+  ASSERT_EQ(0, lru_replacer.cache_.size());
   lru_replacer.SetEvictable(1, true);
   lru_replacer.SetEvictable(2, true);
   lru_replacer.SetEvictable(3, true);
@@ -45,57 +45,55 @@ TEST(LRUKReplacerTest, SampleTest) {
   lru_replacer.SetEvictable(5, true);
   lru_replacer.SetEvictable(6, false);
   ASSERT_EQ(5, lru_replacer.Size());
-  ASSERT_EQ(5, lru_replacer.siz0_);
-  ASSERT_EQ(0, lru_replacer.siz1_);
+  ASSERT_EQ(5, lru_replacer.history_.size());
+  ASSERT_EQ(0, lru_replacer.cache_.size());
   // Scenario: Insert access history for frame 1. Now frame 1 has two access histories.
   // All other frames have max backward k-dist. The order of eviction is [2,3,4,5,1].
   lru_replacer.RecordAccess(1);
-  ASSERT_EQ(4, lru_replacer.siz0_);
-  ASSERT_EQ(1, lru_replacer.siz1_);
+  ASSERT_EQ(4, lru_replacer.history_.size());
+  ASSERT_EQ(1, lru_replacer.cache_.size());
   // Scenario: Evict three pages from the replacer. Elements with max k-distance should be popped
   // first based on LRU.
 
   int value;
   lru_replacer.Evict(&value);
   ASSERT_EQ(2, value);
-  ASSERT_EQ(3, lru_replacer.siz0_);
-  ASSERT_EQ(1, lru_replacer.siz1_);
+  ASSERT_EQ(3, lru_replacer.history_.size());
+  ASSERT_EQ(1, lru_replacer.cache_.size());
   lru_replacer.Evict(&value);
   ASSERT_EQ(3, value);
-  ASSERT_EQ(2, lru_replacer.siz0_);
-  ASSERT_EQ(1, lru_replacer.siz1_);
+  ASSERT_EQ(2, lru_replacer.history_.size());
+  ASSERT_EQ(1, lru_replacer.cache_.size());
   lru_replacer.Evict(&value);
   ASSERT_EQ(4, value);
-  ASSERT_EQ(1, lru_replacer.siz0_);
-  ASSERT_EQ(1, lru_replacer.siz1_);
+  ASSERT_EQ(1, lru_replacer.history_.size());
+  ASSERT_EQ(1, lru_replacer.cache_.size());
   ASSERT_EQ(2, lru_replacer.Size());
-  ASSERT_EQ(nullptr, lru_replacer.dir0_[3]);
-  ASSERT_EQ(nullptr, lru_replacer.dir1_[3]);
-  ASSERT_EQ(nullptr, lru_replacer.dir0_[4]);
-  ASSERT_EQ(nullptr, lru_replacer.dir1_[4]);
+  ASSERT_EQ(0, lru_replacer.node_store_[3].num_accesses_);
+  ASSERT_EQ(0, lru_replacer.node_store_[4].num_accesses_);
   // Scenario: Now replacer has frames [5,1].
 
   // Insert new frames 3, 4, and update access history for 5. We should end with [3,1,5,4]
   lru_replacer.RecordAccess(3);
-  ASSERT_EQ(2, lru_replacer.siz0_);
-  ASSERT_EQ(1, lru_replacer.siz1_);
+  ASSERT_EQ(2, lru_replacer.history_.size());
+  ASSERT_EQ(1, lru_replacer.cache_.size());
 
   lru_replacer.RecordAccess(4);
-  ASSERT_EQ(3, lru_replacer.siz0_);
-  ASSERT_EQ(1, lru_replacer.siz1_);
+  ASSERT_EQ(3, lru_replacer.history_.size());
+  ASSERT_EQ(1, lru_replacer.cache_.size());
   lru_replacer.RecordAccess(5);
 
-  ASSERT_EQ(2, lru_replacer.siz0_);
-  ASSERT_EQ(2, lru_replacer.siz1_);
+  ASSERT_EQ(2, lru_replacer.history_.size());
+  ASSERT_EQ(2, lru_replacer.cache_.size());
   lru_replacer.RecordAccess(4);
 
-  ASSERT_EQ(1, lru_replacer.siz0_);
-  ASSERT_EQ(3, lru_replacer.siz1_);
+  ASSERT_EQ(1, lru_replacer.history_.size());
+  ASSERT_EQ(3, lru_replacer.cache_.size());
   lru_replacer.SetEvictable(3, true);
 
   lru_replacer.SetEvictable(4, true);
   ASSERT_EQ(4, lru_replacer.Size());
-  ASSERT_EQ(3, lru_replacer.head0_->nxt_->nxt_->frame_id_);
+  ASSERT_EQ(3, lru_replacer.history_.begin()->second);
   // Scenario: continue looking for victims. We expect 3 to be evicted next.
   lru_replacer.Evict(&value);
   ASSERT_EQ(3, value);
@@ -134,4 +132,48 @@ TEST(LRUKReplacerTest, SampleTest) {
   lru_replacer.Remove(1);
   ASSERT_EQ(0, lru_replacer.Size());
 }
+
+TEST(LRUKReplacerTest, EvictionOrderTest) {
+  LRUKReplacer lru_replacer(8, 2);
+  int value;
+
+  // Scenario: frames 0..3 have one access each, frames 4..5 two. Pinning and unpinning a frame keeps its position.
+  for (int i = 0; i < 6; ++i) {
+    lru_replacer.RecordAccess(i);
+  }
+  lru_replacer.RecordAccess(5);
+  lru_replacer.RecordAccess(4);
+  lru_replacer.SetEvictable(0, false);
+  lru_replacer.SetEvictable(5, false);
+  ASSERT_EQ(4, lru_replacer.Size());
+  lru_replacer.SetEvictable(0, true);
+  lru_replacer.SetEvictable(5, true);
+  ASSERT_EQ(6, lru_replacer.Size());
+  ASSERT_EQ((std::vector<frame_id_t>{0, 1, 2, 3, 4, 5}), lru_replacer.GetEvictionCandidates(8));
+
+  // Scenario: frames with k accesses are ordered by their k-th most recent access, not by their last one. Frame 4 was
+  // accessed first, so it goes before frame 5 even though its second access is more recent.
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(0, value);
+  lru_replacer.Remove(1);
+  lru_replacer.Remove(2);
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(4, value);
+
+  // Scenario: a new access moves a frame behind the others; pinned frames are never returned.
+  lru_replacer.RecordAccess(6);
+  lru_replacer.RecordAccess(6);
+  lru_replacer.RecordAccess(5);
+  lru_replacer.SetEvictable(6, false);
+  ASSERT_EQ(1, lru_replacer.Size());
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(5, value);
+  ASSERT_FALSE(lru_replacer.Evict(&value));
+  lru_replacer.SetEvictable(6, true);
+  ASSERT_TRUE(lru_replacer.Evict(&value));
+  ASSERT_EQ(6, value);
+  ASSERT_EQ(0, lru_replacer.Size());
+}
 }  // namespace bustub
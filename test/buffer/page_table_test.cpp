@@ -0,0 +1,147 @@
+/**
+ * page_table_test.cpp
+ */
+
+#include "buffer/page_table.h"
+
+#include <random>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+TEST(PageTableTest, SampleTest) {
+  PageTable table(4);
+
+  frame_id_t fid = -1;
+  ASSERT_FALSE(table.Find(0, &fid));
+  table.Insert(0, 3);
+  table.Insert(7, 1);
+  ASSERT_TRUE(table.Find(0, &fid));
+  ASSERT_EQ(3, fid);
+  ASSERT_TRUE(table.Find(7, &fid));
+  ASSERT_EQ(1, fid);
+
+  // Inserting an existing page replaces its frame.
+  table.Insert(7, 2);
+  ASSERT_TRUE(table.Find(7, &fid));
+  ASSERT_EQ(2, fid);
+
+  ASSERT_TRUE(table.Remove(7));
+  ASSERT_FALSE(table.Remove(7));
+  ASSERT_FALSE(table.Find(7, &fid));
+  ASSERT_TRUE(table.Find(0, &fid));
+}
+
+TEST(PageTableTest, GrowAndRemoveTest) {
+  // One stripe with a tiny initial capacity, so that the table must grow and probe sequences get long.
+  PageTable table(1, 1);
+  const int num_pages = 10000;
+  for (int i = 0; i < num_pages; ++i) {
+    table.Insert(i * 16, i);
+  }
+  frame_id_t fid = -1;
+  for (int i = 0; i < num_pages; ++i) {
+    ASSERT_TRUE(table.Find(i * 16, &fid));
+    ASSERT_EQ(i, fid);
+  }
+
+  // Removing every other page must not lose any entry whose probe sequence ran through a removed slot.
+  for (int i = 0; i < num_pages; i += 2) {
+    ASSERT_TRUE(table.Remove(i * 16));
+  }
+  for (int i = 0; i < num_pages; ++i) {
+    ASSERT_EQ(i % 2 == 1, table.Find(i * 16, &fid));
+    if (i % 2 == 1) {
+      ASSERT_EQ(i, fid);
+    }
+  }
+}
+
+TEST(PageTableTest, ApplyRemoveIfTest) {
+  PageTable table(8);
+  table.Insert(5, 2);
+
+  int calls = 0;
+  ASSERT_TRUE(table.Apply(5, [&](frame_id_t fid) {
+    ASSERT_EQ(2, fid);
+    ++calls;
+  }));
+  ASSERT_FALSE(table.Apply(6, [&](frame_id_t /* fid */) { ++calls; }));
+  ASSERT_EQ(1, calls);
+
+  ASSERT_FALSE(table.RemoveIf(5, [](frame_id_t /* fid */) { return false; }));
+  frame_id_t fid = -1;
+  ASSERT_TRUE(table.Find(5, &fid));
+  ASSERT_TRUE(table.RemoveIf(5, [](frame_id_t fid) { return fid == 2; }));
+  ASSERT_FALSE(table.Find(5, &fid));
+}
+
+TEST(PageTableTest, RandomOpsTest) {
+  PageTable table(64);
+  std::unordered_map<page_id_t, frame_id_t> expected;
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<page_id_t> page_dist(0, 511);
+  std::uniform_int_distribution<int> op_dist(0, 2);
+
+  for (int i = 0; i < 100000; ++i) {
+    page_id_t page_id = page_dist(gen);
+    frame_id_t fid = -1;
+    switch (op_dist(gen)) {
+      case 0:
+        table.Insert(page_id, i);
+        expected[page_id] = i;
+        break;
+      case 1:
+        ASSERT_EQ(expected.erase(page_id) == 1, table.Remove(page_id));
+        break;
+      default:
+        ASSERT_EQ(expected.count(page_id) == 1, table.Find(page_id, &fid));
+        if (expected.count(page_id) == 1) {
+          ASSERT_EQ(expected[page_id], fid);
+        }
+    }
+  }
+}
+
+TEST(PageTableTest, ConcurrentTest) {
+  const int num_threads = 8;
+  const int pages_per_thread = 2000;
+  PageTable table(64);
+
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&table, tid] {
+      // Each thread owns the pages congruent to its id, but all of them share the stripes.
+      for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < pages_per_thread; ++i) {
+          table.Insert(i * num_threads + tid, i);
+        }
+        for (int i = 0; i < pages_per_thread; ++i) {
+          frame_id_t fid = -1;
+          ASSERT_TRUE(table.Find(i * num_threads + tid, &fid));
+          ASSERT_EQ(i, fid);
+        }
+        for (int i = 0; i < pages_per_thread; i += 2) {
+          ASSERT_TRUE(table.Remove(i * num_threads + tid));
+        }
+        for (int i = 1; i < pages_per_thread; i += 2) {
+          ASSERT_TRUE(table.Remove(i * num_threads + tid));
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  frame_id_t fid = -1;
+  for (page_id_t page_id = 0; page_id < num_threads * pages_per_thread; ++page_id) {
+    ASSERT_FALSE(table.Find(page_id, &fid));
+  }
+}
+
+}  // namespace bustub
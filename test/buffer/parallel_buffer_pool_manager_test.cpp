@@ -0,0 +1,221 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+// Check whether pages containing terminal characters can be recovered
+TEST(ParallelBufferPoolManagerTest, BinaryDataTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 5;
+  const size_t k = 5;
+
+  std::random_device r;
+  std::default_random_engine rng(r());
+  std::uniform_int_distribution<char> uniform_dist(0);
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, k);
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  char random_binary_data[BUSTUB_PAGE_SIZE];
+  // Generate random binary data
+  for (char &i : random_binary_data) {
+    i = uniform_dist(rng);
+  }
+
+  // Insert terminal characters both in the middle and at end
+  random_binary_data[BUSTUB_PAGE_SIZE / 2] = '\0';
+  random_binary_data[BUSTUB_PAGE_DATA_SIZE - 1] = '\0';
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  std::memcpy(page0->GetData(), random_binary_data, BUSTUB_PAGE_SIZE);
+  EXPECT_EQ(0, std::memcmp(page0->GetData(), random_binary_data, BUSTUB_PAGE_SIZE));
+
+  // Scenario: We should be able to create new pages until we fill up the buffer pool.
+  for (size_t i = 1; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: Once the buffer pool is full, we should not be able to create any new pages.
+  for (size_t i = buffer_pool_size * num_instances; i < buffer_pool_size * num_instances * 2; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning pages {0, 1, 2, 3, 4} we should be able to create 5 new pages
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+    bpm->FlushPage(i);
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+  // Scenario: We should be able to fetch the data we wrote a while ago.
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, memcmp(page0->GetData(), random_binary_data, BUSTUB_PAGE_DATA_SIZE));
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+
+  // Shutdown the disk manager and remove the temporary file we created.
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, RoundRobinTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 2;
+  const size_t num_instances = 4;
+  const size_t k = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, k);
+  EXPECT_EQ(buffer_pool_size * num_instances, bpm->GetPoolSize());
+
+  // Scenario: consecutive new pages are spread across the instances, and every page id maps back to the instance
+  // that allocated it.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    page_id_t page_id_temp;
+    auto *page = bpm->NewPage(&page_id_temp);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(page_id_temp, page->GetPageId());
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id_temp);
+    page_ids.push_back(page_id_temp);
+  }
+  std::vector<size_t> pages_per_instance(num_instances, 0);
+  for (auto page_id : page_ids) {
+    pages_per_instance[page_id % num_instances]++;
+  }
+  for (auto count : pages_per_instance) {
+    EXPECT_EQ(buffer_pool_size, count);
+  }
+
+  // Scenario: a full instance is skipped, so a single free frame anywhere is enough for a new page.
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[3], true));
+  page_id_t page_id_temp;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(page_ids[3] % num_instances, page_id_temp % num_instances);
+  EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(nullptr, bpm->FetchPage(page_ids[3]));
+
+  // Scenario: evicted pages are read back through the instance that owns them.
+  EXPECT_TRUE(bpm->UnpinPage(page_id_temp, false));
+  auto *page = bpm->FetchPage(page_ids[3]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(0, strcmp(page->GetData(), ("page " + std::to_string(page_ids[3])).c_str()));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[3], false));
+
+  // Scenario: pinned pages cannot be deleted, unpinned pages can.
+  EXPECT_FALSE(bpm->DeletePage(page_ids[0]));
+  EXPECT_TRUE(bpm->UnpinPage(page_ids[0], false));
+  EXPECT_TRUE(bpm->DeletePage(page_ids[0]));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrencyTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 4;
+  const size_t num_threads = 4;
+  const size_t pages_per_thread = 64;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, 2);
+
+  std::vector<std::vector<page_id_t>> page_ids(num_threads);
+  std::vector<std::thread> threads;
+  for (size_t tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      for (size_t i = 0; i < pages_per_thread; ++i) {
+        page_id_t page_id_temp;
+        auto *page = bpm->NewPage(&page_id_temp);
+        if (page == nullptr) {
+          continue;
+        }
+        snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+        EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+        page_ids[tid].push_back(page_id_temp);
+      }
+      for (auto page_id : page_ids[tid]) {
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        EXPECT_EQ(0, strcmp(page->GetData(), std::to_string(page_id).c_str()));
+        EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, PageCleanerShutdownTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 4;
+
+  // Scenario: the pool is destroyed while its cleaners are writing dirty pages through the shared scheduler.
+  for (int round = 0; round < 100; ++round) {
+    auto *disk_manager = new DiskManagerUnlimitedMemory();
+    auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager, 2);
+    for (size_t i = 0; i < num_instances * buffer_pool_size; ++i) {
+      page_id_t page_id_temp;
+      auto *page = bpm->NewPage(&page_id_temp);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id_temp);
+      EXPECT_TRUE(bpm->UnpinPage(page_id_temp, true));
+    }
+    bpm->StartPageCleaner();
+    delete bpm;
+    delete disk_manager;
+  }
+}
+
+}  // namespace bustub
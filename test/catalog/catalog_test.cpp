@@ -23,8 +23,8 @@
 
 namespace bustub {
 
-/** Index creation parameters for a BIGINT key */
-constexpr static const auto BIGINT_SIZE = 8;
+/** Index creation parameters for a BIGINT key, which is followed by the RID of its entry */
+constexpr static const auto BIGINT_SIZE = 16;
 using BigintKeyType = GenericKey<BIGINT_SIZE>;
 using BigintValueType = RID;
 using BigintComparatorType = GenericComparator<BIGINT_SIZE>;
@@ -551,8 +551,8 @@ TEST(CatalogTest, DISABLED_IndexInteraction1) {
   Schema key_schema{key_columns};
 
   // Index construction should succeed
-  auto *index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
-      txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, 8, HashFunction<GenericKey<8>>{});
+  auto *index_info = catalog->CreateIndex<GenericKey<16>, RID, GenericComparator<16>>(
+      txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, 16, HashFunction<GenericKey<16>>{});
   EXPECT_NE(Catalog::NULL_INDEX_INFO, index_info);
   auto *index = index_info->index_.get();
 
@@ -603,8 +603,8 @@ TEST(CatalogTest, DISABLED_IndexInteraction2) {
   Schema key_schema{key_columns};
 
   // Index construction should succeed
-  auto *index_info = catalog->CreateIndex<GenericKey<4>, RID, GenericComparator<4>>(
-      txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, 4, HashFunction<GenericKey<4>>{});
+  auto *index_info = catalog->CreateIndex<GenericKey<16>, RID, GenericComparator<16>>(
+      txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, 16, HashFunction<GenericKey<16>>{});
   EXPECT_NE(Catalog::NULL_INDEX_INFO, index_info);
   auto *index = index_info->index_.get();
 
@@ -656,8 +656,8 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
   Schema key_schema{key_columns};
 
   // Index construction should succeed
-  auto *index_info = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
-      txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, 8, HashFunction<GenericKey<8>>{});
+  auto *index_info = catalog->CreateIndex<GenericKey<16>, RID, GenericComparator<16>>(
+      txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, 16, HashFunction<GenericKey<16>>{});
   EXPECT_NE(Catalog::NULL_INDEX_INFO, index_info);
   auto *index = index_info->index_.get();
 
@@ -0,0 +1,105 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_bulk_load_test.cpp
+//
+// Identification: test/storage/b_plus_tree_bulk_load_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/index/b_plus_tree.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+using BulkLoadTree = BPlusTree<GenericKey<8>, RID, GenericComparator<8>>;
+
+namespace {
+
+/** Check that the tree holds exactly the even keys below 2 * count, plus the odd keys below 2 * num_odd. */
+void CheckKeys(BulkLoadTree *tree, int64_t count, int64_t num_odd) {
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  for (int64_t key = 0; key < 2 * count; ++key) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    bool expected = key % 2 == 0 || key < 2 * num_odd;
+    ASSERT_EQ(expected, tree->GetValue(index_key, &rids)) << key;
+    if (expected) {
+      ASSERT_EQ(key, rids[0].GetSlotNum());
+    }
+  }
+
+  // The leaves are chained in key order.
+  int64_t expected_key = 0;
+  int64_t size = 0;
+  for (auto it = tree->Begin(); !it.IsEnd(); ++it) {
+    ASSERT_EQ(expected_key, (*it).second.GetSlotNum());
+    expected_key += expected_key < 2 * num_odd - 1 ? 1 : 2;
+    ++size;
+  }
+  ASSERT_EQ(count + num_odd, size);
+}
+
+}  // namespace
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  for (auto [leaf_max_size, internal_max_size] : {std::pair{2, 3}, {3, 4}, {5, 5}, {16, 16}}) {
+    for (double fill_factor : {0.5, 1.0}) {
+      for (int64_t count : {0, 1, 2, 7, 50, 333}) {
+        auto *disk_manager = new DiskManagerUnlimitedMemory();
+        auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+        page_id_t header_page_id;
+        bpm->NewPage(&header_page_id);
+        auto *transaction = new Transaction(0);
+        BulkLoadTree tree("foo_pk", bpm, comparator, leaf_max_size, internal_max_size);
+
+        // Load the even keys.
+        std::vector<std::pair<GenericKey<8>, RID>> items(count);
+        for (int64_t i = 0; i < count; ++i) {
+          items[i].first.SetFromInteger(2 * i);
+          items[i].second.Set(0, 2 * i);
+        }
+        ASSERT_TRUE(tree.BulkLoad(&items, fill_factor));
+        ASSERT_EQ(count == 0, tree.IsEmpty());
+        CheckKeys(&tree, count, 0);
+        // A second bulk load into a non-empty tree is refused.
+        ASSERT_EQ(count == 0, tree.BulkLoad(&items, fill_factor));
+
+        // The tree keeps working as usual: insert the odd keys in between, then remove them again.
+        GenericKey<8> index_key;
+        RID rid;
+        for (int64_t i = 0; i < count; ++i) {
+          index_key.SetFromInteger(2 * i + 1);
+          rid.Set(0, 2 * i + 1);
+          ASSERT_TRUE(tree.Insert(index_key, rid, transaction));
+        }
+        CheckKeys(&tree, count, count);
+        for (int64_t i = 0; i < count; ++i) {
+          index_key.SetFromInteger(2 * i + 1);
+          tree.Remove(index_key, transaction);
+        }
+        CheckKeys(&tree, count, 0);
+
+        bpm->UnpinPage(header_page_id, true);
+        delete transaction;
+        delete bpm;
+        delete disk_manager;
+      }
+    }
+  }
+}
+
+}  // namespace bustub
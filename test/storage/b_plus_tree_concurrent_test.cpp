@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -360,4 +361,207 @@ TEST(BPlusTreeConcurrentTest, MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, ReadDuringSplitMergeTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree; tiny nodes so that almost every write splits or merges inner pages
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 5);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  // odd keys stay in the tree the whole time, even keys come and go
+  int N = 1000;
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> churn_keys;
+  for (int i = 1; i < N; i += 2) {
+    stable_keys.push_back(i);
+    churn_keys.push_back(i + 1);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  // Readers descend without latching inner pages while writers restructure them: every stable key must be found.
+  std::atomic<bool> done{false};
+  std::vector<std::thread> thread_group;
+  for (int thread_itr = 0; thread_itr < 2; ++thread_itr) {
+    thread_group.emplace_back([&] {
+      for (int round = 0; round < 3; ++round) {
+        InsertHelper(&tree, churn_keys);
+        DeleteHelper(&tree, churn_keys);
+      }
+    });
+  }
+  std::atomic<int> missing{0};
+  for (int thread_itr = 0; thread_itr < 4; ++thread_itr) {
+    thread_group.emplace_back([&] {
+      std::vector<RID> rids;
+      GenericKey<8> index_key;
+      while (!done) {
+        for (auto key : stable_keys) {
+          rids.clear();
+          index_key.SetFromInteger(key);
+          if (!tree.GetValue(index_key, &rids) || rids.size() != 1 || rids[0].GetSlotNum() != key) {
+            ++missing;
+          }
+        }
+      }
+    });
+  }
+  thread_group[0].join();
+  thread_group[1].join();
+  done = true;
+  for (size_t thread_itr = 2; thread_itr < thread_group.size(); ++thread_itr) {
+    thread_group[thread_itr].join();
+  }
+  EXPECT_EQ(0, missing);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, ReadDuringMergeTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree; tiny nodes so that the deletes below merge inner pages level after level
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  // every tenth key stays in the tree, the others are deleted while readers look the kept ones up
+  int N = 2000;
+  std::vector<int64_t> all_keys;
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> remove_keys;
+  for (int i = 1; i <= N; i++) {
+    all_keys.push_back(i);
+    (i % 10 == 0 ? stable_keys : remove_keys).push_back(i);
+  }
+  InsertHelper(&tree, all_keys);
+
+  std::atomic<bool> done{false};
+  std::atomic<int> missing{0};
+  std::vector<std::thread> thread_group;
+  for (int thread_itr = 0; thread_itr < 2; ++thread_itr) {
+    thread_group.emplace_back(DeleteHelperSplit, &tree, remove_keys, 2, thread_itr);
+  }
+  for (int thread_itr = 0; thread_itr < 4; ++thread_itr) {
+    thread_group.emplace_back([&] {
+      std::vector<RID> rids;
+      GenericKey<8> index_key;
+      while (!done) {
+        for (auto key : stable_keys) {
+          rids.clear();
+          index_key.SetFromInteger(key);
+          if (!tree.GetValue(index_key, &rids) || rids.size() != 1 || rids[0].GetSlotNum() != key) {
+            ++missing;
+          }
+        }
+      }
+    });
+  }
+  thread_group[0].join();
+  thread_group[1].join();
+  done = true;
+  for (size_t thread_itr = 2; thread_itr < thread_group.size(); ++thread_itr) {
+    thread_group[thread_itr].join();
+  }
+  EXPECT_EQ(0, missing);
+
+  // only the kept keys are left, in order
+  std::vector<int64_t> left;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+    left.push_back((*iter).second.GetSlotNum());
+  }
+  EXPECT_EQ(stable_keys, left);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, ScanDuringMergeTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // create b+ tree; tiny nodes so that the deletes below merge leaves all the time
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  // every tenth key stays in the tree, the others are deleted while iterators walk the leaves from left to right,
+  // which is the opposite of the order in which a merge latches a leaf and its left sibling
+  int N = 2000;
+  std::vector<int64_t> all_keys;
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> remove_keys;
+  for (int i = 1; i <= N; i++) {
+    all_keys.push_back(i);
+    (i % 10 == 0 ? stable_keys : remove_keys).push_back(i);
+  }
+  InsertHelper(&tree, all_keys);
+
+  std::atomic<bool> done{false};
+  std::atomic<int> missing{0};
+  std::vector<std::thread> thread_group;
+  for (int thread_itr = 0; thread_itr < 2; ++thread_itr) {
+    thread_group.emplace_back(DeleteHelperSplit, &tree, remove_keys, 2, thread_itr);
+  }
+  for (int thread_itr = 0; thread_itr < 2; ++thread_itr) {
+    thread_group.emplace_back([&] {
+      while (!done) {
+        std::vector<int64_t> seen;
+        for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+          auto key = (*iter).second.GetSlotNum();
+          if (key % 10 == 0) {
+            seen.push_back(key);
+          }
+        }
+        if (seen != stable_keys) {
+          ++missing;
+        }
+      }
+    });
+  }
+  thread_group[0].join();
+  thread_group[1].join();
+  done = true;
+  for (size_t thread_itr = 2; thread_itr < thread_group.size(); ++thread_itr) {
+    thread_group[thread_itr].join();
+  }
+  EXPECT_EQ(0, missing);
+
+  std::vector<int64_t> left;
+  for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+    left.push_back((*iter).second.GetSlotNum());
+  }
+  EXPECT_EQ(stable_keys, left);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
@@ -15,7 +15,9 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/page/header_page.h"
 #include "test_util.h"  // NOLINT
 
 namespace bustub {
@@ -241,4 +243,160 @@ TEST(BPlusTreeTests, DeleteTest3) {
   remove("test.db");
   remove("test.log");
 }
+TEST(BPlusTreeTests, DeletePagesTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 5);
+  GenericKey<8> index_key;
+  RID rid;
+  auto *transaction = new Transaction(0);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  // Filling and emptying the tree over and over reuses the pages merges free, so the file stops growing.
+  const int64_t num_keys = 500;
+  size_t file_size = 0;
+  for (int round = 0; round < 3; ++round) {
+    for (int64_t key = 0; key < num_keys; ++key) {
+      rid.Set(0, key);
+      index_key.SetFromInteger(key);
+      ASSERT_TRUE(tree.Insert(index_key, rid, transaction));
+    }
+    bpm->FlushAllPages();
+    if (round == 0) {
+      file_size = disk_manager->GetDbFileSize();
+    }
+    EXPECT_EQ(file_size, disk_manager->GetDbFileSize());
+    for (int64_t key = 0; key < num_keys; ++key) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key, transaction);
+    }
+    EXPECT_TRUE(tree.IsEmpty());
+    EXPECT_TRUE(transaction->GetDeletedPageSet()->empty());
+    // Every page of the tree was given back.
+    EXPECT_EQ(file_size / BUSTUB_PAGE_SIZE - 1, disk_manager->GetNumFreePages());
+  }
+  EXPECT_GT(disk_manager->GetNumReusedPages(), 0);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BPlusTreeTests, DeferredDeletePagesTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 5);
+  GenericKey<8> index_key;
+  RID rid;
+  auto *transaction = new Transaction(0);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+
+  const int64_t num_keys = 100;
+  for (int64_t key = 0; key < num_keys; ++key) {
+    rid.Set(0, key);
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+  bpm->FlushAllPages();
+  auto num_pages = disk_manager->GetDbFileSize() / BUSTUB_PAGE_SIZE;
+
+  // A pinned page the removes merge away is not leaked: it waits for the pin to go, and a later remove deletes it.
+  auto root_page_id = tree.GetRootPageId();
+  ASSERT_NE(nullptr, bpm->FetchPage(root_page_id));
+  for (int64_t key = 0; key < num_keys; ++key) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+  EXPECT_EQ(1, tree.GetNumDeferredPages());
+  EXPECT_EQ(num_pages - 2, disk_manager->GetNumFreePages());
+
+  ASSERT_TRUE(bpm->UnpinPage(root_page_id, false));
+  rid.Set(0, 0);
+  index_key.SetFromInteger(0);
+  ASSERT_TRUE(tree.Insert(index_key, rid, transaction));
+  tree.Remove(index_key, transaction);
+  EXPECT_EQ(0, tree.GetNumDeferredPages());
+  EXPECT_EQ(num_pages - 1, disk_manager->GetNumFreePages());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+}
+
+TEST(BPlusTreeTests, RootRecordTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  auto *header_page = reinterpret_cast<HeaderPage *>(bpm->NewPage(&page_id));
+  ASSERT_EQ(page_id, HEADER_PAGE_ID);
+  header_page->Init();
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 3);
+  auto *transaction = new Transaction(0);
+
+  auto recorded_root = [&] {
+    page_id_t root_page_id = INVALID_PAGE_ID;
+    auto *page = reinterpret_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID));
+    EXPECT_TRUE(page->GetRootId("foo_pk", &root_page_id));
+    bpm->UnpinPage(HEADER_PAGE_ID, false);
+    return root_page_id;
+  };
+  auto header_page_dirty = [&] {
+    auto *page = bpm->FetchPage(HEADER_PAGE_ID);
+    bool dirty = page->IsDirty();
+    bpm->UnpinPage(HEADER_PAGE_ID, false);
+    return dirty;
+  };
+
+  // The record follows the root as the tree grows a level at a time.
+  GenericKey<8> index_key;
+  RID rid;
+  for (int64_t key = 1; key <= 50; ++key) {
+    rid.Set(static_cast<int32_t>(key >> 32), static_cast<int32_t>(key & 0xFFFFFFFF));
+    index_key.SetFromInteger(key);
+    ASSERT_TRUE(tree.Insert(index_key, rid, transaction));
+    ASSERT_EQ(tree.GetRootPageId(), recorded_root());
+  }
+
+  // Lookups leave the header page alone.
+  bpm->FlushPage(HEADER_PAGE_ID);
+  ASSERT_FALSE(header_page_dirty());
+  for (int64_t key = 1; key <= 50; ++key) {
+    std::vector<RID> rids;
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids, transaction));
+  }
+  EXPECT_FALSE(header_page_dirty());
+
+  // The record follows the root as the tree shrinks, and as it grows a root again after it was emptied.
+  for (int64_t key = 1; key <= 50; ++key) {
+    index_key.SetFromInteger(key);
+    tree.Remove(index_key, transaction);
+    EXPECT_EQ(tree.GetRootPageId(), recorded_root());
+  }
+  EXPECT_EQ(INVALID_PAGE_ID, recorded_root());
+  index_key.SetFromInteger(7);
+  ASSERT_TRUE(tree.Insert(index_key, rid, transaction));
+  EXPECT_NE(INVALID_PAGE_ID, tree.GetRootPageId());
+  EXPECT_EQ(tree.GetRootPageId(), recorded_root());
+
+  delete transaction;
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
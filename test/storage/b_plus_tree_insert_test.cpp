@@ -12,6 +12,7 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <random>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
@@ -196,4 +197,65 @@ TEST(BPlusTreeTests, InsertTest3) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, IntegerKeyTest) {
+  // a 4-byte integer key is compared as a raw integer, negative keys included
+  auto key_schema = ParseCreateStatement("a integer");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+  GenericKey<8> index_key;
+  RID rid;
+  auto *transaction = new Transaction(0);
+
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  std::vector<int64_t> keys;
+  for (int64_t key = -100; key < 100; key++) {
+    keys.push_back(key);
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+  for (auto key : keys) {
+    rid.Set(0, static_cast<uint32_t>(key + 100));
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.Insert(index_key, rid, transaction));
+  }
+
+  GenericKey<8> other_key;
+  index_key.SetFromInteger(-1);
+  other_key.SetFromInteger(1);
+  EXPECT_LT(comparator(index_key, other_key), 0);
+  EXPECT_GT(comparator(other_key, index_key), 0);
+
+  std::vector<RID> rids;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    EXPECT_TRUE(tree.GetValue(index_key, &rids));
+    ASSERT_EQ(rids.size(), 1);
+    EXPECT_EQ(rids[0].GetSlotNum(), key + 100);
+  }
+  rids.clear();
+  index_key.SetFromInteger(100);
+  EXPECT_FALSE(tree.GetValue(index_key, &rids));
+
+  int64_t current_key = -20;
+  index_key.SetFromInteger(current_key);
+  for (auto iterator = tree.Begin(index_key); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ((*iterator).second.GetSlotNum(), current_key + 100);
+    current_key = current_key + 1;
+  }
+  EXPECT_EQ(current_key, 100);
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete transaction;
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
 }  // namespace bustub
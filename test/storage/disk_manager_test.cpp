@@ -10,9 +10,16 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <unistd.h>
+#include <algorithm>
 #include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
 
 #include "common/exception.h"
+#include "common/util/checksum_util.h"
+#include "common/util/compression_util.h"
 #include "gtest/gtest.h"
 #include "storage/disk/disk_manager.h"
 
@@ -24,12 +31,16 @@ class DiskManagerTest : public ::testing::Test {
   void SetUp() override {
     remove("test.db");
     remove("test.log");
+    remove("test.free");
+    remove("test.ext");
   }
 
   // This function is called after every test.
   void TearDown() override {
     remove("test.db");
     remove("test.log");
+    remove("test.free");
+    remove("test.ext");
   };
 };
 
@@ -45,12 +56,12 @@ TEST_F(DiskManagerTest, ReadWritePageTest) {
 
   dm.WritePage(0, data);
   dm.ReadPage(0, buf);
-  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_DATA_SIZE), 0);
 
   std::memset(buf, 0, sizeof(buf));
   dm.WritePage(5, data);
   dm.ReadPage(5, buf);
-  EXPECT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+  EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_DATA_SIZE), 0);
 
   dm.ShutDown();
 }
@@ -72,6 +83,253 @@ TEST_F(DiskManagerTest, ReadWriteLogTest) {
   dm.ShutDown();
 }
 
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, FreePageTest) {
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    for (page_id_t page_id = 0; page_id < 8; ++page_id) {
+      dm.WritePage(page_id, data);
+    }
+    EXPECT_EQ(8 * BUSTUB_PAGE_SIZE, dm.GetDbFileSize());
+    EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage());
+
+    dm.DeallocatePage(6);
+    dm.DeallocatePage(3);
+    dm.DeallocatePage(5);
+    dm.DeallocatePage(5);
+    EXPECT_EQ(3, dm.GetNumFreePages());
+    // The lowest free page goes first, among the pages of the asking buffer pool instance.
+    EXPECT_EQ(3, dm.AllocateFreePage());
+    EXPECT_EQ(6, dm.AllocateFreePage(0, 2));
+    EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage(0, 2));
+    EXPECT_EQ(1, dm.GetNumFreePages());
+    EXPECT_EQ(2, dm.GetNumReusedPages());
+    dm.DeallocatePage(1);
+    dm.ShutDown();
+  }
+
+  // The free pages survive a restart.
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(2, dm.GetNumFreePages());
+    EXPECT_EQ(1, dm.AllocateFreePage());
+    EXPECT_EQ(5, dm.AllocateFreePage());
+    EXPECT_EQ(INVALID_PAGE_ID, dm.AllocateFreePage());
+    EXPECT_EQ(8 * BUSTUB_PAGE_SIZE, dm.GetDbFileSize());
+    dm.DeallocatePage(2);
+    dm.ShutDown();
+  }
+
+  // A free page file next to a new db file is stale.
+  remove("test.db");
+  {
+    auto dm = DiskManager(db_file);
+    EXPECT_EQ(0, dm.GetNumFreePages());
+    dm.ShutDown();
+  }
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumTest) {
+  // The check value of CRC32C.
+  EXPECT_EQ(0xE3069283, ChecksumUtil::Crc32c("123456789", 9));
+
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+  std::string db_file("test.db");
+  auto dm = std::make_unique<DiskManager>(db_file);
+  std::strncpy(data, "A test string.", sizeof(data));
+  for (page_id_t page_id = 0; page_id < 3; ++page_id) {
+    dm->WritePage(page_id, data);
+  }
+  dm->ShutDown();
+
+  // Tear the write of page 1: only its first half reached the disk.
+  {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(BUSTUB_PAGE_SIZE + BUSTUB_PAGE_SIZE / 2);
+    file.put('x');
+  }
+  // Cut the file short in the middle of the string on page 2.
+  ASSERT_EQ(0, truncate(db_file.c_str(), 2 * BUSTUB_PAGE_SIZE + 5));
+
+  // The checksums survive a restart.
+  dm = std::make_unique<DiskManager>(db_file);
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_DATA_SIZE), 0);
+  EXPECT_THROW(dm->ReadPage(1, buf), Exception);
+  EXPECT_THROW(dm->ReadPage(2, buf), Exception);
+  EXPECT_EQ(2, dm->GetNumChecksumFailures());
+  // A page that was never written has no checksum to fail.
+  dm->ReadPage(3, buf);
+
+  // Writing the page again fixes it.
+  dm->WritePage(1, data);
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(std::memcmp(buf, data, BUSTUB_PAGE_DATA_SIZE), 0);
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, ChecksumCrashTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char old_data[BUSTUB_PAGE_SIZE] = {0};
+  char new_data[BUSTUB_PAGE_SIZE] = {0};
+  std::strncpy(old_data, "The old version.", sizeof(old_data));
+  std::strncpy(new_data, "The new version.", sizeof(new_data));
+  std::string db_file("test.db");
+  auto dm = std::make_unique<DiskManager>(db_file);
+  dm->WritePage(0, old_data);
+  dm->WritePage(1, old_data);
+  char old_image[BUSTUB_PAGE_SIZE];
+  {
+    std::ifstream file(db_file, std::ios::binary);
+    file.seekg(BUSTUB_PAGE_SIZE);
+    ASSERT_TRUE(file.read(old_image, BUSTUB_PAGE_SIZE));
+  }
+  dm->WritePage(0, new_data);
+  dm->WritePage(1, new_data);
+  dm->ShutDown();
+
+  // A crash keeps the last write of page 0 and loses the one of page 1. Each page carries its own checksum, so
+  // neither is out of step with it.
+  {
+    std::fstream file(db_file, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(BUSTUB_PAGE_SIZE);
+    file.write(old_image, BUSTUB_PAGE_SIZE);
+  }
+  dm = std::make_unique<DiskManager>(db_file);
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, new_data, BUSTUB_PAGE_DATA_SIZE), 0);
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(std::memcmp(buf, old_data, BUSTUB_PAGE_DATA_SIZE), 0);
+  EXPECT_EQ(0, dm->GetNumChecksumFailures());
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, CompressionTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char ints[BUSTUB_PAGE_SIZE] = {0};
+  char noise[BUSTUB_PAGE_SIZE] = {0};
+  // half a page of small integers, and a page that does not compress
+  for (size_t i = 0; i < BUSTUB_PAGE_SIZE / 2 / sizeof(int32_t); ++i) {
+    auto value = static_cast<int32_t>(i % 10 * 7);
+    std::memcpy(ints + i * sizeof(int32_t), &value, sizeof(int32_t));
+  }
+  std::mt19937 rng(15445);
+  for (auto &byte : noise) {
+    byte = static_cast<char>(rng());
+  }
+
+  char compressed[BUSTUB_PAGE_SIZE];
+  size_t size = CompressionUtil::Compress(ints, BUSTUB_PAGE_SIZE, compressed, BUSTUB_PAGE_SIZE);
+  ASSERT_GT(size, 0);
+  EXPECT_LT(size, BUSTUB_PAGE_SIZE / 2);
+  ASSERT_TRUE(CompressionUtil::Decompress(compressed, size, buf, BUSTUB_PAGE_SIZE));
+  EXPECT_EQ(std::memcmp(buf, ints, BUSTUB_PAGE_SIZE), 0);
+  EXPECT_FALSE(CompressionUtil::Decompress(compressed, size - 1, buf, BUSTUB_PAGE_SIZE));
+  EXPECT_FALSE(CompressionUtil::Decompress(compressed, size, buf, BUSTUB_PAGE_SIZE - 1));
+  EXPECT_EQ(0, CompressionUtil::Compress(noise, BUSTUB_PAGE_SIZE, compressed, BUSTUB_PAGE_SIZE - 1));
+
+  std::string db_file("test.db");
+  auto dm = std::make_unique<DiskManager>(db_file);
+  dm->SetCompression(true);
+  dm->WritePage(0, ints);
+  dm->WritePage(1, noise);
+  dm->WritePage(2, ints);
+  EXPECT_LT(dm->GetNumBytesWritten(), 2 * BUSTUB_PAGE_SIZE);
+  auto file_size = dm->GetDbFileSize();
+  EXPECT_LT(file_size, 2 * BUSTUB_PAGE_SIZE);
+  // Page 0 grows out of its extent into a new one, and page 2 shrinks into part of the freed one.
+  dm->WritePage(0, noise);
+  EXPECT_GT(dm->GetDbFileSize(), file_size + BUSTUB_PAGE_SIZE / 2);
+  file_size = dm->GetDbFileSize();
+  std::memset(buf, 0, sizeof(buf));
+  dm->WritePage(2, buf);
+  EXPECT_EQ(file_size, dm->GetDbFileSize());
+  dm->ShutDown();
+
+  // A compressed db file stays compressed, and keeps its extent map.
+  dm = std::make_unique<DiskManager>(db_file);
+  EXPECT_TRUE(dm->IsCompressed());
+  dm->SetCompression(false);
+  EXPECT_TRUE(dm->IsCompressed());
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, noise, BUSTUB_PAGE_DATA_SIZE), 0);
+  dm->ReadPage(1, buf);
+  EXPECT_EQ(std::memcmp(buf, noise, BUSTUB_PAGE_DATA_SIZE), 0);
+  dm->ReadPage(2, buf);
+  EXPECT_TRUE(std::all_of(buf, buf + BUSTUB_PAGE_DATA_SIZE, [](char c) { return c == 0; }));
+  EXPECT_LT(dm->GetNumBytesRead(), 3 * BUSTUB_PAGE_SIZE);
+  // A page that was never written reads as zeroes.
+  std::memset(buf, 1, sizeof(buf));
+  dm->ReadPage(3, buf);
+  EXPECT_TRUE(std::all_of(buf, buf + BUSTUB_PAGE_SIZE, [](char c) { return c == 0; }));
+  // The extents freed before the restart are reused.
+  dm->WritePage(3, ints);
+  EXPECT_EQ(file_size, dm->GetDbFileSize());
+  dm->ReadPage(3, buf);
+  EXPECT_EQ(std::memcmp(buf, ints, BUSTUB_PAGE_DATA_SIZE), 0);
+
+  // Under a sync policy, an extent the map stopped pointing to is only reused after the next sync.
+  dm->SetSyncPolicy(SyncPolicy::BATCH, 100);
+  dm->WritePage(0, ints);
+  file_size = dm->GetDbFileSize();
+  dm->WritePage(4, noise);
+  EXPECT_GE(dm->GetDbFileSize(), file_size + BUSTUB_PAGE_SIZE);
+  file_size = dm->GetDbFileSize();
+  dm->SyncPages();
+  dm->WritePage(5, noise);
+  EXPECT_EQ(file_size, dm->GetDbFileSize());
+  dm->ReadPage(0, buf);
+  EXPECT_EQ(std::memcmp(buf, ints, BUSTUB_PAGE_DATA_SIZE), 0);
+  dm->ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(DiskManagerTest, DirectIoTest) {
+  char buf[BUSTUB_PAGE_SIZE + 1] = {0};
+  char data[BUSTUB_PAGE_SIZE + 1] = {0};
+  std::string db_file("test.db");
+  auto dm = DiskManager(db_file);
+  ASSERT_TRUE(dm.SetDirectIo(true));
+  EXPECT_TRUE(dm.IsDirectIo());
+  dm.SetCompression(true);
+  EXPECT_FALSE(dm.IsCompressed());
+
+  // Buffers off the alignment of direct I/O go through a bounce buffer.
+  std::strncpy(data + 1, "A test string.", BUSTUB_PAGE_SIZE);
+  dm.WritePage(0, data + 1);
+  dm.WritePage(2, data + 1);
+  dm.ReadPage(2, buf + 1);
+  EXPECT_EQ(std::memcmp(buf + 1, data + 1, BUSTUB_PAGE_DATA_SIZE), 0);
+  dm.ReadPage(3, buf + 1);  // tolerate empty read
+  EXPECT_EQ(0, dm.GetNumSyncs());
+
+  // A batch of 3 writes is synced by its last write; SyncPages() syncs what is left, if anything.
+  dm.SetSyncPolicy(SyncPolicy::BATCH, 3);
+  for (page_id_t page_id = 0; page_id < 7; ++page_id) {
+    dm.WritePage(page_id, data + 1);
+  }
+  EXPECT_EQ(2, dm.GetNumSyncs());
+  dm.SyncPages();
+  EXPECT_EQ(3, dm.GetNumSyncs());
+  dm.SyncPages();
+  EXPECT_EQ(3, dm.GetNumSyncs());
+  dm.SetSyncPolicy(SyncPolicy::EVERY_WRITE);
+  dm.WritePage(7, data + 1);
+  EXPECT_EQ(4, dm.GetNumSyncs());
+
+  // Without direct I/O the pages read the same.
+  ASSERT_TRUE(dm.SetDirectIo(false));
+  dm.ReadPage(6, buf);
+  EXPECT_EQ(std::memcmp(buf, data + 1, BUSTUB_PAGE_DATA_SIZE), 0);
+  dm.ShutDown();
+}
+
 // NOLINTNEXTLINE
 TEST_F(DiskManagerTest, ThrowBadFileTest) { EXPECT_THROW(DiskManager("dev/null\\/foo/bar/baz/test.db"), Exception); }
 
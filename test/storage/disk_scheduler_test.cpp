@@ -0,0 +1,95 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// disk_scheduler_test.cpp
+//
+// Identification: test/storage/disk_scheduler_test.cpp
+//
+// Copyright (c) 2015-2023, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <cstring>
+#include <future>  // NOLINT
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "common/exception.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/disk/disk_scheduler.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(DiskSchedulerTest, ScheduleWriteReadPageTest) {
+  char buf[BUSTUB_PAGE_SIZE] = {0};
+  char data[BUSTUB_PAGE_SIZE] = {0};
+
+  auto dm = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto disk_scheduler = std::make_unique<DiskScheduler>(dm.get());
+
+  std::strncpy(data, "A test string.", sizeof(data));
+
+  auto promise1 = disk_scheduler->CreatePromise();
+  auto future1 = promise1.get_future();
+  auto promise2 = disk_scheduler->CreatePromise();
+  auto future2 = promise2.get_future();
+
+  disk_scheduler->Schedule({/*is_write=*/true, data, /*page_id=*/0, std::move(promise1)});
+  ASSERT_TRUE(future1.get());
+  disk_scheduler->Schedule({/*is_write=*/false, buf, /*page_id=*/0, std::move(promise2)});
+  ASSERT_TRUE(future2.get());
+
+  ASSERT_EQ(std::memcmp(buf, data, sizeof(buf)), 0);
+}
+
+// NOLINTNEXTLINE
+TEST(DiskSchedulerTest, ConcurrentRequestsTest) {
+  const int num_pages = 64;
+  remove("test.db");
+  remove("test.log");
+  auto dm = std::make_unique<DiskManager>("test.db");
+
+  // Scenario: many writes to distinct pages are in flight at once, and all of them reach the file.
+  std::vector<std::unique_ptr<char[]>> pages;
+  std::vector<std::future<bool>> futures;
+  {
+    DiskScheduler disk_scheduler(dm.get(), 8);
+    for (int i = 0; i < num_pages; ++i) {
+      pages.emplace_back(new char[BUSTUB_PAGE_SIZE]);
+      std::memset(pages.back().get(), 'a' + i % 26, BUSTUB_PAGE_SIZE);
+      auto promise = disk_scheduler.CreatePromise();
+      futures.push_back(promise.get_future());
+      disk_scheduler.Schedule({/*is_write=*/true, pages.back().get(), i, std::move(promise)});
+    }
+    // Scenario: destroying the scheduler drains the queue before the workers exit.
+  }
+  for (auto &future : futures) {
+    ASSERT_TRUE(future.get());
+  }
+  EXPECT_EQ(num_pages, dm->GetNumWrites());
+
+  // The blocking DiskManager API sees everything the scheduler wrote.
+  char buf[BUSTUB_PAGE_SIZE];
+  for (int i = 0; i < num_pages; ++i) {
+    dm->ReadPage(i, buf);
+    EXPECT_EQ(0, std::memcmp(buf, pages[i].get(), BUSTUB_PAGE_DATA_SIZE));
+  }
+
+  // Reading past the end of the file yields a zeroed page.
+  std::memset(buf, 1, BUSTUB_PAGE_SIZE);
+  dm->ReadPage(num_pages + 10, buf);
+  for (char c : buf) {
+    ASSERT_EQ(0, c);
+  }
+
+  dm->ShutDown();
+  remove("test.db");
+  remove("test.log");
+}
+
+}  // namespace bustub
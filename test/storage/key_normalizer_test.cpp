@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// key_normalizer_test.cpp
+//
+// Identification: test/storage/key_normalizer_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "catalog/catalog.h"
+#include "common/bustub_instance.h"
+#include "common/exception.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/index/key_normalizer.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(KeyNormalizerTest, OrderTest) {
+  Schema key_schema({Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 16}, Column{"c", TypeId::DECIMAL}});
+  GenericComparator<32> comparator(&key_schema, true);
+
+  // in key order
+  std::vector<std::vector<Value>> rows = {
+      {ValueFactory::GetIntegerValue(-70000), ValueFactory::GetVarcharValue("b"), ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetNullValueByType(TypeId::VARCHAR),
+       ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue(""), ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue("a"), ValueFactory::GetDecimalValue(-2.5)},
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue("a"), ValueFactory::GetDecimalValue(-0.5)},
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue("a"), ValueFactory::GetDecimalValue(1.5)},
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue("ab"), ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(-1), ValueFactory::GetVarcharValue("b"), ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(0), ValueFactory::GetVarcharValue("a"), ValueFactory::GetDecimalValue(0)},
+      {ValueFactory::GetIntegerValue(256), ValueFactory::GetVarcharValue("a"), ValueFactory::GetDecimalValue(0)},
+  };
+  std::vector<GenericKey<32>> keys(rows.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    keys[i].SetFromKey(Tuple(rows[i], &key_schema), key_schema);
+  }
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    for (size_t j = 0; j < keys.size(); j++) {
+      EXPECT_EQ(comparator(keys[i], keys[j]), i < j ? -1 : (i == j ? 0 : 1)) << i << " " << j;
+    }
+  }
+
+  // a NULL integer sorts first
+  Schema int_schema({Column{"a", TypeId::INTEGER}});
+  GenericKey<4> null_key;
+  GenericKey<4> min_key;
+  null_key.SetFromKey(Tuple({ValueFactory::GetNullValueByType(TypeId::INTEGER)}, &int_schema), int_schema);
+  min_key.SetFromKey(Tuple({ValueFactory::GetIntegerValue(BUSTUB_INT32_MIN)}, &int_schema), int_schema);
+  EXPECT_LT(GenericComparator<4>(&int_schema, true)(null_key, min_key), 0);
+}
+
+// NOLINTNEXTLINE
+TEST(KeyNormalizerTest, TooLongTest) {
+  Schema key_schema({Column{"a", TypeId::BIGINT}, Column{"b", TypeId::VARCHAR, 32}});
+  EXPECT_EQ(KeyNormalizer::GetNormalizedSize(key_schema), 8 + 32 + 2);
+
+  GenericKey<16> key;
+  key.SetFromKey(Tuple({ValueFactory::GetBigIntValue(1), ValueFactory::GetVarcharValue("short")}, &key_schema),
+                 key_schema);
+  EXPECT_THROW(key.SetFromKey(Tuple({ValueFactory::GetBigIntValue(1), ValueFactory::GetVarcharValue("a long string")},
+                                    &key_schema),
+                              key_schema),
+               Exception);
+}
+
+// NOLINTNEXTLINE
+TEST(KeyNormalizerTest, KeyTypeTooSmallTest) {
+  auto bustub = std::make_unique<BustubInstance>();
+  auto *catalog = bustub->catalog_;
+  auto txn = std::make_unique<Transaction>(0);
+  Schema schema({Column{"a", TypeId::BIGINT}});
+  catalog->CreateTable(txn.get(), "t", schema);
+
+  // 8 bytes of BIGINT and 8 bytes of RID do not fit in 8 bytes
+  auto *index = catalog->CreateIndex<GenericKey<8>, RID, GenericComparator<8>>(
+      txn.get(), "t_a", "t", schema, schema, {0}, 8, HashFunction<GenericKey<8>>{});
+  EXPECT_EQ(index, Catalog::NULL_INDEX_INFO);
+  index = catalog->CreateIndex<GenericKey<16>, RID, GenericComparator<16>>(txn.get(), "t_a", "t", schema, schema, {0},
+                                                                           16, HashFunction<GenericKey<16>>{});
+  EXPECT_NE(index, Catalog::NULL_INDEX_INFO);
+}
+
+// NOLINTNEXTLINE
+TEST(KeyNormalizerTest, CompositeIndexTest) {
+  auto bustub = std::make_unique<BustubInstance>();
+  auto noop_writer = NoopWriter();
+  bustub->ExecuteSql("CREATE TABLE t (a int, b varchar(8), c int);", noop_writer);
+  bustub->ExecuteSql("INSERT INTO t VALUES (2, 'x', 1), (1, 'y', 2), (2, 'a', 3), (-1, 'z', 4), (1, 'b', 5);",
+                     noop_writer);
+  bustub->ExecuteSql("CREATE INDEX t_ab ON t(a, b);", noop_writer);
+  bustub->ExecuteSql("INSERT INTO t VALUES (1, 'a', 6);", noop_writer);
+
+  std::stringstream plan;
+  auto plan_writer = SimpleStreamWriter(plan, true);
+  bustub->ExecuteSql("EXPLAIN SELECT a, b, c FROM t ORDER BY a, b;", plan_writer);
+  EXPECT_NE(plan.str().find("IndexScan"), std::string::npos) << plan.str();
+
+  std::stringstream result;
+  auto writer = SimpleStreamWriter(result, true, " ");
+  bustub->ExecuteSql("SELECT a, b, c FROM t ORDER BY a, b;", writer);
+  EXPECT_EQ(result.str(), "-1 z 4 \n1 a 6 \n1 b 5 \n1 y 2 \n2 a 3 \n2 x 1 \n");
+}
+
+}  // namespace bustub
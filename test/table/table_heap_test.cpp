@@ -0,0 +1,514 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// table_heap_test.cpp
+//
+// Identification: test/table/table_heap_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/transaction.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/overflow_page.h"
+#include "storage/table/table_heap.h"
+#include "storage/table/tuple.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+auto MakeTuple(const Schema &schema, int32_t id) -> Tuple {
+  std::vector<Value> values{ValueFactory::GetIntegerValue(id), ValueFactory::GetVarcharValue(std::string(200, 'x'))};
+  return {values, &schema};
+}
+
+auto CountTuples(TableHeap *table, Transaction *txn) -> size_t {
+  size_t count = 0;
+  for (auto it = table->Begin(txn); it != table->End(); ++it) {
+    ++count;
+  }
+  return count;
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, FreeSpaceReuseTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 200}}};
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  Transaction txn(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, &txn);
+
+  // Fill many more pages than fit in the buffer pool. Without a free space map, every insert would fetch them all.
+  const int num_tuples = 2000 * BUSTUB_PAGE_SIZE / 4096;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; ++i) {
+    ASSERT_TRUE(table->InsertTuple(MakeTuple(schema, i), &rids[i], &txn));
+  }
+  auto num_pages = table->GetNumPages();
+  ASSERT_GT(num_pages, 100);
+
+  // Free one page in the middle of the table: new tuples must fill it up again before a page is appended.
+  auto freed_page_id = rids[num_tuples / 2].GetPageId();
+  size_t num_freed = 0;
+  for (const auto &rid : rids) {
+    if (rid.GetPageId() == freed_page_id) {
+      ASSERT_TRUE(table->MarkDelete(rid, &txn));
+      table->ApplyDelete(rid, &txn);
+      ++num_freed;
+    }
+  }
+  size_t num_reused = 0;
+  int num_inserted = 0;
+  while (table->GetNumPages() == num_pages) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(MakeTuple(schema, num_tuples + num_inserted), &rid, &txn));
+    num_reused += rid.GetPageId() == freed_page_id ? 1 : 0;
+    ++num_inserted;
+  }
+  ASSERT_EQ(num_freed, num_reused);
+  ASSERT_EQ(num_tuples - num_freed + num_inserted, CountTuples(table, &txn));
+  num_pages = table->GetNumPages();
+
+  // Reopen the table, with the persisted map and with a rebuilt one. The last page, just appended, still has room.
+  auto first_page_id = table->GetFirstPageId();
+  auto free_space_map_page_id = table->GetFreeSpaceMapPageId();
+  delete table;
+  for (auto map_page_id : {free_space_map_page_id, INVALID_PAGE_ID}) {
+    TableHeap reopened(bpm, nullptr, nullptr, first_page_id, map_page_id);
+    ASSERT_EQ(num_pages, reopened.GetNumPages());
+    RID rid;
+    ASSERT_TRUE(reopened.InsertTuple(MakeTuple(schema, -1), &rid, &txn));
+    ASSERT_EQ(num_pages, reopened.GetNumPages());
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, BulkInsertTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 200}}};
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  Transaction txn(0);
+  TableHeap table(bpm, nullptr, nullptr, &txn);
+
+  RID first_rid;
+  ASSERT_TRUE(table.InsertTuple(MakeTuple(schema, 0), &first_rid, &txn));
+  const int num_tuples = 1000;
+  std::vector<Tuple> tuples;
+  for (int i = 1; i <= num_tuples; ++i) {
+    tuples.push_back(MakeTuple(schema, i));
+  }
+  std::vector<RID> rids{first_rid};
+  ASSERT_TRUE(table.BulkInsertTuples(tuples, &rids, &txn));
+  ASSERT_EQ(num_tuples + 1, rids.size());
+  ASSERT_EQ(num_tuples + 1, txn.GetWriteSet()->size());
+
+  // The tuples are packed into fresh pages after the first one, in order.
+  for (int i = 1; i <= num_tuples; ++i) {
+    ASSERT_NE(first_rid.GetPageId(), rids[i].GetPageId());
+    Tuple tuple;
+    ASSERT_TRUE(table.GetTuple(rids[i], &tuple, &txn));
+    ASSERT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  int expected = 0;
+  for (auto it = table.Begin(&txn); it != table.End(); ++it) {
+    ASSERT_EQ(expected++, it->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  ASSERT_EQ(num_tuples + 1, expected);
+
+  // The space left on the first page and on the last bulk page is known to the free space map.
+  auto num_pages = table.GetNumPages();
+  RID rid;
+  ASSERT_TRUE(table.InsertTuple(MakeTuple(schema, -1), &rid, &txn));
+  ASSERT_EQ(num_pages, table.GetNumPages());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ConcurrentInsertTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 200}}};
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  Transaction txn(0);
+  TableHeap table(bpm, nullptr, nullptr, &txn);
+
+  const int num_threads = 8;
+  const int tuples_per_thread = 500;
+  std::vector<std::vector<RID>> rids(num_threads);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      Transaction thread_txn(tid + 1);
+      for (int i = 0; i < tuples_per_thread; ++i) {
+        RID rid;
+        ASSERT_TRUE(table.InsertTuple(MakeTuple(schema, tid * tuples_per_thread + i), &rid, &thread_txn));
+        rids[tid].push_back(rid);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  // Every tuple got its own slot, and every tuple is reachable through the page list.
+  std::unordered_set<RID> all_rids;
+  for (const auto &thread_rids : rids) {
+    all_rids.insert(thread_rids.begin(), thread_rids.end());
+  }
+  ASSERT_EQ(num_threads * tuples_per_thread, all_rids.size());
+  ASSERT_EQ(num_threads * tuples_per_thread, CountTuples(&table, &txn));
+  for (int tid = 0; tid < num_threads; ++tid) {
+    for (int i = 0; i < tuples_per_thread; ++i) {
+      Tuple tuple;
+      ASSERT_TRUE(table.GetTuple(rids[tid][i], &tuple, &txn));
+      ASSERT_EQ(tid * tuples_per_thread + i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    }
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, VacuumTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 200}}};
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  Transaction txn(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, &txn);
+
+  const int num_tuples = 2000 * BUSTUB_PAGE_SIZE / 4096;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; ++i) {
+    ASSERT_TRUE(table->InsertTuple(MakeTuple(schema, i), &rids[i], &txn));
+  }
+  auto num_pages = table->GetNumPages();
+  // Nothing to reclaim yet.
+  ASSERT_EQ(0, table->Vacuum());
+  ASSERT_EQ(num_pages, table->GetNumPages());
+
+  // Empty the pages of the second quarter entirely, and drop the last tuples of the first page.
+  std::unordered_set<page_id_t> emptied_page_ids;
+  for (int i = num_tuples / 4; i < num_tuples / 2; ++i) {
+    emptied_page_ids.insert(rids[i].GetPageId());
+  }
+  emptied_page_ids.erase(rids[num_tuples / 4 - 1].GetPageId());
+  emptied_page_ids.erase(rids[num_tuples / 2].GetPageId());
+  ASSERT_GT(emptied_page_ids.size(), 10);
+  std::vector<int> kept;
+  size_t first_page_freed = 0;
+  for (int i = 0; i < num_tuples; ++i) {
+    bool on_first_page = rids[i].GetPageId() == rids[0].GetPageId();
+    bool on_first_page_tail = on_first_page && i + 1 < num_tuples && rids[i + 1].GetPageId() != rids[0].GetPageId();
+    if (emptied_page_ids.count(rids[i].GetPageId()) > 0 || on_first_page_tail) {
+      ASSERT_TRUE(table->MarkDelete(rids[i], &txn));
+      table->ApplyDelete(rids[i], &txn);
+      first_page_freed += on_first_page_tail ? TablePage::SIZE_TUPLE : 0;
+    } else {
+      kept.push_back(i);
+    }
+  }
+  ASSERT_EQ(TablePage::SIZE_TUPLE, first_page_freed);
+
+  // The empty pages are given back, and the trailing slot of the first page is dropped.
+  ASSERT_EQ(emptied_page_ids.size() * BUSTUB_PAGE_SIZE + first_page_freed, table->Vacuum());
+  ASSERT_EQ(num_pages - emptied_page_ids.size(), table->GetNumPages());
+  ASSERT_EQ(0, table->Vacuum());
+  int index = 0;
+  for (auto it = table->Begin(&txn); it != table->End(); ++it) {
+    ASSERT_EQ(kept[index++], it->GetValue(&schema, 0).GetAs<int32_t>());
+  }
+  ASSERT_EQ(kept.size(), index);
+  for (auto i : kept) {
+    Tuple tuple;
+    ASSERT_TRUE(table->GetTuple(rids[i], &tuple, &txn));
+    ASSERT_EQ(i, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+  }
+
+  // New tuples go to the pages left, then to new pages, which reuse the removed pages on disk.
+  for (int i = 0; i < num_tuples / 4; ++i) {
+    RID rid;
+    ASSERT_TRUE(table->InsertTuple(MakeTuple(schema, num_tuples + i), &rid, &txn));
+  }
+  ASSERT_GT(disk_manager->GetNumReusedPages(), 0);
+  ASSERT_EQ(kept.size() + num_tuples / 4, CountTuples(table, &txn));
+
+  // The page list and the free space map survive a reopen.
+  num_pages = table->GetNumPages();
+  auto first_page_id = table->GetFirstPageId();
+  auto free_space_map_page_id = table->GetFreeSpaceMapPageId();
+  delete table;
+  TableHeap reopened(bpm, nullptr, nullptr, first_page_id, free_space_map_page_id);
+  ASSERT_EQ(num_pages, reopened.GetNumPages());
+  ASSERT_EQ(kept.size() + num_tuples / 4, CountTuples(&reopened, &txn));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, DeferredFreeTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 3 * BUSTUB_PAGE_SIZE}}};
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  Transaction txn(0);
+  TableHeap table(bpm, nullptr, nullptr, &txn, &schema);
+
+  // Fill a few pages, each tuple keeping one value out of line.
+  const int num_tuples = 200;
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; ++i) {
+    auto value = std::string(i == 0 ? 3 * BUSTUB_PAGE_SIZE : 500, 'x');
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(value)};
+    ASSERT_TRUE(table.InsertTuple(Tuple(values, &schema), &rids[i], &txn));
+  }
+  ASSERT_GT(table.GetNumPages(), 3);
+  auto middle_page_id = rids[num_tuples / 2].GetPageId();
+  ASSERT_NE(middle_page_id, rids[0].GetPageId());
+  ASSERT_NE(middle_page_id, rids[num_tuples - 1].GetPageId());
+
+  // Pin a middle page and the overflow chain of the first tuple, then delete what is on them.
+  page_id_t chain_page_id;
+  {
+    Tuple first;
+    ASSERT_TRUE(table.GetTuple(rids[0], &first, &txn));
+    ASSERT_TRUE(first.IsOutOfLine(&schema, 1));
+    // The stub of an out-of-line value is its length, then the id of the first page of its chain.
+    auto stub_offset = *reinterpret_cast<const uint32_t *>(first.GetData() + schema.GetColumn(1).GetOffset());
+    chain_page_id = *reinterpret_cast<const page_id_t *>(first.GetData() + stub_offset + sizeof(uint32_t));
+  }
+  ASSERT_NE(nullptr, bpm->FetchPage(chain_page_id));
+  ASSERT_NE(nullptr, bpm->FetchPage(middle_page_id));
+  auto num_free_pages = disk_manager->GetNumFreePages();
+  size_t num_deleted = 0;
+  for (int i = 0; i < num_tuples; ++i) {
+    if (i == 0 || rids[i].GetPageId() == middle_page_id) {
+      ASSERT_TRUE(table.MarkDelete(rids[i], &txn));
+      table.ApplyDelete(rids[i], &txn);
+      ++num_deleted;
+    }
+  }
+
+  // The pinned pages are unlinked, but only deleted once the pins are gone and another vacuum runs.
+  auto num_pages = table.GetNumPages();
+  ASSERT_GE(table.Vacuum(), BUSTUB_PAGE_SIZE);
+  ASSERT_EQ(num_pages - 1, table.GetNumPages());
+  auto num_unpinned_free_pages = disk_manager->GetNumFreePages() - num_free_pages;
+  ASSERT_TRUE(bpm->UnpinPage(middle_page_id, false));
+  ASSERT_TRUE(bpm->UnpinPage(chain_page_id, false));
+  table.Vacuum();
+  ASSERT_EQ(num_unpinned_free_pages + 2, disk_manager->GetNumFreePages() - num_free_pages);
+  ASSERT_EQ(num_tuples - num_deleted, CountTuples(&table, &txn));
+  ASSERT_EQ(0, table.GetNumDeferredPages());
+
+  // A deferred page that was deleted behind the table's back can never be deleted again, so it is not retried.
+  auto other_page_id = rids[num_tuples / 4].GetPageId();
+  ASSERT_NE(other_page_id, rids[0].GetPageId());
+  ASSERT_NE(other_page_id, middle_page_id);
+  ASSERT_NE(other_page_id, rids[num_tuples - 1].GetPageId());
+  ASSERT_NE(nullptr, bpm->FetchPage(other_page_id));
+  for (int i = 0; i < num_tuples; ++i) {
+    if (rids[i].GetPageId() == other_page_id) {
+      ASSERT_TRUE(table.MarkDelete(rids[i], &txn));
+      table.ApplyDelete(rids[i], &txn);
+    }
+  }
+  table.Vacuum();
+  ASSERT_EQ(1, table.GetNumDeferredPages());
+  ASSERT_TRUE(bpm->UnpinPage(other_page_id, false));
+  ASSERT_TRUE(bpm->DeletePage(other_page_id));
+  num_free_pages = disk_manager->GetNumFreePages();
+  table.Vacuum();
+  ASSERT_EQ(0, table.GetNumDeferredPages());
+  ASSERT_EQ(num_free_pages, disk_manager->GetNumFreePages());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, ConcurrentVacuumTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 200}}};
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(64, disk_manager);
+  Transaction txn(0);
+  TableHeap table(bpm, nullptr, nullptr, &txn);
+
+  // Every thread inserts batches of tuples and deletes most of them again, while a vacuum runs alongside.
+  const int num_threads = 4;
+  const int num_rounds = 10;
+  const int tuples_per_round = 100;
+  std::atomic<bool> done{false};
+  std::thread vacuum([&] {
+    while (!done) {
+      table.Vacuum();
+    }
+  });
+  std::vector<std::vector<RID>> kept_rids(num_threads);
+  std::vector<std::thread> threads;
+  for (int tid = 0; tid < num_threads; ++tid) {
+    threads.emplace_back([&, tid] {
+      Transaction thread_txn(tid + 1);
+      for (int round = 0; round < num_rounds; ++round) {
+        std::vector<RID> rids(tuples_per_round);
+        for (int i = 0; i < tuples_per_round; ++i) {
+          ASSERT_TRUE(table.InsertTuple(MakeTuple(schema, tid), &rids[i], &thread_txn));
+        }
+        for (int i = 1; i < tuples_per_round; ++i) {
+          ASSERT_TRUE(table.MarkDelete(rids[i], &thread_txn));
+          table.ApplyDelete(rids[i], &thread_txn);
+        }
+        kept_rids[tid].push_back(rids[0]);
+        CountTuples(&table, &thread_txn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  done = true;
+  vacuum.join();
+
+  // The kept tuples are all there, and once vacuumed, the table is down to a few pages.
+  table.Vacuum();
+  ASSERT_EQ(num_threads * num_rounds, CountTuples(&table, &txn));
+  for (int tid = 0; tid < num_threads; ++tid) {
+    for (const auto &rid : kept_rids[tid]) {
+      Tuple tuple;
+      ASSERT_TRUE(table.GetTuple(rid, &tuple, &txn));
+      ASSERT_EQ(tid, tuple.GetValue(&schema, 0).GetAs<int32_t>());
+    }
+  }
+  ASSERT_LE(table.GetNumPages(), num_threads * num_rounds);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, OutOfLineValueTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 3 * BUSTUB_PAGE_SIZE},
+                 Column{"c", TypeId::VARCHAR, 200}}};
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  Transaction txn(0);
+  auto *table = new TableHeap(bpm, nullptr, nullptr, &txn, &schema);
+
+  // Each tuple is larger than a page, so it can only be stored with its large value out of line.
+  const int num_tuples = 20;
+  auto large_value = [](int i) { return std::string(3 * BUSTUB_PAGE_SIZE, static_cast<char>('a' + i % 26)); };
+  std::vector<RID> rids(num_tuples);
+  for (int i = 0; i < num_tuples; ++i) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(large_value(i)),
+                              ValueFactory::GetVarcharValue(std::string(100, 'x'))};
+    ASSERT_TRUE(table->InsertTuple(Tuple(values, &schema), &rids[i], &txn));
+  }
+  ASSERT_EQ(table->GetNumPages(), 1);
+
+  // A scan that reads only the small columns fetches no more pages than one that reads nothing.
+  auto scan = [&](const std::vector<uint32_t> &column_idxs) {
+    auto num_fetches = bpm->GetFetchHits() + bpm->GetFetchMisses();
+    int i = 0;
+    for (auto it = table->Begin(&txn); it != table->End(); ++it, ++i) {
+      for (auto col_idx : column_idxs) {
+        auto value = it->GetValue(&schema, col_idx);
+        if (col_idx == 0) {
+          EXPECT_EQ(value.GetAs<int32_t>(), i);
+        } else if (col_idx == 1) {
+          EXPECT_EQ(value.ToString(), large_value(i));
+        }
+      }
+      EXPECT_TRUE(it->IsOutOfLine(&schema, 1));
+      EXPECT_FALSE(it->IsOutOfLine(&schema, 2));
+      EXPECT_FALSE(it->IsNull(&schema, 1));
+    }
+    EXPECT_EQ(i, num_tuples);
+    return bpm->GetFetchHits() + bpm->GetFetchMisses() - num_fetches;
+  };
+  auto baseline = scan({});
+  ASSERT_EQ(scan({0, 2}), baseline);
+  ASSERT_GT(scan({0, 1, 2}), baseline);
+
+  // Deleting the tuples gives their overflow pages back.
+  auto pages_per_value = (3 * BUSTUB_PAGE_SIZE + 1 + OverflowPage::OVERFLOW_PAGE_CAPACITY - 1) /
+                         OverflowPage::OVERFLOW_PAGE_CAPACITY;
+  auto num_free_pages = disk_manager->GetNumFreePages();
+  for (const auto &rid : rids) {
+    ASSERT_TRUE(table->MarkDelete(rid, &txn));
+    table->ApplyDelete(rid, &txn);
+  }
+  ASSERT_EQ(disk_manager->GetNumFreePages() - num_free_pages, static_cast<size_t>(num_tuples * pages_per_value));
+
+  delete table;
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(TableHeapTest, RetiredOverflowPagesTest) {
+  Schema schema{{Column{"a", TypeId::INTEGER}, Column{"b", TypeId::VARCHAR, 3 * BUSTUB_PAGE_SIZE}}};
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(16, disk_manager);
+  Transaction txn(0);
+  TableHeap table(bpm, nullptr, nullptr, &txn, &schema);
+
+  auto large_value = [](char c) { return std::string(3 * BUSTUB_PAGE_SIZE, c); };
+  auto insert = [&](char c) {
+    RID rid;
+    std::vector<Value> values{ValueFactory::GetIntegerValue(c), ValueFactory::GetVarcharValue(large_value(c))};
+    EXPECT_TRUE(table.InsertTuple(Tuple(values, &schema), &rid, &txn));
+    return rid;
+  };
+  auto rid = insert('a');
+
+  // A copy of the tuple outlives its delete, like a row buffered by a sort that reads uncommitted data.
+  auto copy = std::make_unique<Tuple>();
+  {
+    Tuple tuple;
+    ASSERT_TRUE(table.GetTuple(rid, &tuple, &txn));
+    *copy = tuple;
+  }
+  auto num_free_pages = disk_manager->GetNumFreePages();
+  ASSERT_TRUE(table.MarkDelete(rid, &txn));
+  table.ApplyDelete(rid, &txn);
+  ASSERT_EQ(num_free_pages, disk_manager->GetNumFreePages());
+
+  // New values would reuse the pages of the chain had it been freed; the copy still reads its own value.
+  for (char c = 'b'; c < 'f'; ++c) {
+    insert(c);
+  }
+  table.Vacuum();
+  ASSERT_EQ(num_free_pages, disk_manager->GetNumFreePages());
+  ASSERT_EQ(large_value('a'), copy->GetValue(&schema, 1).ToString());
+
+  // Once the copy is gone, the next vacuum deletes the chain.
+  auto pages_per_value = (3 * BUSTUB_PAGE_SIZE + 1 + OverflowPage::OVERFLOW_PAGE_CAPACITY - 1) /
+                         OverflowPage::OVERFLOW_PAGE_CAPACITY;
+  copy.reset();
+  table.Vacuum();
+  ASSERT_EQ(num_free_pages + pages_per_value, disk_manager->GetNumFreePages());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
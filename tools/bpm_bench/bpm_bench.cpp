@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <memory>
@@ -12,16 +13,24 @@
 
 #include "argparse/argparse.hpp"
 #include "binder/binder.h"
+#include "buffer/buffer_access_strategy.h"
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "buffer/lru_k_replacer.h"
+#include "buffer/parallel_buffer_pool_manager.h"
 #include "common/config.h"
 #include "common/exception.h"
+#include "common/util/checksum_util.h"
 #include "common/util/string_util.h"
 #include "fmt/core.h"
 #include "fmt/std.h"
 #include "storage/disk/disk_manager_memory.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 auto ClockMs() -> uint64_t {
   struct timeval tm;
@@ -31,13 +40,15 @@ auto ClockMs() -> uint64_t {
 
 static const size_t BUSTUB_SCAN_THREAD = 8;
 static const size_t BUSTUB_GET_THREAD = 8;
-static const size_t LRU_K_SIZE = 16;
+static size_t lru_k_size = 16;
 static const size_t BUSTUB_PAGE_CNT = 6400;
 static const size_t BUSTUB_BPM_SIZE = 64;
 
 struct BpmTotalMetrics {
   uint64_t scan_cnt_{0};
   uint64_t get_cnt_{0};
+  uint64_t scan_hits_{0};
+  uint64_t scan_misses_{0};
   uint64_t start_time_{0};
   std::mutex mutex_;
 
@@ -48,20 +59,43 @@ struct BpmTotalMetrics {
     scan_cnt_ += scan_cnt;
   }
 
+  void ReportScanHits(uint64_t hits, uint64_t misses) {
+    std::unique_lock<std::mutex> l(mutex_);
+    scan_hits_ += hits;
+    scan_misses_ += misses;
+  }
+
   void ReportGet(uint64_t get_cnt) {
     std::unique_lock<std::mutex> l(mutex_);
     get_cnt_ += get_cnt;
   }
 
-  void Report() {
+  /**
+   * @param hits fetch hits of the whole buffer pool
+   * @param misses fetch misses of the whole buffer pool
+   */
+  void Report(size_t shards, size_t scan_ring, const std::string &frame_memory, uint64_t hits, uint64_t misses) {
     auto now = ClockMs();
     auto elsped = now - start_time_;
     auto scan_per_sec = scan_cnt_ / static_cast<double>(elsped) * 1000;
     auto get_per_sec = get_cnt_ / static_cast<double>(elsped) * 1000;
+    // Without a ring the scans do not count their own hits; everything is attributed to the gets then, so only report
+    // the split when it is known.
+    auto hit_rate = [](uint64_t hits, uint64_t misses) {
+      return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(hits + misses);
+    };
 
     fmt::print("<<< BEGIN\n");
+    fmt::print("shards: {}\n", shards);
+    fmt::print("scan_ring: {}\n", scan_ring);
+    fmt::print("frame_memory: {}\n", frame_memory);
     fmt::print("scan: {}\n", scan_per_sec);
     fmt::print("get: {}\n", get_per_sec);
+    fmt::print("hit_rate: {:.4f}\n", hit_rate(hits, misses));
+    if (scan_ring > 0) {
+      fmt::print("scan_hit_rate: {:.4f}\n", hit_rate(scan_hits_, scan_misses_));
+      fmt::print("get_hit_rate: {:.4f}\n", hit_rate(hits - scan_hits_, misses - scan_misses_));
+    }
     fmt::print(">>> END\n");
   }
 };
@@ -100,43 +134,128 @@ struct BpmMetrics {
   }
 };
 
-// NOLINTNEXTLINE
-auto main(int argc, char **argv) -> int {
-  using bustub::AccessType;
-  using bustub::BufferPoolManager;
-  using bustub::DiskManagerUnlimitedMemory;
-  using bustub::page_id_t;
+/**
+ * Build the buffer pool under test. A single shard uses a plain BufferPoolManagerInstance so that the numbers stay
+ * comparable with the unsharded pool; more shards split the same total number of frames across a
+ * ParallelBufferPoolManager.
+ */
+auto MakeBufferPool(size_t shards, size_t pool_size, bustub::DiskManager *disk_manager)
+    -> std::unique_ptr<bustub::BufferPoolManager> {
+  if (shards <= 1) {
+    return std::make_unique<bustub::BufferPoolManagerInstance>(pool_size, disk_manager, lru_k_size);
+  }
+  size_t frames_per_shard = std::max<size_t>(1, pool_size / shards);
+  return std::make_unique<bustub::ParallelBufferPoolManager>(shards, frames_per_shard, disk_manager, lru_k_size);
+}
 
-  argparse::ArgumentParser program("bustub-bpm-bench");
-  program.add_argument("--duration").help("run bpm bench for n milliseconds");
-  program.add_argument("--latency").help("set disk latency to n milliseconds");
+/** Return the kind of memory the frames of a buffer pool built by MakeBufferPool() ended up in. */
+auto GetFrameMemory(bustub::BufferPoolManager *bpm) -> std::string {
+  auto *instance = dynamic_cast<bustub::BufferPoolManagerInstance *>(bpm);
+  if (instance == nullptr) {
+    instance = dynamic_cast<bustub::ParallelBufferPoolManager *>(bpm)->GetBufferPoolManager(0);
+  }
+  switch (instance->GetFrameMemory()) {
+    case bustub::FrameMemory::HEAP:
+      return "heap";
+    case bustub::FrameMemory::MMAP:
+      return "mmap";
+    case bustub::FrameMemory::TRANSPARENT_HUGE_PAGES:
+      return "thp";
+    case bustub::FrameMemory::EXPLICIT_HUGE_PAGES:
+      return "hugetlb";
+  }
+  return "unknown";
+}
 
-  try {
-    program.parse_args(argc, argv);
-  } catch (const std::runtime_error &err) {
-    std::cerr << err.what() << std::endl;
-    std::cerr << program;
-    return 1;
+/** Read the fetch hit and miss counters of a buffer pool built by MakeBufferPool(). */
+void GetFetchCounters(bustub::BufferPoolManager *bpm, uint64_t *hits, uint64_t *misses) {
+  if (auto *instance = dynamic_cast<bustub::BufferPoolManagerInstance *>(bpm); instance != nullptr) {
+    *hits = instance->GetFetchHits();
+    *misses = instance->GetFetchMisses();
+  } else {
+    auto *parallel = dynamic_cast<bustub::ParallelBufferPoolManager *>(bpm);
+    *hits = parallel->GetFetchHits();
+    *misses = parallel->GetFetchMisses();
   }
+}
 
-  uint64_t duration_ms = 30000;
-  if (program.present("--duration")) {
-    duration_ms = std::stoi(program.get("--duration"));
+/** How the bench stores its pages. */
+struct DiskOptions {
+  /** db file to put the pages in; empty to keep them in memory */
+  std::string db_file_;
+  bool checksums_{false};
+  bool direct_io_{false};
+  bustub::SyncPolicy sync_policy_{bustub::SyncPolicy::NEVER};
+  size_t sync_batch_size_{1};
+};
+
+/** Remove a db file and the files next to it. */
+void RemoveDbFile(const std::string &db_file) {
+  auto stem = db_file.substr(0, db_file.rfind('.'));
+  for (const auto *suffix : {".log", ".free", ".ext"}) {
+    remove((stem + suffix).c_str());
   }
+  remove(db_file.c_str());
+}
 
-  uint64_t latency_ms = 0;
-  if (program.present("--latency")) {
-    latency_ms = std::stoi(program.get("--latency"));
+/** @return the number of bytes of a file that sit in the OS page cache */
+auto GetCachedBytes(const std::string &file) -> size_t {
+  int fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+  size_t cached = 0;
+  off_t size = lseek(fd, 0, SEEK_END);
+  void *region = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+  if (region != MAP_FAILED) {
+    size_t os_page_size = sysconf(_SC_PAGESIZE);
+    std::vector<unsigned char> resident((size + os_page_size - 1) / os_page_size);
+    if (mincore(region, size, resident.data()) == 0) {
+      cached = std::count_if(resident.begin(), resident.end(), [](auto r) { return (r & 1) != 0; }) * os_page_size;
+    }
+    munmap(region, size);
   }
+  close(fd);
+  return cached;
+}
+
+void RunBench(size_t shards, size_t pool_size, size_t page_cnt, uint64_t duration_ms, uint64_t latency_ms,
+              size_t prefetch_depth, size_t scan_ring, const DiskOptions &disk) {
+  using bustub::DiskManagerUnlimitedMemory;
+  using bustub::page_id_t;
 
-  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
-  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+  std::unique_ptr<bustub::DiskManager> disk_manager;
+  DiskManagerUnlimitedMemory *memory_disk_manager = nullptr;
+  if (disk.db_file_.empty()) {
+    auto memory = std::make_unique<DiskManagerUnlimitedMemory>();
+    memory_disk_manager = memory.get();
+    disk_manager = std::move(memory);
+  } else {
+    RemoveDbFile(disk.db_file_);
+    disk_manager = std::make_unique<bustub::DiskManager>(disk.db_file_);
+    if (disk.direct_io_ && !disk_manager->SetDirectIo(true)) {
+      throw std::runtime_error("direct I/O is not supported for " + disk.db_file_);
+    }
+    disk_manager->SetSyncPolicy(disk.sync_policy_, disk.sync_batch_size_);
+  }
+  disk_manager->SetChecksums(disk.checksums_);
+  auto bpm = MakeBufferPool(shards, pool_size, disk_manager.get());
+  auto frame_memory = GetFrameMemory(bpm.get());
   std::vector<page_id_t> page_ids;
+  std::string checksum_kind = "off";
+  if (disk.checksums_) {
+    checksum_kind = bustub::ChecksumUtil::IsHardwareAccelerated() ? "crc32c-hw" : "crc32c-sw";
+  }
 
-  fmt::print(stderr, "[info] total_page={}, duration_ms={}, latency_ms={}, lru_k_size={}, bpm_size={}\n",
-             BUSTUB_PAGE_CNT, duration_ms, latency_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE);
+  fmt::print(stderr,
+             "[info] total_page={}, duration_ms={}, latency_ms={}, lru_k_size={}, bpm_size={}, shards={}, "
+             "prefetch_depth={}, scan_ring={}, frame_memory={}, page_size={}, checksums={}, db_file={}, "
+             "direct_io={}\n",
+             page_cnt, duration_ms, latency_ms, lru_k_size, bpm->GetPoolSize(), shards, prefetch_depth, scan_ring,
+             frame_memory, bustub::BUSTUB_PAGE_SIZE, checksum_kind, disk.db_file_.empty() ? "none" : disk.db_file_,
+             disk_manager->IsDirectIo());
 
-  for (size_t i = 0; i < BUSTUB_PAGE_CNT; i++) {
+  for (size_t i = 0; i < page_cnt; i++) {
     page_id_t page_id;
     auto *page = bpm->NewPage(&page_id);
     if (page == nullptr) {
@@ -150,24 +269,36 @@ auto main(int argc, char **argv) -> int {
   }
 
   // enable disk latency after creating all pages
-  disk_manager->SetLatency(latency_ms);
+  if (memory_disk_manager != nullptr) {
+    memory_disk_manager->SetLatency(latency_ms);
+  }
 
   fmt::print(stderr, "[info] benchmark start\n");
 
+  uint64_t start_hits;
+  uint64_t start_misses;
+  GetFetchCounters(bpm.get(), &start_hits, &start_misses);
+
   BpmTotalMetrics total_metrics;
   total_metrics.Begin();
 
   std::vector<std::thread> threads;
 
   for (size_t thread_id = 0; thread_id < BUSTUB_SCAN_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, page_cnt, duration_ms, prefetch_depth, scan_ring,
+                                      &total_metrics] {
       BpmMetrics metrics(fmt::format("scan {:>2}", thread_id), duration_ms);
       metrics.Begin();
+      bustub::BufferAccessStrategy ring(scan_ring);
+      bustub::BufferAccessStrategy *strategy = scan_ring > 0 ? &ring : nullptr;
 
-      size_t page_idx = BUSTUB_PAGE_CNT * thread_id / BUSTUB_SCAN_THREAD;
+      size_t page_idx = page_cnt * thread_id / BUSTUB_SCAN_THREAD;
 
       while (!metrics.ShouldFinish()) {
-        auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Scan);
+        if (prefetch_depth > 0) {
+          bpm->PrefetchPage(page_ids[(page_idx + prefetch_depth) % page_cnt], strategy);
+        }
+        auto *page = bpm->FetchPage(page_ids[page_idx], strategy);
         if (page == nullptr) {
           continue;
         }
@@ -180,28 +311,29 @@ auto main(int argc, char **argv) -> int {
         }
         page->WUnlatch();
 
-        bpm->UnpinPage(page->GetPageId(), true, AccessType::Scan);
-        page_idx = (page_idx + 1) % BUSTUB_PAGE_CNT;
+        bpm->UnpinPage(page->GetPageId(), true);
+        page_idx = (page_idx + 1) % page_cnt;
         metrics.Tick();
         metrics.Report();
       }
 
       total_metrics.ReportScan(metrics.cnt_);
+      total_metrics.ReportScanHits(ring.GetHits(), ring.GetMisses());
     }));
   }
 
   for (size_t thread_id = 0; thread_id < BUSTUB_GET_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, duration_ms, &total_metrics] {
+    threads.emplace_back(std::thread([thread_id, &page_ids, &bpm, page_cnt, duration_ms, &total_metrics] {
       std::random_device r;
       std::default_random_engine gen(r());
-      zipfian_int_distribution<size_t> dist(0, BUSTUB_PAGE_CNT - 1, 0.8);
+      zipfian_int_distribution<size_t> dist(0, page_cnt - 1, 0.8);
 
       BpmMetrics metrics(fmt::format("get  {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
       while (!metrics.ShouldFinish()) {
         auto page_idx = dist(gen);
-        auto *page = bpm->FetchPage(page_ids[page_idx], AccessType::Get);
+        auto *page = bpm->FetchPage(page_ids[page_idx]);
         if (page == nullptr) {
           continue;
         }
@@ -213,7 +345,7 @@ auto main(int argc, char **argv) -> int {
           throw std::runtime_error("invalid data");
         }
 
-        bpm->UnpinPage(page->GetPageId(), false, AccessType::Get);
+        bpm->UnpinPage(page->GetPageId(), false);
         metrics.Tick();
         metrics.Report();
       }
@@ -226,7 +358,174 @@ auto main(int argc, char **argv) -> int {
     thread.join();
   }
 
-  total_metrics.Report();
+  uint64_t hits;
+  uint64_t misses;
+  GetFetchCounters(bpm.get(), &hits, &misses);
+  total_metrics.Report(shards, scan_ring, frame_memory, hits - start_hits, misses - start_misses);
+
+  // The frames are the memory the buffer pool accounts for; a db file cached by the OS comes on top of them.
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  fmt::print(stderr, "[info] max_rss_kb={}, db_file_cached_kb={}, syncs={}\n", usage.ru_maxrss,
+             disk.db_file_.empty() ? 0 : GetCachedBytes(disk.db_file_) / 1024, disk_manager->GetNumSyncs());
+  bpm.reset();
+  disk_manager->ShutDown();
+  if (!disk.db_file_.empty()) {
+    RemoveDbFile(disk.db_file_);
+  }
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-bpm-bench");
+  program.add_argument("--duration").help("run bpm bench for n milliseconds");
+  program.add_argument("--latency").help("set disk latency to n milliseconds");
+  program.add_argument("--shards").help("comma-separated list of buffer pool shard counts to sweep, e.g. 1,2,4,8,16");
+  program.add_argument("--prefetch").help("scan threads prefetch the page n pages ahead of the one they fetch");
+  program.add_argument("--scan-ring").help("scan threads cycle through a private ring of n frames (0 = off)");
+  program.add_argument("--lru-k").help("k of the LRU-K replacer, default 16");
+  program.add_argument("--frames").help("total number of frames in the buffer pool");
+  program.add_argument("--pages").help("number of pages; --pages equal to --frames keeps every fetch a hit");
+  program.add_argument("--frame-memory").help("memory backing the frames: heap, mmap, thp or hugetlb");
+  program.add_argument("--numa").help("NUMA placement of the frames: default, interleave or bind");
+  program.add_argument("--numa-nodes").help("comma-separated list of NUMA nodes for --numa, default all");
+  program.add_argument("--checksums").help("stamp and verify a CRC32C checksum on every page I/O: on or off");
+  program.add_argument("--db-file").help("keep the pages in this db file instead of in memory; it is removed after");
+  program.add_argument("--direct-io").help("access the db file with O_DIRECT, bypassing the OS page cache: on or off");
+  program.add_argument("--sync").help("when to fdatasync the db file: never, every (write) or batch:n (writes)");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = 30000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoi(program.get("--duration"));
+  }
+
+  uint64_t latency_ms = 0;
+  if (program.present("--latency")) {
+    latency_ms = std::stoi(program.get("--latency"));
+  }
+
+  std::vector<size_t> shard_counts{1};
+  if (program.present("--shards")) {
+    shard_counts.clear();
+    for (const auto &shards : bustub::StringUtil::Split(program.get("--shards"), ',')) {
+      shard_counts.push_back(std::stoul(shards));
+    }
+  }
+
+  size_t prefetch_depth = 0;
+  if (program.present("--prefetch")) {
+    prefetch_depth = std::stoul(program.get("--prefetch"));
+  }
+
+  size_t scan_ring = 0;
+  if (program.present("--scan-ring")) {
+    scan_ring = std::stoul(program.get("--scan-ring"));
+  }
+
+  if (program.present("--lru-k")) {
+    lru_k_size = std::stoul(program.get("--lru-k"));
+  }
+
+  size_t pool_size = BUSTUB_BPM_SIZE;
+  if (program.present("--frames")) {
+    pool_size = std::stoul(program.get("--frames"));
+  }
+
+  size_t page_cnt = BUSTUB_PAGE_CNT;
+  if (program.present("--pages")) {
+    page_cnt = std::stoul(program.get("--pages"));
+  }
+
+  if (program.present("--frame-memory")) {
+    auto memory = program.get("--frame-memory");
+    if (memory == "heap") {
+      bustub::frame_memory = bustub::FrameMemory::HEAP;
+    } else if (memory == "mmap") {
+      bustub::frame_memory = bustub::FrameMemory::MMAP;
+    } else if (memory == "thp") {
+      bustub::frame_memory = bustub::FrameMemory::TRANSPARENT_HUGE_PAGES;
+    } else if (memory == "hugetlb") {
+      bustub::frame_memory = bustub::FrameMemory::EXPLICIT_HUGE_PAGES;
+    } else {
+      std::cerr << "unknown --frame-memory " << memory << std::endl;
+      return 1;
+    }
+  }
+
+  if (program.present("--numa")) {
+    auto numa = program.get("--numa");
+    if (numa == "default") {
+      bustub::frame_numa_policy = bustub::FrameNumaPolicy::DEFAULT;
+    } else if (numa == "interleave") {
+      bustub::frame_numa_policy = bustub::FrameNumaPolicy::INTERLEAVE;
+    } else if (numa == "bind") {
+      bustub::frame_numa_policy = bustub::FrameNumaPolicy::BIND;
+    } else {
+      std::cerr << "unknown --numa " << numa << std::endl;
+      return 1;
+    }
+  }
+
+  if (program.present("--numa-nodes")) {
+    for (const auto &node : bustub::StringUtil::Split(program.get("--numa-nodes"), ',')) {
+      bustub::frame_numa_nodes |= uint64_t{1} << std::stoul(node);
+    }
+  }
+
+  DiskOptions disk;
+  if (program.present("--checksums")) {
+    auto enable = program.get("--checksums");
+    if (enable != "on" && enable != "off") {
+      std::cerr << "unknown --checksums " << enable << std::endl;
+      return 1;
+    }
+    disk.checksums_ = enable == "on";
+  }
+
+  if (program.present("--db-file")) {
+    disk.db_file_ = program.get("--db-file");
+  }
+
+  if (program.present("--direct-io")) {
+    auto enable = program.get("--direct-io");
+    if (enable != "on" && enable != "off") {
+      std::cerr << "unknown --direct-io " << enable << std::endl;
+      return 1;
+    }
+    disk.direct_io_ = enable == "on";
+  }
+
+  if (program.present("--sync")) {
+    auto sync = program.get("--sync");
+    if (sync == "never") {
+      disk.sync_policy_ = bustub::SyncPolicy::NEVER;
+    } else if (sync == "every") {
+      disk.sync_policy_ = bustub::SyncPolicy::EVERY_WRITE;
+    } else if (sync.rfind("batch:", 0) == 0) {
+      disk.sync_policy_ = bustub::SyncPolicy::BATCH;
+      disk.sync_batch_size_ = std::stoul(sync.substr(6));
+    } else {
+      std::cerr << "unknown --sync " << sync << std::endl;
+      return 1;
+    }
+  }
+
+  if ((disk.direct_io_ || disk.sync_policy_ != bustub::SyncPolicy::NEVER) && disk.db_file_.empty()) {
+    std::cerr << "--direct-io and --sync need a --db-file" << std::endl;
+    return 1;
+  }
+
+  for (auto shards : shard_counts) {
+    RunBench(shards, pool_size, page_cnt, duration_ms, latency_ms, prefetch_depth, scan_ring, disk);
+  }
 
   return 0;
 }
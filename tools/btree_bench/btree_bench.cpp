@@ -12,7 +12,7 @@
 
 #include "argparse/argparse.hpp"
 #include "binder/binder.h"
-#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "buffer/lru_k_replacer.h"
 #include "common/config.h"
 #include "common/exception.h"
@@ -25,6 +25,9 @@
 #include "test_util.h"
 
 #include <sys/time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
 
 auto ClockMs() -> uint64_t {
   struct timeval tm;
@@ -32,8 +35,17 @@ auto ClockMs() -> uint64_t {
   return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
 }
 
-static const size_t BUSTUB_READ_THREAD = 4;
-static const size_t BUSTUB_WRITE_THREAD = 2;
+// Time stamp counter for timing single lookups. It ticks at the nominal clock rate of the cpu, so these are reference
+// cycles; elsewhere nanoseconds stand in for them.
+auto ClockCycles() -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+#endif
+}
+
 static const size_t LRU_K_SIZE = 4;
 static const size_t BUSTUB_BPM_SIZE = 256;
 static const size_t TOTAL_KEYS = 100000;
@@ -42,6 +54,7 @@ static const size_t KEY_MODIFY_RANGE = 2048;
 struct BTreeTotalMetrics {
   uint64_t write_cnt_{0};
   uint64_t read_cnt_{0};
+  uint64_t read_cycles_{0};
   uint64_t start_time_{0};
   std::mutex mutex_;
 
@@ -52,9 +65,10 @@ struct BTreeTotalMetrics {
     write_cnt_ += scan_cnt;
   }
 
-  void ReportRead(uint64_t get_cnt) {
+  void ReportRead(uint64_t get_cnt, uint64_t get_cycles) {
     std::unique_lock<std::mutex> l(mutex_);
     read_cnt_ += get_cnt;
+    read_cycles_ += get_cycles;
   }
 
   void Report() {
@@ -66,6 +80,9 @@ struct BTreeTotalMetrics {
     fmt::print("<<< BEGIN\n");
     fmt::print("write: {}\n", write_per_sec);
     fmt::print("read: {}\n", read_per_sec);
+    if (read_cnt_ > 0) {
+      fmt::print("read_cycles_per_lookup: {}\n", read_cycles_ / static_cast<double>(read_cnt_));
+    }
     fmt::print(">>> END\n");
   }
 };
@@ -112,13 +129,14 @@ auto KeyWillChange(size_t key) -> bool { return key % 5 == 0; }
 
 // NOLINTNEXTLINE
 auto main(int argc, char **argv) -> int {
-  using bustub::AccessType;
-  using bustub::BufferPoolManager;
+  using bustub::BufferPoolManagerInstance;
   using bustub::DiskManagerUnlimitedMemory;
   using bustub::page_id_t;
 
   argparse::ArgumentParser program("bustub-btree-bench");
   program.add_argument("--duration").help("run btree bench for n milliseconds");
+  program.add_argument("--read-threads").help("number of threads running point lookups");
+  program.add_argument("--write-threads").help("number of threads inserting and removing keys");
 
   try {
     program.parse_args(argc, argv);
@@ -133,20 +151,35 @@ auto main(int argc, char **argv) -> int {
     duration_ms = std::stoi(program.get("--duration"));
   }
 
+  size_t read_threads = 4;
+  if (program.present("--read-threads")) {
+    read_threads = std::stoul(program.get("--read-threads"));
+  }
+
+  size_t write_threads = 2;
+  if (program.present("--write-threads")) {
+    write_threads = std::stoul(program.get("--write-threads"));
+  }
+
   auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
-  auto bpm = std::make_unique<BufferPoolManager>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(BUSTUB_BPM_SIZE, disk_manager.get(), LRU_K_SIZE);
 
-  fmt::print(stderr, "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}\n", TOTAL_KEYS, duration_ms,
-             LRU_K_SIZE, BUSTUB_BPM_SIZE);
+  fmt::print(stderr,
+             "[info] total_keys={}, duration_ms={}, lru_k_size={}, bpm_size={}, read_threads={}, write_threads={}, "
+             "page_size={}\n",
+             TOTAL_KEYS, duration_ms, LRU_K_SIZE, BUSTUB_BPM_SIZE, read_threads, write_threads,
+             bustub::BUSTUB_PAGE_SIZE);
 
   auto key_schema = bustub::ParseCreateStatement("a bigint");
   bustub::GenericComparator<8> comparator(key_schema.get());
 
+  // The tree records its root in the header page, which must be page 0.
   page_id_t page_id;
-  auto header_page = bpm->NewPageGuarded(&page_id);
+  bpm->NewPage(&page_id);
+  bpm->UnpinPage(page_id, true);
 
-  bustub::BPlusTree<bustub::GenericKey<8>, bustub::RID, bustub::GenericComparator<8>> index("foo_pk", page_id,
-                                                                                            bpm.get(), comparator);
+  bustub::BPlusTree<bustub::GenericKey<8>, bustub::RID, bustub::GenericComparator<8>> index("foo_pk", bpm.get(),
+                                                                                            comparator);
 
   for (size_t key = 0; key < TOTAL_KEYS; key++) {
     bustub::GenericKey<8> index_key;
@@ -164,19 +197,20 @@ auto main(int argc, char **argv) -> int {
 
   std::vector<std::thread> threads;
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_READ_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &index, duration_ms, &total_metrics] {
+  for (size_t thread_id = 0; thread_id < read_threads; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, read_threads, &index, duration_ms, &total_metrics] {
       BTreeMetrics metrics(fmt::format("read  {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
-      size_t key_start = TOTAL_KEYS / BUSTUB_READ_THREAD * thread_id;
-      size_t key_end = TOTAL_KEYS / BUSTUB_READ_THREAD * (thread_id + 1);
+      size_t key_start = TOTAL_KEYS / read_threads * thread_id;
+      size_t key_end = TOTAL_KEYS / read_threads * (thread_id + 1);
       std::random_device r;
       std::default_random_engine gen(r());
       std::uniform_int_distribution<size_t> dis(key_start, key_end - 1);
 
       bustub::GenericKey<8> index_key;
       std::vector<bustub::RID> rids;
+      uint64_t cycles = 0;
 
       while (!metrics.ShouldFinish()) {
         auto base_key = dis(gen);
@@ -184,7 +218,9 @@ auto main(int argc, char **argv) -> int {
         for (auto key = base_key; key < key_end && cnt < KEY_MODIFY_RANGE; key++, cnt++) {
           rids.clear();
           index_key.SetFromInteger(key);
+          auto begin = ClockCycles();
           index.GetValue(index_key, &rids);
+          cycles += ClockCycles() - begin;
 
           if (!KeyWillVanish(key) && rids.empty()) {
             std::string msg = fmt::format("key not found: {}", key);
@@ -206,17 +242,17 @@ auto main(int argc, char **argv) -> int {
         }
       }
 
-      total_metrics.ReportRead(metrics.cnt_);
+      total_metrics.ReportRead(metrics.cnt_, cycles);
     }));
   }
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_WRITE_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &index, duration_ms, &total_metrics] {
+  for (size_t thread_id = 0; thread_id < write_threads; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, write_threads, &index, duration_ms, &total_metrics] {
       BTreeMetrics metrics(fmt::format("write {:>2}", thread_id), duration_ms);
       metrics.Begin();
 
-      size_t key_start = TOTAL_KEYS / BUSTUB_WRITE_THREAD * thread_id;
-      size_t key_end = TOTAL_KEYS / BUSTUB_WRITE_THREAD * (thread_id + 1);
+      size_t key_start = TOTAL_KEYS / write_threads * thread_id;
+      size_t key_end = TOTAL_KEYS / write_threads * (thread_id + 1);
       std::random_device r;
       std::default_random_engine gen(r());
       std::uniform_int_distribution<size_t> dis(key_start, key_end - 1);
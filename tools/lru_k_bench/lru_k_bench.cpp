@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/lru_k_replacer.h"
+#include "common/config.h"
+#include "common/util/string_util.h"
+#include "fmt/core.h"
+
+/**
+ * Drive a replacer the way a buffer pool under load does: most frames are pinned, and every operation evicts a frame,
+ * records an access to the page read into it and pins it, records a hit on another pinned frame, and unpins a random
+ * pinned frame. The number of evictable frames stays constant, so the cost of Evict() is not hidden by an empty
+ * replacer.
+ */
+void RunBench(size_t num_frames, size_t k, double pinned_ratio, uint64_t max_ops, uint64_t duration_ms) {
+  using bustub::frame_id_t;
+
+  bustub::LRUKReplacer replacer(num_frames, k);
+  std::mt19937_64 gen(42);
+
+  std::vector<frame_id_t> pinned;
+  pinned.reserve(num_frames);
+  for (size_t i = 0; i < num_frames; ++i) {
+    auto fid = static_cast<frame_id_t>(i);
+    replacer.RecordAccess(fid);
+    replacer.SetEvictable(fid, false);
+    pinned.push_back(fid);
+  }
+  std::shuffle(pinned.begin(), pinned.end(), gen);
+  auto num_evictable = std::max<size_t>(1, static_cast<size_t>(static_cast<double>(num_frames) * (1 - pinned_ratio)));
+  for (size_t i = 0; i < num_evictable && !pinned.empty(); ++i) {
+    replacer.SetEvictable(pinned.back(), true);
+    pinned.pop_back();
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto deadline = start + std::chrono::milliseconds(duration_ms);
+  uint64_t ops = 0;
+  while (ops < max_ops) {
+    // Checking the clock on every operation would dominate the cheap replacer calls.
+    if (ops % 1024 == 0 && std::chrono::steady_clock::now() > deadline) {
+      break;
+    }
+    frame_id_t victim;
+    if (!replacer.Evict(&victim)) {
+      throw std::runtime_error("evict failed");
+    }
+    replacer.RecordAccess(victim);
+    replacer.SetEvictable(victim, false);
+    pinned.push_back(victim);
+
+    std::uniform_int_distribution<size_t> dist(0, pinned.size() - 1);
+    replacer.RecordAccess(pinned[dist(gen)]);
+    auto idx = dist(gen);
+    replacer.SetEvictable(pinned[idx], true);
+    std::swap(pinned[idx], pinned.back());
+    pinned.pop_back();
+    ++ops;
+  }
+  auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  fmt::print("<<< BEGIN\n");
+  fmt::print("frames: {}\n", num_frames);
+  fmt::print("k: {}\n", k);
+  fmt::print("pinned_ratio: {}\n", pinned_ratio);
+  fmt::print("ops: {}\n", ops);
+  fmt::print("ops_per_sec: {:.0f}\n", static_cast<double>(ops) / elapsed);
+  fmt::print(">>> END\n");
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-lru-k-bench");
+  program.add_argument("--frames").help("comma-separated list of pool sizes to sweep, e.g. 1000,10000,100000,1000000");
+  program.add_argument("--k").help("lookback constant of the replacer");
+  program.add_argument("--pinned").help("fraction of frames that are pinned, e.g. 0.9");
+  program.add_argument("--ops").help("number of operations per pool size");
+  program.add_argument("--duration").help("stop a pool size after n milliseconds even if --ops is not reached");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  std::vector<size_t> frame_counts{1000, 10000, 100000, 1000000};
+  if (program.present("--frames")) {
+    frame_counts.clear();
+    for (const auto &frames : bustub::StringUtil::Split(program.get("--frames"), ',')) {
+      frame_counts.push_back(std::stoul(frames));
+    }
+  }
+
+  size_t k = bustub::LRUK_REPLACER_K;
+  if (program.present("--k")) {
+    k = std::stoul(program.get("--k"));
+  }
+
+  double pinned_ratio = 0.9;
+  if (program.present("--pinned")) {
+    pinned_ratio = std::stod(program.get("--pinned"));
+  }
+
+  uint64_t max_ops = 1000000;
+  if (program.present("--ops")) {
+    max_ops = std::stoull(program.get("--ops"));
+  }
+
+  uint64_t duration_ms = 5000;
+  if (program.present("--duration")) {
+    duration_ms = std::stoull(program.get("--duration"));
+  }
+
+  for (auto num_frames : frame_counts) {
+    RunBench(num_frames, k, pinned_ratio, max_ops, duration_ms);
+  }
+
+  return 0;
+}
@@ -10,6 +10,7 @@
 
 #include "argparse/argparse.hpp"
 #include "binder/binder.h"
+#include "buffer/buffer_pool_manager_instance.h"
 #include "common/bustub_instance.h"
 #include "common/exception.h"
 #include "common/util/string_util.h"
@@ -120,6 +121,7 @@ auto main(int argc, char **argv) -> int {
   program.add_argument("--duration").help("run terrier bench for n milliseconds");
   program.add_argument("--force-create-index").help("create index in terrier bench");
   program.add_argument("--force-enable-update").help("use update statement in terrier bench");
+  program.add_argument("--page-cleaner").help("run a background page cleaner for the buffer pool");
 
   try {
     program.parse_args(argc, argv);
@@ -129,6 +131,11 @@ auto main(int argc, char **argv) -> int {
     return 1;
   }
 
+  if (program.present("--page-cleaner")) {
+    bustub::enable_page_cleaner = ParseBool(program.get("--page-cleaner"));
+  }
+  std::cerr << "x: page cleaner " << (bustub::enable_page_cleaner ? "enabled" : "disabled") << std::endl;
+
   auto bustub = std::make_unique<bustub::BustubInstance>();
   auto writer = bustub::SimpleStreamWriter(std::cerr);
 
@@ -360,5 +367,10 @@ auto main(int argc, char **argv) -> int {
 
   total_metrics.Report();
 
+  if (auto *bpm = dynamic_cast<bustub::BufferPoolManagerInstance *>(bustub->buffer_pool_manager_); bpm != nullptr) {
+    fmt::print(stderr, "x: foreground_writes={} background_writes={}\n", bpm->GetForegroundWrites(),
+               bpm->GetBackgroundWrites());
+  }
+
   return 0;
 }